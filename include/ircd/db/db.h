@@ -22,6 +22,7 @@ namespace ircd::db
 	struct row;
 	struct column;
 	struct index;
+	struct txn;
 	struct database;
 	struct options;
 
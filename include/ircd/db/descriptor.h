@@ -115,4 +115,11 @@ struct ircd::db::descriptor
 		{      0L,  15L }, // max_bytes_for_level[5]
 		{      0L,  31L }, // max_bytes_for_level[6]
 	};
+
+	/// Serve reads of this column's table files from a memory map when the
+	/// pages are resident; this avoids a syscall and a copy for each block
+	/// cache miss. Pages which are not resident are still read through AIO
+	/// so the ctx is never blocked by a major fault. Best for hosts where the
+	/// column fits in RAM; has no effect when reads use direct IO.
+	bool mmap_reads { false };
 };
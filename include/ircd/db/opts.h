@@ -57,6 +57,8 @@ enum class ircd::db::get
 	NO_PARALLEL      = 0x0200, ///< Don't submit requests in parallel (relevant to db::row).
 	THROW            = 0x0400, ///< Throw exceptions more than usual.
 	NO_THROW         = 0x0800, ///< Suppress exceptions if possible.
+	PRIO_LOW         = 0x1000, ///< Mark for low priority behavior (bulk prefetch).
+	PRIO_HIGH        = 0x2000, ///< Mark for high priority behavior (interactive prefetch).
 };
 
 template<class T>
@@ -22,12 +22,22 @@ struct ircd::db::prefetcher
 	struct request;
 	using closure = std::function<bool (request &)>;
 
+	static conf::item<milliseconds> expire;
+	static ircd::stats::histogram queue_latency;
+	static ircd::stats::histogram fetch_latency;
+
 	ctx::dock dock;
-	std::deque<request> queue;
+	std::array<std::deque<request>, 3> queue;         // by request::prio
+	std::unordered_map<size_t, request *> pending;    // queued or in flight
 	std::unique_ptr<ticker> ticker;
 	ctx::context context;
 	size_t request_workers {0};
 
+	static size_t pending_key(const database &, const uint32_t &cid, const string_view &key) noexcept;
+	request *pending_find(database &, const column &, const string_view &key) noexcept;
+	void pending_erase(request &) noexcept;
+	bool request_expired(const request &, const steady_point &) const noexcept;
+	request *request_next() noexcept;
 	size_t wait_pending();
 	void request_handle(request &);
 	size_t request_cleanup() noexcept;
@@ -36,9 +46,12 @@ struct ircd::db::prefetcher
 	void worker();
 
   public:
+	size_t queued() const noexcept;   // Requests in all queues (incl. finished)
+
 	size_t cancel(const closure &);
 	size_t cancel(database &);         // Cancel all for db
 	size_t cancel(column &);           // Cancel all for column
+	size_t cancel(column &, const string_view &key);
 
 	bool operator()(column &, const string_view &key, const gopts &);
 
@@ -54,11 +67,12 @@ struct ircd::db::prefetcher::request
 	steady_point snd;                  // submitted by user
 	steady_point req;                  // request sent to database
 	steady_point fin;                  // result from database
+	uint8_t prio {1};                  // queue index; 0 is highest priority
 	char key[208] alignas(16);         // key buffer
 
 	explicit operator string_view() const noexcept;
 
-	request(database &d, const column &c, const string_view &key) noexcept;
+	request(database &d, const column &c, const string_view &key, const uint8_t &prio = 1) noexcept;
 	request() = default;
 };
 
@@ -80,6 +94,11 @@ struct ircd::db::prefetcher::ticker
 	size_t fetches {0};       ///< Incremented before actual database operation
 	size_t fetched {0};       ///< Incremented after actual database operation
 	size_t cancels {0};       ///< Count of canceled operations
+	size_t coalesced {0};     ///< Queries joined to a request already pending
+	size_t promoted {0};      ///< Pending requests requeued at a higher priority
+	size_t expires {0};       ///< Requests dropped for waiting beyond the expiry
+	size_t prio_high {0};     ///< Requests added to the high priority queue
+	size_t prio_low {0};      ///< Requests added to the low priority queue
 
 	// throughput totals
 	size_t fetched_bytes_key {0};      ///< Total bytes of key data received
@@ -15,6 +15,7 @@ struct ircd::db::database::sst
 {
 	struct info;
 	struct dump;
+	struct ingest;
 
 	static void tool(const vector_view<const string_view> &args);
 };
@@ -84,3 +85,21 @@ struct ircd::db::database::sst::dump
 	dump(dump &&) = delete;
 	dump(const dump &) = delete;
 };
+
+/// Write the contents of a transaction into sorted SST files, one for each
+/// column in the transaction, and ingest those files directly into the
+/// database. This bypasses the memtable and the WAL entirely; it is intended
+/// for bulk loading. When a key appears more than once in the transaction
+/// the last update wins; for that reason a transaction containing merge
+/// operands is refused.
+///
+struct ircd::db::database::sst::ingest
+{
+	size_t files {0};
+	size_t entries {0};
+	size_t bytes {0};
+
+	ingest(const txn &, const string_view &dir = {});
+	ingest(ingest &&) = delete;
+	ingest(const ingest &) = delete;
+};
@@ -30,6 +30,26 @@ namespace ircd::fmt
 	using arg = std::tuple<const void *, const std::type_index &>;
 }
 
+namespace ircd::conf
+{
+	template<class T> struct item;
+}
+
+/// Format strings are parsed once into a program of literal text runs and
+/// resolved specifier handlers; subsequent formats with the same string
+/// execute that program without reparsing. Programs are cached per thread,
+/// keyed by the address of the format string and confirmed by its content,
+/// so literals hit the cache while dynamic formats which do not match fall
+/// back to the parser. A thread's cache is emptied when it reaches max.
+namespace ircd::fmt::cache
+{
+	extern conf::item<bool> enable;
+	extern conf::item<size_t> max;
+
+	size_t count();
+	void clear();
+}
+
 /// Typesafe snprintf() from formal grammar and RTTI.
 ///
 /// This function accepts a format string and a variable number of arguments
@@ -42,6 +42,14 @@ namespace ircd::fs::iou
 	extern conf::item<bool> enable;
 	extern conf::item<size_t> max_events;
 	extern conf::item<size_t> max_submit;
+	extern conf::item<bool> submit_coalesce;
+	extern conf::item<bool> sqpoll_enable;
+	extern conf::item<milliseconds> sqpoll_idle;
+	extern conf::item<bool> buffers_enable;
+	extern conf::item<size_t> buffers_count;
+	extern conf::item<size_t> buffers_size;
+	extern conf::item<bool> files_enable;
+	extern conf::item<size_t> files_max;
 
 	// runtime state
 	extern struct stats stats;
@@ -63,19 +71,6 @@ namespace ircd::fs::iou
 	static size_t count(const op &);
 }
 
-struct ircd::fs::iou::request
-{
-	const fs::opts *opts {nullptr};
-	fs::op op {fs::op::NOOP};
-	std::error_code ec;
-	int32_t res {-1};
-	int32_t id {-1};
-
-	request() = default;
-	request(const fd &, const const_iovec_view &, const fs::opts *const &);
-	~request() noexcept;
-};
-
 /// Enumeration of states for a request.
 enum ircd::fs::iou::state
 :uint8_t
@@ -92,6 +87,14 @@ enum ircd::fs::iou::state
 struct ircd::fs::iou::stats
 :aio::stats
 {
+	uint64_t enters {0};               ///< count of io_uring_enter calls
+	uint64_t wakeups {0};              ///< count of SQPOLL thread wakeups
+	uint64_t fixed_reads {0};          ///< reads through a registered buffer
+	uint64_t fixed_misses {0};         ///< eligible reads with no free buffer
+	uint64_t fixed_files {0};          ///< requests on a registered file
+	uint64_t file_registers {0};       ///< files added to the registered table
+	uint64_t file_unregisters {0};     ///< files removed from the table
+
 	using aio::stats::stats;
 };
 
@@ -30,6 +30,9 @@ namespace ircd::fs
 	// Test whether bytes in the specified range are cached and should not block
 	bool fincore(const fd &, const size_t &, const read_opts & = read_opts_default);
 
+	// Test whether the pages under an existing memory map are all resident
+	bool fincore(const const_buffer &map);
+
 	// Prefetch data for subsequent read(); offset given in opts (WILLNEED).
 	size_t prefetch(const fd &, const size_t &, const read_opts & = read_opts_default);
 
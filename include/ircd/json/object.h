@@ -64,6 +64,7 @@ struct ircd::json::object
 {
 	struct member;
 	struct const_iterator;
+	struct index;
 
 	using key_type = string_view;
 	using mapped_type = string_view;
@@ -182,6 +183,110 @@ struct ircd::json::object::const_iterator
 	const_iterator() = default;
 };
 
+/// Indexed view of a JSON object for repeated member lookups.
+///
+/// Every lookup on a json::object parses the JSON text from the beginning
+/// until the key is found. This is ideal for one or two lookups, but a
+/// function making several lookups on the same object pays for the parse
+/// several times over. This device conducts a single pass over the object
+/// upon construction, recording a string_view of each member (still zero-
+/// copy into the original text) along with the hash of its key. Lookups are
+/// then answered with a binary search over the hashes followed by a key
+/// comparison to confirm the match.
+///
+/// The members are recorded into a small array inline with this object, so
+/// typical objects do not allocate. Larger objects fall back to an arena
+/// allocation. The original JSON text must outlive this index. This index
+/// cannot be copied or moved; construct it on the stack where it is used.
+///
+/// In the case of duplicate keys, the first member is found, consistent with
+/// json::object::find().
+///
+struct ircd::json::object::index
+{
+	static constexpr const size_t INLINE_MAX {16};
+
+	struct slot
+	{
+		name_hash_t hash;
+		size_t pos;
+	};
+
+	json::object object;
+	size_t _count {0};
+	member _member[INLINE_MAX];
+	slot _slot[INLINE_MAX];
+	std::unique_ptr<member[]> member_arena;
+	std::unique_ptr<slot[]> slot_arena;
+	member *members {_member};
+	slot *slots {_slot};
+
+  public:
+	// members in their original order
+	const member *begin() const                  { return members;                                 }
+	const member *end() const                    { return members + _count;                        }
+	size_t count() const                         { return _count;                                  }
+	bool empty() const                           { return !_count;                                 }
+	explicit operator const json::object &() const { return object;                                }
+
+	const member *find(const string_view &key) const;
+	bool has(const string_view &key) const;
+
+	// returns value or default
+	template<class T> T get(const string_view &key, const T &def = T{}) const;
+	string_view get(const string_view &key, const string_view &def = {}) const;
+
+	// returns value or throws not_found
+	template<class T = string_view> T at(const string_view &key) const;
+
+	// returns value or empty
+	string_view operator[](const string_view &key) const;
+
+	index(const json::object &);
+	index(index &&) = delete;
+	index(const index &) = delete;
+	index &operator=(index &&) = delete;
+	index &operator=(const index &) = delete;
+};
+
+template<class T>
+T
+ircd::json::object::index::at(const string_view &key)
+const try
+{
+	const auto *const member(find(key));
+	if(!member)
+		throw not_found
+		{
+			"'%s'", key
+		};
+
+	return lex_cast<T>(member->second);
+}
+catch(const bad_lex_cast &e)
+{
+	throw type_error
+	{
+		"'%s' must cast to type %s",
+		key,
+		typeid(T).name()
+	};
+}
+
+template<class T>
+T
+ircd::json::object::index::get(const string_view &key,
+                               const T &def)
+const try
+{
+	const string_view sv(operator[](key));
+	return !sv.empty()? lex_cast<T>(sv) : def;
+}
+catch(const bad_lex_cast &e)
+{
+	return def;
+}
+
 template<ircd::json::name_hash_t key,
          class T>
 T
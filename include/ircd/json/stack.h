@@ -96,6 +96,10 @@ struct ircd::json::stack
 /// object or array be constructed under its scope as its value, or a
 /// json::value / already strung JSON must be appended as its value.
 ///
+/// splice() copies already strung JSON to the output verbatim; unlike a
+/// serial json::value it is not re-printed, thus the input is trusted to be
+/// valid (i.e. it came from our own database).
+///
 /// If the value is supplied in the constructor argument an instance of
 /// this class does not have to be held (use constructor as function).
 ///
@@ -114,6 +118,7 @@ struct ircd::json::stack::member
   public:
 	template<class... T> void append(const json::tuple<T...> &);
 	void append(const json::value &);
+	void splice(const string_view &json);
 
 	member(object &po, const string_view &name);
 	member(stack &s, const string_view &name);
@@ -196,6 +201,7 @@ struct ircd::json::stack::array
   public:
 	template<class... T> void append(const json::tuple<T...> &);
 	void append(const json::value &);
+	void splice(const string_view &json);
 
 	array(member &pm);                 ///< Array is value of the named member
 	array(array &pa);                  ///< Array is value in the array
@@ -21,6 +21,14 @@ namespace ircd::json
 	// note: in is a json::string and return is a const_buffer to force
 	// explicit conversions because this operation generates binary data.
 	const_buffer unescape(const mutable_buffer &out, const string &in);
+
+	// Size of the input after escape(); does not include surrounding quotes.
+	size_t escaped_size(const string_view &in) noexcept;
+
+	// Bulk scan for the first quote, escape or control character in the
+	// range (or stop if the range is clean). Vectorized where available;
+	// used for validating string bodies and copying clean runs when escaping.
+	const char *string_scan(const char *start, const char *stop) noexcept;
 }
 
 /// Strong type representing quoted strings in JSON (which may be unquoted
@@ -82,10 +82,13 @@ noexcept
 	return equal? i : indexof<tuple, i + 1>(name);
 }
 
+/// Linear scan translating a runtime name into the index of the property
+/// in the tuple. This is the reference implementation for the runtime
+/// indexof() below, which should be preferred.
 template<class tuple,
          size_t i>
 constexpr typename std::enable_if<i == size<tuple>(), size_t>::type
-indexof(const string_view &name)
+indexof_scan(const string_view &name)
 noexcept
 {
 	return size<tuple>();
@@ -94,7 +97,7 @@ noexcept
 template<class tuple,
          size_t i = 0>
 constexpr typename std::enable_if<i < size<tuple>(), size_t>::type
-indexof(const string_view &name)
+indexof_scan(const string_view &name)
 noexcept
 {
 	const auto equal
@@ -102,7 +105,175 @@ noexcept
 		name == key<tuple, i>()
 	};
 
-	return equal? i : indexof<tuple, i + 1>(name);
+	return equal? i : indexof_scan<tuple, i + 1>(name);
+}
+
+/// Parameters for the perfect hash of a tuple's property names. The size is
+/// a power of two; a size of zero indicates no perfect hash could be found.
+struct _perfect_hash_param
+{
+	size_t size {0};
+	uint32_t seed {0};
+};
+
+/// FNV-1a with a seed. This must be suitable both for constexpr evaluation
+/// over the property names and for runtime evaluation over input keys.
+constexpr uint32_t
+_perfect_hash(const string_view &name,
+              const uint32_t &seed)
+noexcept
+{
+	uint32_t ret
+	{
+		2166136261U ^ seed
+	};
+
+	for(size_t i(0); i < name.size(); ++i)
+		ret = (ret ^ uint8_t(name[i])) * 16777619U;
+
+	return ret;
+}
+
+/// Searches for a seed under which all property names of the tuple hash into
+/// distinct slots of the smallest table possible. The table size starts at
+/// the power of two at least twice the number of properties and is grown if
+/// no seed is found within the attempt budget.
+template<class tuple>
+constexpr _perfect_hash_param
+_perfect_hash_search()
+noexcept
+{
+	constexpr size_t max_size(1024), max_seeds(2048);
+	static_assert(size<tuple>() < 255);
+
+	size_t table_size(1);
+	while(table_size < size<tuple>() * 2)
+		table_size <<= 1;
+
+	for(; table_size <= max_size; table_size <<= 1)
+		for(uint32_t seed(0); seed < max_seeds; ++seed)
+		{
+			uint64_t used[max_size / 64] {0};
+			bool collision {false};
+			for(size_t i(0); i < size<tuple>() && !collision; ++i)
+			{
+				const size_t slot
+				{
+					_perfect_hash(key<tuple>(i), seed) & (table_size - 1)
+				};
+
+				const uint64_t bit
+				{
+					1UL << (slot % 64)
+				};
+
+				collision = used[slot / 64] & bit;
+				used[slot / 64] |= bit;
+			}
+
+			if(!collision)
+				return { table_size, seed };
+		}
+
+	return {};
+}
+
+template<class tuple>
+constexpr _perfect_hash_param
+_perfect_hash_params
+{
+	_perfect_hash_search<tuple>()
+};
+
+/// The table maps a slot to the property index plus one; zero is vacant.
+template<class tuple>
+constexpr std::array<uint8_t, _perfect_hash_params<tuple>.size>
+_perfect_hash_build()
+noexcept
+{
+	constexpr auto &param
+	{
+		_perfect_hash_params<tuple>
+	};
+
+	std::array<uint8_t, param.size> ret {0};
+	for(size_t i(0); i < size<tuple>(); ++i)
+	{
+		const size_t slot
+		{
+			_perfect_hash(key<tuple>(i), param.seed) & (param.size - 1)
+		};
+
+		ret[slot] = i + 1;
+	}
+
+	return ret;
+}
+
+template<class tuple>
+constexpr std::array<uint8_t, _perfect_hash_params<tuple>.size>
+_perfect_hash_table
+{
+	_perfect_hash_build<tuple>()
+};
+
+/// Property names as string_view's so their length is not recomputed when
+/// confirming the result of the hash.
+template<class tuple,
+         size_t... i>
+constexpr std::array<string_view, size<tuple>()>
+_make_perfect_hash_keys(std::index_sequence<i...>)
+noexcept
+{
+	return {{ key<tuple, i>()... }};
+}
+
+template<class tuple>
+constexpr std::array<string_view, size<tuple>()>
+_perfect_hash_keys
+{
+	_make_perfect_hash_keys<tuple>(std::make_index_sequence<size<tuple>()>())
+};
+
+/// Translate a runtime name into the index of the property in the tuple;
+/// returns size<tuple>() when the name is not a property of the tuple. This
+/// is O(1): the name is hashed once into a compile-time generated perfect
+/// hash table, and the single candidate it yields is confirmed with
+/// one comparison.
+template<class tuple>
+constexpr size_t
+indexof(const string_view &name)
+noexcept
+{
+	constexpr auto &param
+	{
+		_perfect_hash_params<tuple>
+	};
+
+	static_assert
+	(
+		param.size > 0, "No perfect hash for the property names of this tuple."
+	);
+
+	const size_t slot
+	{
+		_perfect_hash(name, param.seed) & (param.size - 1)
+	};
+
+	const uint8_t pos
+	{
+		_perfect_hash_table<tuple>[slot]
+	};
+
+	if(!pos)
+		return size<tuple>();
+
+	const auto &prop
+	{
+		_perfect_hash_keys<tuple>[pos - 1]
+	};
+
+	return name == prop? pos - 1 : size<tuple>();
 }
 
 } // namespace json
@@ -51,10 +51,12 @@ namespace ircd::m::dbs::appendix
 #include "event_sender.h"           // sender | event_idx || hostpart | localpart, event_idx
 #include "event_type.h"             // type | event_idx
 #include "room_events.h"            // room_id | depth, event_idx
+#include "room_type.h"              // room_id | type, depth, event_idx
 #include "room_state.h"             // room_id | type, state_key => event_idx
 #include "room_state_space.h"       // room_id | type, state_key, depth, event_idx
 #include "room_joined.h"            // room_id | origin, member => event_idx
 #include "room_head.h"              // room_id | event_id => event_idx
+#include "user_dir.h"               // token | user_id, room_id => event_idx
 
 /// Options that affect the dbs::write() of an event to the transaction.
 struct ircd::m::dbs::write_opts
@@ -178,6 +180,17 @@ enum ircd::m::dbs::appendix::index
 
 	/// Take branch to handle room redaction events.
 	ROOM_REDACT,
+
+	/// Involves room_type table; the timeline of a room partitioned by
+	/// event type. Events written before this index existed are only found
+	/// after a rebuild (see m::room::type).
+	ROOM_TYPE,
+
+	/// Involves user_dir table; search tokens of the localpart and display
+	/// name of joined members. Like ROOM_JOINED this should only be lit for
+	/// the present state of a member. Note that this appendix may query the
+	/// member's prior state to retract its tokens.
+	USER_DIR,
 };
 
 struct ircd::m::dbs::init
@@ -24,5 +24,6 @@ namespace ircd::m::dbs::desc
 	extern conf::item<size_t> events__event_json__cache__size;
 	extern conf::item<size_t> events__event_json__cache_comp__size;
 	extern conf::item<size_t> events__event_json__bloom__bits;
+	extern conf::item<bool> events__event_json__mmap_reads;
 	extern const db::descriptor events__event_json;
 }
@@ -0,0 +1,43 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2019 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_DBS_ROOM_TYPE_H
+
+namespace ircd::m::dbs
+{
+	using room_type_key_parts = std::tuple<string_view, uint64_t, event::idx>;
+
+	constexpr size_t ROOM_TYPE_KEY_MAX_SIZE
+	{
+		id::MAX_SIZE + 1 +
+		event::TYPE_MAX_SIZE + 1 +
+		sizeof(uint64_t) +
+		sizeof(event::idx)
+	};
+
+	string_view room_type_key(const mutable_buffer &out, const id::room &, const string_view &type, const uint64_t &depth = -1, const event::idx & = -1);
+	room_type_key_parts room_type_key(const string_view &amalgam);
+
+	// room_id | type, depth, event_idx => --
+	extern db::domain room_type;
+}
+
+namespace ircd::m::dbs::desc
+{
+	// room events by type
+	extern conf::item<size_t> events__room_type__block__size;
+	extern conf::item<size_t> events__room_type__meta_block__size;
+	extern conf::item<size_t> events__room_type__cache__size;
+	extern conf::item<size_t> events__room_type__cache_comp__size;
+	extern const db::prefix_transform events__room_type__pfx;
+	extern const db::comparator events__room_type__cmp;
+	extern const db::descriptor events__room_type;
+}
@@ -0,0 +1,49 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2019 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_DBS_USER_DIR_H
+
+namespace ircd::m::dbs
+{
+	using user_dir_key_parts = std::tuple<string_view, id::user, id::room>;
+	using user_dir_token_closure = std::function<bool (const string_view &)>;
+
+	constexpr size_t USER_DIR_TOKEN_MAX_SIZE
+	{
+		32
+	};
+
+	constexpr size_t USER_DIR_KEY_MAX_SIZE
+	{
+		USER_DIR_TOKEN_MAX_SIZE + 1 +
+		id::MAX_SIZE + 1 +
+		id::MAX_SIZE
+	};
+
+	bool user_dir_tokens(const string_view &text, const user_dir_token_closure &);
+	bool user_dir_tokens(const id::user &, const string_view &displayname, const user_dir_token_closure &);
+
+	string_view user_dir_key(const mutable_buffer &out, const string_view &token, const id::user & = {}, const id::room & = {});
+	user_dir_key_parts user_dir_key(const string_view &amalgam);
+
+	// token | user_id, room_id => event_idx
+	extern db::column user_dir;
+}
+
+namespace ircd::m::dbs::desc
+{
+	// user directory search tokens
+	extern conf::item<size_t> events__user_dir__block__size;
+	extern conf::item<size_t> events__user_dir__meta_block__size;
+	extern conf::item<size_t> events__user_dir__cache__size;
+	extern conf::item<size_t> events__user_dir__cache_comp__size;
+	extern const db::descriptor events__user_dir;
+}
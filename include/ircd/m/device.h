@@ -18,6 +18,28 @@ namespace ircd::m
 	struct device_list_update;
 }
 
+/// Cache of remote users' device keys. A user is tracked once a snapshot of
+/// their devices has been set from a keys query; the entry is then patched
+/// or invalidated by the m.device_list_update EDUs from the user's server.
+/// An EDU whose prev_id doesn't follow the last stream_id applied leaves the
+/// entry stale, as does the passage of the ttl, and get() then misses so the
+/// caller queries the remote again.
+namespace ircd::m::device_list
+{
+	using closure = std::function<void (const string_view &device_id, const json::object &keys)>;
+
+	extern conf::item<bool> enable;
+	extern conf::item<seconds> ttl;
+	extern conf::item<size_t> max;
+
+	bool tracked(const id::user &);
+	bool fresh(const id::user &);
+	bool get(const id::user &, const closure &);
+	void set(const id::user &, const json::object &device_keys);
+	bool update(const device_list_update &);
+	bool invalidate(const id::user &);
+}
+
 struct ircd::m::device_keys
 :json::tuple
 <
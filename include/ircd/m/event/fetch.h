@@ -38,6 +38,7 @@ struct ircd::m::event::fetch
 	using view_closure = std::function<void (const string_view &)>;
 
 	static const opts default_opts;
+	static const opts pdu_opts;
 
 	const opts *fopts {&default_opts};
 	idx event_idx {0};
@@ -68,6 +69,10 @@ namespace ircd::m
 	void seek(event::fetch &, const event::idx &);
 	bool seek(event::fetch &, const event::id &, std::nothrow_t);
 	void seek(event::fetch &, const event::id &);
+
+	// Append the event as a PDU; the stored JSON is copied out directly.
+	void append_pdu(json::stack::array &, const event::fetch &, const json::object &unsigned_);
+	void append_pdu(json::stack::array &, const event::fetch &);
 }
 
 /// Event Fetch Options.
@@ -14,7 +14,7 @@
 namespace ircd::m
 {
 	bool prefetch(const event::idx &, const event::fetch::opts & = event::fetch::default_opts);
-	bool prefetch(const event::idx &, const string_view &key);
+	bool prefetch(const event::idx &, const string_view &key, const db::gopts & = {});
 
 	bool prefetch(const event::id &, const event::fetch::opts & = event::fetch::default_opts);
 	bool prefetch(const event::id &, const string_view &key);
@@ -14,6 +14,8 @@
 namespace ircd::m::events
 {
 	struct range;
+	struct reindex;
+	struct import;
 	using closure = std::function<bool (const event::idx &, const event &)>;
 
 	// Iterate viable event indexes in a range
@@ -92,6 +94,121 @@ struct ircd::m::events::range
 	{}
 };
 
+/// Common driver for regenerating dbs appendices over the event_json table.
+/// Events are read in index order and dispatched to a pool of contexts which
+/// compose the appendix writes into a shared transaction. The transaction is
+/// committed each time it exceeds the batch size, after which the last
+/// committed event_idx is checkpointed in !ircd so an interrupted run can
+/// resume where it left off rather than starting over.
+///
+/// The constructor runs the reindex to completion or interruption; the
+/// members then report what was done.
+///
+struct ircd::m::events::reindex
+{
+	struct opts;
+	using closure = std::function<void (db::txn &, const event &, const dbs::write_opts &)>;
+
+	static conf::item<size_t> batch_size;
+	static conf::item<size_t> pool_size;
+	static conf::item<size_t> log_interval;
+
+	event::idx start {0};
+	event::idx last {0};
+	size_t events {0};
+	size_t batches {0};
+	size_t bytes {0};
+	size_t errors {0};
+	bool complete {false};
+
+	static event::idx checkpoint(const string_view &name, bool *const &complete = nullptr);
+
+	reindex(const opts &);
+};
+
+struct ircd::m::events::reindex::opts
+{
+	/// Checkpoint name; used as the state_key of the checkpoint event. An
+	/// empty name disables checkpointing and resuming.
+	string_view name;
+
+	/// Range of event_idx to walk; start inclusive, stop exclusive.
+	event::idx_range range {0, -1UL};
+
+	/// Options passed to dbs::write(); the event_idx is set for each event.
+	/// Callers should reset the appendix and select what is being rebuilt.
+	dbs::write_opts wopts;
+
+	/// Replaces dbs::write() for each event when the appendix requires some
+	/// other treatment (i.e. one which is not reachable from dbs::write()).
+	closure write;
+
+	/// Continue from the last checkpoint of the same name if it exists and
+	/// did not complete.
+	bool resume {true};
+
+	/// Overrides for the conf items; zero uses the conf item.
+	size_t batch_size {0};
+	size_t pool_size {0};
+};
+
+/// Offline bulk loader for a stream of concatenated event JSON objects, such
+/// as the output of events::dump__file() or tools/synapse.db.py. Events are
+/// not evaluated; they are assigned sequential event_idx and their writes are
+/// generated directly. Each batch is written into sorted SST files which are
+/// ingested by the database without passing through the memtable or WAL.
+///
+/// The batch's event_idx entries are ingested first so references within
+/// and across batches resolve by query while the remaining appendices are
+/// generated in parallel. Appendices which depend on the present state of a
+/// room are not generated here; with `rooms` set the head and state of each
+/// imported room is rebuilt once the stream is exhausted.
+///
+/// event_idx is assigned outside of the vm's sequencing, so the vm is held
+/// for the whole run; evals which begin meanwhile wait until it returns.
+/// Events which fail to import have their event_idx mapping removed again
+/// and leave a gap in the sequence.
+///
+struct ircd::m::events::import
+{
+	struct opts;
+
+	static conf::item<size_t> batch_size;
+	static conf::item<size_t> pool_size;
+	static const std::bitset<64> appendix_default;
+
+	event::idx start {0};
+	event::idx last {0};
+	size_t events {0};
+	size_t batches {0};
+	size_t errors {0};
+	size_t files {0};
+	size_t bytes {0};
+	std::set<std::string, std::less<>> room_ids;
+
+	import(const opts &);
+};
+
+struct ircd::m::events::import::opts
+{
+	/// Path of the event stream.
+	string_view path;
+
+	/// Directory for the intermediate SST files; defaults to the database
+	/// directory.
+	string_view dir;
+
+	/// Appendices generated for each event; EVENT_ID is always done first.
+	std::bitset<64> appendix {appendix_default};
+
+	/// Rebuild the head and state of each imported room afterward.
+	bool rooms {true};
+
+	/// Overrides for the conf items; zero uses the conf item.
+	size_t batch_size {0};
+	size_t pool_size {0};
+};
+
 inline bool
 ircd::m::events::origin::for_each(const closure_name &closure)
 {
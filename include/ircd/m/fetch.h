@@ -17,8 +17,9 @@
 /// remote parties serially. It operates by querying servers in a room until
 /// one server can provide a satisfying response. The exact method for
 /// determining who to contact, when and how is encapsulated internally for
-/// further development, but it is primarily stochastic. This is liable to be
-/// optimized with further development of selection algorithms and hinting.
+/// further development, but it is primarily stochastic. Selection is weighted
+/// by a table of remote health built from the results of prior requests, and
+/// a slow attempt may be hedged by a concurrent attempt to another server.
 /// All viable servers in a room are exhausted before an error is the result.
 ///
 /// This is an asynchronous promise/future based interface. The result package
@@ -42,11 +43,13 @@ namespace ircd::m::fetch
 	struct opts;
 	struct result;
 	struct request;
+	struct health;
 	enum class op :uint8_t;
 
 	// Observers
 	string_view reflect(const op &);
 	bool for_each(const std::function<bool (request &)> &);
+	bool for_each(const std::function<bool (const string_view &, const health &)> &);
 	bool exists(const opts &);
 	size_t count();
 
@@ -171,6 +174,14 @@ struct ircd::m::fetch::request
 	/// Error pointer state for an attempt. This is cleared each attempt.
 	std::exception_ptr eptr;
 
+	/// State for a hedged attempt made to another server concurrently when
+	/// the primary attempt is slower than usual. Whichever responds first
+	/// becomes the primary attempt and the other is canceled.
+	string_view hedge_origin;
+	system_point hedge_last;
+	unique_buffer<mutable_buffer> hedge_buf;
+	std::unique_ptr<server::request> hedge;
+
 	/// Buffer backing for opts
 	m::event::id::buf event_id;
 	m::room::id::buf room_id;
@@ -184,6 +195,33 @@ struct ircd::m::fetch::request
 	~request() noexcept;
 };
 
+/// Health of a remote server as observed by the results of fetch requests.
+/// This is exposed for examination only; instances are managed internally
+/// and influence which server is selected for each attempt.
+struct ircd::m::fetch::health
+{
+	/// Moving average of the time to respond (or fail) in milliseconds.
+	float rtt {0.0};
+
+	/// Moving average of the error rate; 0.0 for always responding with a
+	/// satisfying result and 1.0 for always failing.
+	float errors {0.0};
+
+	/// Counters over the lifetime of the entry.
+	uint32_t attempts {0};
+	uint32_t successes {0};
+	uint32_t hedges {0};
+
+	/// Time of the last result.
+	system_point last;
+
+	/// Rooms for which this server recently provided a satisfying result;
+	/// most recent first.
+	std::deque<std::string> rooms;
+
+	bool answered(const string_view &room_id) const;
+};
+
 inline
 ircd::m::fetch::result::operator
 json::array()
@@ -18,6 +18,7 @@ struct ircd::m::room::auth
 	struct refs;
 	struct chain;
 	struct hookdata;
+	struct cache;
 	using types = vector_view<const string_view>;
 	using events_view = vector_view<const event *>;
 	using passfail = std::tuple<bool, std::exception_ptr>;
@@ -100,3 +101,61 @@ class ircd::m::room::auth::hookdata
 	hookdata(const event &, const events_view &auth_events);
 	hookdata() = default;
 };
+
+/// Decoded content of the power events at the present state of a room.
+///
+/// The m.room.create, m.room.power_levels and m.room.join_rules state of
+/// active rooms rarely changes while it is consulted for nearly every auth
+/// check and many client requests. Entries are keyed by room_id and hold the
+/// event::idx of each of those cells along with their parsed content; the
+/// power levels are flattened into integer tables so room::power doesn't
+/// re-fetch and re-parse the event for each query.
+///
+/// Entries are dropped when a state write for one of the tracked types is
+/// indexed for the room. Rebuilding is refused until the writing sequence
+/// has been retired by the vm so an entry can't be refilled from the state
+/// preceding an uncommitted write. Only the present state is cached; rooms
+/// viewed at an event_id are never served from here.
+struct ircd::m::room::auth::cache
+{
+	struct entry;
+	using levels = std::map<std::string, int64_t, std::less<>>;
+
+	static conf::item<bool> enable;
+	static conf::item<size_t> max_rooms;
+	static ircd::stats::item hits;
+	static ircd::stats::item misses;
+	static ircd::stats::item invalidations;
+
+	static bool tracked(const string_view &type) noexcept;
+	static size_t size() noexcept;
+
+	static std::shared_ptr<const entry> get(const m::room::id &);
+	static void invalidate(const m::room::id &, const event::idx &sequence = 0);
+	static void clear() noexcept;
+};
+
+struct ircd::m::room::auth::cache::entry
+{
+	m::room::id::buf room_id;
+	event::idx create_idx {0};
+	event::idx power_idx {0};
+	event::idx join_rules_idx {0};
+	event::id::buf power_event_id;
+
+	// m.room.create
+	std::string create_content;
+	m::id::user::buf creator;      // sender of the create event
+	std::string room_version;
+
+	// m.room.join_rules; empty when the room has no join_rules event.
+	std::string join_rule;
+
+	// m.room.power_levels integer values. Spec defaults are not applied
+	// here; absence in these tables is meaningful to room::power.
+	levels level;                  // top-level, e.g. "ban", "users_default"
+	levels events;                 // content.events
+	levels users;                  // content.users
+
+	entry(const m::room::id &);
+};
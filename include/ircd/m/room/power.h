@@ -40,6 +40,10 @@
 /// with the creator's room_id. This may be essential functionality when no
 /// power_levels event exists.
 ///
+/// When constructed for the present state of a room the levels are answered
+/// from the decoded tables of room::auth::cache rather than parsing the
+/// event content for each query.
+///
 struct ircd::m::room::power
 {
 	using closure = std::function<void (const string_view &, const int64_t &)>;
@@ -51,11 +55,13 @@ struct ircd::m::room::power
 	static const int64_t default_user_level;
 
 	m::room room;
+	std::shared_ptr<const auth::cache::entry> cached;
 	event::idx power_event_idx {0};
 	json::object power_event_content;
 	m::id::user room_creator_id;
 
 	bool view(const std::function<void (const json::object &)> &) const;
+	static int64_t cached_level(const auth::cache::levels &, const string_view &key, const int64_t &default_);
 
   public:
 	// Iterate a collection usually either "events" or "users" as per spec.
@@ -93,6 +99,7 @@ struct ircd::m::room::power
 	explicit power(const json::object &power_event_content, const m::id::user &room_creator_id);
 	explicit power(const m::event &power_event, const m::id::user &room_creator_id);
 	explicit power(const m::event &power_event, const m::event &create_event);
+	explicit power(std::shared_ptr<const auth::cache::entry>);
 	power(const m::room &, const event::idx &power_event_idx);
 	power(const m::room &);
 	power() = default;
@@ -107,6 +107,7 @@ namespace ircd::m
 struct ircd::m::room
 {
 	struct events;
+	struct type;
 	struct state;
 	struct members;
 	struct origins;
@@ -181,6 +182,7 @@ struct ircd::m::room
 };
 
 #include "events.h"
+#include "type.h"
 #include "state.h"
 #include "state_space.h"
 #include "state_history.h"
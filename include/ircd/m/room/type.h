@@ -0,0 +1,56 @@
+// Matrix Construct
+//
+// Copyright (C) Matrix Construct Developers, Authors & Contributors
+// Copyright (C) 2016-2019 Jason Volk <jason@zemos.net>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice is present in all copies. The
+// full license for this software is available in the LICENSE file.
+
+#pragma once
+#define HAVE_IRCD_M_ROOM_TYPE_H
+
+/// Interface to the events of a room by type. This is backed by the room_type
+/// column (room_id | type, depth, event_idx) so a query for the events of one
+/// type only visits those events, where room::events would have to fetch and
+/// test every event in the timeline.
+///
+/// Iteration begins at the depth and index given to the constructor
+/// (inclusive); the default is the top of the room. for_each() proceeds
+/// toward lower depths (newest first) and rfor_each() toward higher depths.
+///
+/// Events written before this column existed are not found until the room
+/// is rebuilt with room::type::rebuild. Users which depend on the index being
+/// complete for correctness must first check the `enable` item.
+///
+struct ircd::m::room::type
+{
+	struct rebuild;
+	using closure = std::function<bool (const string_view &, const uint64_t &, const event::idx &)>;
+
+	static conf::item<bool> enable;
+	static conf::item<size_t> rebuild_batch_size;
+
+	m::room room;
+	string_view _type;
+	uint64_t _depth {uint64_t(-1)};
+	event::idx _idx {event::idx(-1)};
+
+  public:
+	bool for_each(const closure &) const;
+	bool rfor_each(const closure &) const;
+	bool prefetch() const;
+	size_t count() const;
+	bool empty() const;
+
+	type(const m::room &,
+	     const string_view &type,
+	     const uint64_t &depth = -1,
+	     const event::idx & = -1);
+};
+
+struct ircd::m::room::type::rebuild
+{
+	rebuild(const room::id &);
+};
@@ -15,6 +15,7 @@
 namespace ircd::m::rooms::summary
 {
 	struct fetch;
+	struct directory;
 	using closure = std::function<bool (const string_view &, const json::object &)>;
 	using closure_idx = std::function<bool (const string_view &, const event::idx &)>;
 
@@ -53,3 +54,37 @@ struct ircd::m::rooms::summary::fetch
 
 	fetch() = default;
 };
+
+/// Materialized directory of the published summaries. The rooms listed by
+/// each origin are ordered by their joined member count (descending) and
+/// then by room_id. The directory is built from the public rooms room on
+/// first use and is then maintained by the summary events and by membership
+/// changes in published local rooms; remote counts are those reported in
+/// the remote's summaries.
+///
+/// Pagination tokens are positions in this order, so each page is a short
+/// range scan. A position token is "<joined>,<room_id>" and iteration begins
+/// after it; a bare room_id from before this directory is also accepted.
+///
+struct ircd::m::rooms::summary::directory
+{
+	using position = std::pair<size_t, room::id>;
+	using closure = std::function<bool (const room::id &, const size_t &joined)>;
+
+	static conf::item<bool> enable;
+
+	string_view origin;
+
+  public:
+	bool for_each(const string_view &since, const closure &) const;
+	bool for_each(const closure &) const;
+	size_t count() const;
+
+	static string_view since(const mutable_buffer &, const position &);
+	static position since(const string_view &);
+	static bool valid(const string_view &since);
+
+	directory(const string_view &origin)
+	:origin{origin}
+	{}
+};
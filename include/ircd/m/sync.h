@@ -37,6 +37,7 @@ namespace ircd::m::sync
 	extern log::log log;
 	extern ctx::pool pool;
 	extern conf::item<bool> stats_info;
+	extern const event::fetch::opts prefetch_opts;
 }
 
 struct ircd::m::sync::item
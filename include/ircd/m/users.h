@@ -14,6 +14,7 @@
 namespace ircd::m::users
 {
 	struct opts extern const opts_default;
+	struct directory;
 
 	// Iterate the users
 	bool for_each(const opts &, const user::closure_bool &);
@@ -45,3 +46,36 @@ struct ircd::m::users::opts
 	opts(const string_view &query);
 	opts() = default;
 };
+
+/// Interface to the user directory. This is backed by the user_dir column
+/// (token | user_id, room_id) which holds normalized words of the localpart
+/// and display name of every member presently joined to a room. Each word of
+/// a search term matches a word of the user by prefix; the longest word is
+/// sought in the column and the others are tested against the candidates.
+///
+/// When a searcher is given the results are restricted to users joined to a
+/// room shared with the searcher, or to a public room. Memberships written
+/// before this column existed are not found until the room is rebuilt.
+///
+struct ircd::m::users::directory
+{
+	struct rebuild;
+	using closure = std::function<bool (const id::user &, const event::idx &)>;
+
+	static conf::item<bool> enable;
+	static conf::item<size_t> scan_max;
+
+	id::user searcher;
+
+  public:
+	bool for_each(const string_view &term, const closure &) const;
+
+	directory(const id::user &searcher = {})
+	:searcher{searcher}
+	{}
+};
+
+struct ircd::m::users::directory::rebuild
+{
+	rebuild(const room::id &);
+};
@@ -13,8 +13,83 @@
 
 namespace ircd::m
 {
+	struct visibility;
+
 	// The mxid argument is a string_view because it may be empty when no
 	// authentication is supplied (m::id cannot be empty because that's
 	// considered an invalid mxid). In that case the test is for public vis.
 	bool visible(const event &, const string_view &mxid);
 }
+
+/// Evaluates visible() for a sequence of events in one room to the same
+/// requester, e.g. the events of a /messages or /backfill response. The
+/// states of m.room.history_visibility and the requester's m.room.member
+/// are read out of the state space once at construction; for each event the
+/// states in effect at its depth are then found without a state query, and
+/// the decision for that pair of states is reused by every following event
+/// until one of them changes. Decisions which depend on the event itself
+/// (e.g. the requester's own member events) are still made for each event.
+///
+/// An instance is intended for the scope of a single request.
+///
+struct ircd::m::visibility
+{
+	struct cache;
+	using states = std::vector<std::pair<int64_t, event::idx>>;
+	using decision_key = std::tuple<event::idx, event::idx, bool>;
+
+	m::room::id::buf room_id;
+	std::string mxid;
+	bool user {false};
+	event::id::buf head_id;
+	states history_visibility;               // highest depth first
+	states membership;                       // highest depth first
+	std::optional<std::pair<event::idx, event::idx>> present;
+	std::map<event::idx, std::string> value; // decoded state by event_idx
+	std::map<decision_key, bool> decided;
+	int8_t present_membership {-1};
+	int8_t present_origin {-1};
+
+	string_view get(const event::idx &, const string_view &key, const string_view &default_);
+	bool excepted(const event &) const;
+	bool decide(const decision_key &);
+	bool _decide(const decision_key &);
+
+  public:
+	size_t evaluated {0};
+	size_t reused {0};
+
+	bool operator()(const event &);
+
+	visibility(const m::room::id &, const string_view &mxid);
+	visibility(visibility &&) = delete;
+	visibility(const visibility &) = delete;
+};
+
+/// Decisions of visible() for the present state of a room, i.e. when no
+/// event is given. These are requested repeatedly by clients and servers for
+/// the same rooms (/sync, /state, /members, /send_join, etc). Entries are
+/// keyed by room_id and mxid.
+///
+/// A room's entries are dropped when a state write for one of the tracked
+/// types is indexed for it; like room::auth::cache, new decisions are not
+/// stored until that write has been retired by the vm.
+///
+struct ircd::m::visibility::cache
+{
+	static conf::item<bool> enable;
+	static conf::item<size_t> max_rooms;
+	static conf::item<size_t> max_room_entries;
+	static ircd::stats::item hits;
+	static ircd::stats::item misses;
+	static ircd::stats::item invalidations;
+
+	static bool tracked(const string_view &type) noexcept;
+	static uint64_t generation() noexcept;
+	static size_t size() noexcept;
+
+	static bool get(const m::room::id &, const string_view &mxid, bool &ret);
+	static void set(const m::room::id &, const string_view &mxid, const bool &, const uint64_t &generation);
+	static void invalidate(const m::room::id &, const event::idx &sequence = 0);
+	static void clear() noexcept;
+};
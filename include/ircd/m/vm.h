@@ -19,10 +19,13 @@ namespace ircd::m::vm
 	struct opts;
 	struct copts;
 	struct eval;
+	struct timing;
 	enum fault :uint;
+	enum stage :uint8_t;
 	using fault_t = std::underlying_type<fault>::type;
 
 	string_view reflect(const fault &);
+	string_view reflect(const stage &);
 	http::code http_code(const fault &);
 	string_view loghead(const mutable_buffer &, const eval &);
 	string_view loghead(const eval &);    // single tls buffer
@@ -73,6 +76,7 @@ struct ircd::m::vm::eval
 
 	const json::iov *issue {nullptr};
 	const event *event_ {nullptr};
+	bool trusted {false};
 	vector_view<m::event> pdus;
 
 	string_view room_id;
@@ -136,6 +140,87 @@ enum ircd::m::vm::fault
 	INTERRUPT     = 0x40,  ///< ctx::interrupted (#nmi)
 };
 
+/// Stages of a PDU evaluation in the order they are conducted; the waits
+/// for sequencing are stages of their own.
+enum ircd::m::vm::stage
+:uint8_t
+{
+	CONFORM,         ///< conform hooks
+	ACCESS,          ///< access hooks and duplicate checks
+	VERIFY,          ///< signature verification
+	FETCH,           ///< fetch hooks (dependencies)
+	AUTH_STATIC,     ///< auth against the event's auth_events
+	SEQUENCE,        ///< wait to become the lowest uncommitted sequence
+	AUTH_RELATIVE,   ///< auth against the state at the prev_events
+	COMMITTING,      ///< wait to become the lowest committed sequence
+	AUTH_PRESENT,    ///< auth against the present state
+	EVAL,            ///< eval hooks
+	WRITE_PREPARE,   ///< transaction acquisition
+	WRITE_APPEND,    ///< transaction composition
+	POST,            ///< post hooks
+	WRITE_COMMIT,    ///< transaction commit
+	RETIRE,          ///< wait to become the lowest retired sequence
+	_NUM_
+};
+
+/// Reference cycles spent in each stage of one PDU evaluation. Each mark
+/// charges the cycles since the previous mark to the given stage. When the
+/// eval completes the stages it reached are added to the per-stage totals and
+/// histograms (see stats items ircd.m.vm.stage.*) and, if the eval took
+/// longer than the slow threshold, retained in a ring of the most recent
+/// slow evals.
+struct ircd::m::vm::timing
+{
+	struct counter;
+
+	static conf::item<bool> enable;
+	static conf::item<milliseconds> slow_threshold;
+	static conf::item<size_t> slow_max;
+	static std::array<std::unique_ptr<counter>, num_of<stage>()> counters;
+	static std::deque<timing> slow;
+
+	event::id::buf event_id;
+	char type[64] {0};
+	time_t ts {0};
+	microseconds elapsed {0us};
+	uint64_t last {0};
+	size_t reached {0};
+	std::array<uint64_t, num_of<stage>()> cycles {{0}};
+
+  public:
+	uint64_t total() const;
+
+	void operator()(const stage &) noexcept;
+	void commit(const event &, const microseconds &elapsed) noexcept;
+
+	timing();
+};
+
+struct ircd::m::vm::timing::counter
+{
+	ircd::stats::item total;
+	ircd::stats::histogram histogram;
+
+	counter(const stage &);
+};
+
+inline void
+ircd::m::vm::timing::operator()(const stage &stage)
+noexcept
+{
+	if(!last)
+		return;
+
+	const auto now
+	{
+		prof::cycles()
+	};
+
+	cycles[stage] += now - last;
+	reached = std::max(reached, size_t(stage) + 1);
+	last = now;
+}
+
 /// Evaluation Options
 struct ircd::m::vm::opts
 {
@@ -237,6 +322,11 @@ struct ircd::m::vm::opts
 	// Verify the origin signature
 	bool verify {true};
 
+	/// When evaluating a batch of events, acquire the keys for all of their
+	/// signatures at once before any are verified. The server conducting the
+	/// eval (node_id) is asked first as a notary for everything not cached.
+	bool fetch_keys {true};
+
 	/// Whether to automatically fetch the auth events when they do not exist.
 	bool fetch_auth {true};
 
@@ -54,6 +54,7 @@ namespace ircd::net
 {
 	const uint64_t &id(const socket &);
 	bool opened(const socket &) noexcept;
+	std::pair<bool, bool> ktls(const socket &) noexcept; // <rx, tx>
 	size_t readable(const socket &);
 	size_t available(const socket &) noexcept;
 	ipport local_ipport(const socket &) noexcept;
@@ -21,6 +21,7 @@ namespace ircd::net
 	extern conf::item<std::string> ssl_curve_list;
 	extern conf::item<std::string> ssl_cipher_list;
 	extern conf::item<std::string> ssl_cipher_blacklist;
+	extern conf::item<bool> ssl_ktls_enable;
 	extern asio::ssl::context sslv23_client;
 }
 
@@ -52,6 +53,9 @@ struct ircd::net::socket
 	static stats::item total_bytes_out;
 	static stats::item total_calls_in;
 	static stats::item total_calls_out;
+	static stats::item total_ktls_tx;
+	static stats::item total_ktls_rx;
+	static stats::item total_ktls_fallback;
 
 	uint64_t id {++count};
 	ip::tcp::socket sd;
@@ -62,7 +66,10 @@ struct ircd::net::socket
 	bool timer_set {false};                      // boolean lockout
 	bool timedout {false};
 	bool fini {false};
+	bool ktls_tx {false};                        // kernel encrypts writes
+	bool ktls_rx {false};                        // kernel decrypts reads
 
+	bool enable_ktls() noexcept;
 	void call_user(const eptr_handler &, const error_code &) noexcept;
 	void call_user(const ec_handler &, const error_code &) noexcept;
 	bool handle_verify(bool, asio::ssl::verify_context &, const open_opts &) noexcept;
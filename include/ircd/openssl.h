@@ -135,6 +135,14 @@ namespace ircd::openssl
 	void set_curves(SSL_CTX &, std::string list);
 	void set_curves(SSL &, std::string list);
 
+	// Session suite
+	int version(const SSL &); // TLS1_2_VERSION et al
+	bool pending(const SSL &); // any unconsumed input held within the SSL
+	const_buffer client_random(const mutable_buffer &, const SSL &);
+	const_buffer server_random(const mutable_buffer &, const SSL &);
+	const_buffer master_key(const mutable_buffer &, const SSL &);
+	const_buffer key_block(const mutable_buffer &, const SSL &); // TLS 1.2 only
+
 	// SNI suite
 	string_view server_name(const SSL &); // provided by client
 	void server_name(SSL &, const string_view &); // set by client
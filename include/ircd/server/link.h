@@ -23,6 +23,8 @@ struct ircd::server::link
 {
 	static conf::item<size_t> tag_max_default;
 	static conf::item<size_t> tag_commit_max_default;
+	static conf::item<seconds> stall_default;
+	static ircd::stats::histogram rtt;
 	static uint64_t ids;
 
 	uint64_t id {++ids};                         ///< unique identifier of link.
@@ -32,6 +34,9 @@ struct ircd::server::link
 	time_t synack_ts {0L};                       ///< time socket was estab
 	time_t read_ts {0L};                         ///< time of last read
 	time_t write_ts {0L};                        ///< time of last write
+	uint64_t rtt_avg {0};                        ///< moving avg tag round-trip (us)
+	uint64_t queue_avg {0};                      ///< moving avg wait to commit (us)
+	steady_point open_point;                     ///< time socket became usable
 	bool op_init {false};                        ///< link is connecting
 	bool op_fini {false};                        ///< link is disconnecting
 	bool op_open {false};
@@ -68,6 +73,7 @@ struct ircd::server::link
 	bool opened() const noexcept;
 	bool ready() const;
 	bool busy() const;
+	bool stalled() const;
 
 	// stats for upload-side bytes across all tags
 	size_t write_size() const;
@@ -26,6 +26,8 @@ struct ircd::server::peer
 	static conf::item<bool> enable_ipv6;
 	static conf::item<size_t> link_min_default;
 	static conf::item<size_t> link_max_default;
+	static conf::item<bool> link_adaptive;
+	static conf::item<milliseconds> link_queue_target;
 	static conf::item<seconds> error_clear_default;
 	static uint64_t ids;
 
@@ -39,6 +41,7 @@ struct ircd::server::peer
 	std::string server_version;
 	size_t write_bytes {0};
 	size_t read_bytes {0};
+	size_t link_want {0};
 	bool op_resolve {false};
 	bool op_fini {false};
 
@@ -59,6 +62,7 @@ struct ircd::server::peer
 
 	void handle_head_recv(const link &, const tag &, const http::response::head &);
 	void handle_link_done(link &);
+	void handle_tag_commit(link &, tag &, const microseconds &queued) noexcept;
 	void handle_tag_done(link &, tag &) noexcept;
 	void handle_finished(link &);
 	void handle_error(link &, const std::system_error &);
@@ -73,6 +77,7 @@ struct ircd::server::peer
 	// config related
 	size_t link_min() const;
 	size_t link_max() const;
+	size_t link_target() const;
 
 	// stats for all links in peer
 	size_t link_count() const;
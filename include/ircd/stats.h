@@ -14,12 +14,15 @@
 namespace ircd::stats
 {
 	struct item;
+	struct histogram;
+	struct summary;
 	using value_type = int128_t;
 
 	IRCD_EXCEPTION(ircd::error, error)
 	IRCD_EXCEPTION(error, not_found)
 
 	extern std::map<string_view, item *> items;
+	extern std::map<string_view, histogram *> histograms;
 
 	const value_type &get(const item &);
 	value_type &get(item &);
@@ -57,6 +60,76 @@ struct ircd::stats::item
 	~item() noexcept;
 };
 
+/// Distribution of unsigned samples (e.g. microseconds) in log-linear
+/// buckets: each power of two is split into SUBS linear buckets, so the
+/// relative error of any bucket bound is at most 1/SUBS. Recording a sample
+/// is a count-leading-zeros and three increments.
+struct ircd::stats::histogram
+{
+	static constexpr const size_t SUB_BITS {2};
+	static constexpr const size_t SUBS {1UL << SUB_BITS};
+	static constexpr const size_t LOG_MAX {40};
+	static constexpr const size_t BUCKETS {(LOG_MAX - SUB_BITS + 2) * SUBS};
+
+	json::strung feature_;
+	json::object feature;
+	string_view name;
+	bool summary {false};
+	uint64_t count {0};
+	uint64_t sum {0};
+	std::array<uint64_t, BUCKETS> bucket {{0}};
+
+	static size_t index(const uint64_t &val) noexcept;
+	static uint64_t upper(const size_t &index) noexcept;
+
+  public:
+	uint64_t quantile(const double &) const;
+	void clear();
+
+	void operator()(const uint64_t &val) noexcept;
+
+	histogram(const json::members &, const bool &summary = false);
+	histogram(histogram &&) = delete;
+	histogram(const histogram &) = delete;
+	~histogram() noexcept;
+};
+
+/// Histogram which is reported as quantiles rather than as buckets.
+struct ircd::stats::summary
+:histogram
+{
+	summary(const json::members &);
+};
+
+inline void
+ircd::stats::histogram::operator()(const uint64_t &val)
+noexcept
+{
+	++bucket[index(val)];
+	++count;
+	sum += val;
+}
+
+inline size_t
+ircd::stats::histogram::index(const uint64_t &val)
+noexcept
+{
+	if(val < SUBS)
+		return val;
+
+	const size_t log
+	{
+		63UL - __builtin_clzl(val)
+	};
+
+	const size_t sub
+	{
+		(val >> (log - SUB_BITS)) & (SUBS - 1)
+	};
+
+	return std::min((log - SUB_BITS + 1) * SUBS + sub, BUCKETS - 1);
+}
+
 inline ircd::stats::item &
 ircd::stats::item::operator--()
 {
@@ -1686,6 +1686,7 @@ namespace ircd::ctx::prof
 	thread_local ulong _slice_start;     // Current/last time slice started
 	thread_local ulong _slice_stop;      // Last time slice ended
 	thread_local ticker _total;          // Totals kept for all contexts.
+	extern stats::histogram slice_histogram;
 
 	static void check_stack();
 	static void check_slice();
@@ -1780,6 +1781,13 @@ ircd::ctx::prof::handle_cur_enter()
 	slice_enter();
 }
 
+/// Distribution of the length of every slice on the main thread, in cycles.
+decltype(ircd::ctx::prof::slice_histogram)
+ircd::ctx::prof::slice_histogram
+{
+	{ "name", "ircd.ctx.prof.slice.cycles" },
+};
+
 [[gnu::hot]]
 void
 ircd::ctx::prof::handle_cur_leave()
@@ -1842,6 +1850,7 @@ noexcept
 	assert(c.ios_desc.stats);
 	c.ios_desc.stats->slice_total += last_slice;
 	c.ios_desc.stats->slice_last = last_slice;
+	slice_histogram(last_slice);
 	c.stack.at = stack_at_here();
 }
 
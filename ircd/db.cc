@@ -1406,6 +1406,32 @@ try
 		if(describe(*colptr).drop)
 			db::drop(*colptr);
 
+	// Register the existing table files of columns described with mmap_reads
+	// so the env maps them when they are opened; files created later are
+	// registered by the events listener.
+	const bool mmap_reads
+	{
+		std::any_of(begin(columns), end(columns), []
+		(const auto &colptr)
+		{
+			return describe(*colptr).mmap_reads;
+		})
+	};
+
+	if(mmap_reads)
+	{
+		std::vector<rocksdb::LiveFileMetaData> live;
+		d->GetLiveFilesMetaData(&live);
+		for(const auto &file : live)
+		{
+			const auto it(column_names.find(file.column_family_name));
+			if(it != end(column_names) && describe(*it->second).mmap_reads)
+				env->mmap_files.emplace(token_last(file.name, '/'));
+		}
+
+		++env->mmap_files_version;
+	}
+
 	// Database integrity check branch.
 	if(bool(open_check))
 	{
@@ -2707,6 +2733,17 @@ noexcept
 		int(info.status.code()),
 		info.status.getState()?: "OK",
 	};
+
+	const auto it
+	{
+		d->env->mmap_files.find(token_last(info.file_path, '/'))
+	};
+
+	if(it != end(d->env->mmap_files))
+	{
+		d->env->mmap_files.erase(it);
+		++d->env->mmap_files_version;
+	}
 }
 
 void
@@ -2764,6 +2801,13 @@ noexcept
 		lstrip(info.file_path, info.db_name),
 		info.cf_name,
 	};
+
+	const auto it(d->column_names.find(info.cf_name));
+	if(it != end(d->column_names) && describe(*it->second).mmap_reads)
+	{
+		d->env->mmap_files.emplace(token_last(info.file_path, '/'));
+		++d->env->mmap_files_version;
+	}
 }
 
 void
@@ -3425,6 +3469,170 @@ ircd::db::database::sst::dump::dump(db::column column,
 	this->info.version = info.version;
 }
 
+//
+// sst::ingest::ingest
+//
+
+ircd::db::database::sst::ingest::ingest(const txn &t,
+                                        const string_view &dir_)
+{
+	static uint64_t ctr;
+	database &d
+	{
+		const_cast<database &>(static_cast<const database &>(t))
+	};
+
+	std::string dir
+	{
+		dir_
+	};
+
+	if(dir.empty())
+	{
+		const string_view path_parts[]
+		{
+			fs::path(fs::base::DB), db::name(d)
+		};
+
+		dir = fs::path_string(path_parts);
+	}
+
+	// Group the deltas by column; the views point into the txn's batch which
+	// outlives this function.
+	std::map<string_view, std::vector<delta>> columns;
+	for_each(t, delta_closure{[&columns]
+	(const delta &delta)
+	{
+		columns[std::get<delta::COL>(delta)].emplace_back(delta);
+	}});
+
+	// Repeated keys are reduced to their last update below; merge operands
+	// would have to be folded instead, so they are refused before anything
+	// is written.
+	for(const auto &[colname, deltas] : columns)
+		for(const auto &delta : deltas)
+			if(std::get<delta::OP>(delta) == op::MERGE)
+				throw error
+				{
+					"Cannot ingest merge operands for column '%s'",
+					colname,
+				};
+
+	const ctx::uninterruptible::nothrow ui;
+	for(auto &[colname, deltas] : columns)
+	{
+		database::column &c(d[colname]);
+		rocksdb::Options opts(d.d->GetOptions(c));
+		rocksdb::EnvOptions eopts(opts);
+		const rocksdb::Comparator &cmp
+		{
+			*opts.comparator
+		};
+
+		// The writer requires strictly ascending keys; a stable sort keeps
+		// repeated keys in transaction order so the last one can be taken.
+		std::stable_sort(begin(deltas), end(deltas), [&cmp]
+		(const delta &a, const delta &b)
+		{
+			return cmp.Compare(slice(std::get<delta::KEY>(a)), slice(std::get<delta::KEY>(b))) < 0;
+		});
+
+		char namebuf[64];
+		const string_view filename
+		{
+			fmt::sprintf
+			{
+				namebuf, "%s.%lu.ingest.sst", db::name(c), ++ctr
+			}
+		};
+
+		const string_view path_parts[]
+		{
+			dir, filename
+		};
+
+		const std::string path
+		{
+			fs::path_string(path_parts)
+		};
+
+		rocksdb::SstFileWriter writer
+		{
+			eopts, opts, c
+		};
+
+		throw_on_error
+		{
+			writer.Open(path)
+		};
+
+		size_t i(0);
+		for(auto it(begin(deltas)); it != end(deltas); ++it)
+		{
+			const auto &key(std::get<delta::KEY>(*it));
+			const auto &val(std::get<delta::VAL>(*it));
+			const auto &type(std::get<delta::OP>(*it));
+			const auto next(std::next(it));
+			if(next != end(deltas) && type != op::DELETE_RANGE)
+				if(cmp.Compare(slice(key), slice(std::get<delta::KEY>(*next))) == 0)
+					continue;
+
+			switch(type)
+			{
+				case op::SET:
+					throw_on_error{writer.Put(slice(key), slice(val))};
+					break;
+
+				case op::DELETE:
+				case op::SINGLE_DELETE:
+					throw_on_error{writer.Delete(slice(key))};
+					break;
+
+				case op::DELETE_RANGE:
+					throw_on_error{writer.DeleteRange(slice(key), slice(val))};
+					break;
+
+				case op::GET:
+				case op::MERGE:
+					assert(0);
+					continue;
+			}
+
+			++i;
+		}
+
+		if(!i)
+			continue;
+
+		rocksdb::ExternalSstFileInfo info;
+		throw_on_error
+		{
+			writer.Finish(&info)
+		};
+
+		rocksdb::IngestExternalFileOptions iopts;
+		iopts.move_files = true;
+		iopts.allow_global_seqno = true;
+		iopts.allow_blocking_flush = true;
+		iopts.ingest_behind = opts.allow_ingest_behind;
+
+		const std::vector<std::string> files
+		{
+			info.file_path
+		};
+
+		const std::lock_guard lock{write_mutex};
+		throw_on_error
+		{
+			d.d->IngestExternalFile(c, files, iopts)
+		};
+
+		this->files += 1;
+		this->entries += info.num_entries;
+		this->bytes += info.file_size;
+	}
+}
+
 //
 // sst::info::vector
 //
@@ -3816,6 +4024,32 @@ ircd::db::histogram_max
 decltype(ircd::db::prefetcher)
 ircd::db::prefetcher;
 
+decltype(ircd::db::prefetcher::expire)
+ircd::db::prefetcher::expire
+{
+	{ "name",     "ircd.db.prefetcher.expire" },
+	{ "default",  5000L                       },
+	{ "description",
+
+	R"(
+	Prefetch requests which have been queued for longer than this many
+	milliseconds without being started are dropped; the reader which wanted
+	them has likely already queried the database itself. Zero disables.
+	)"}
+};
+
+decltype(ircd::db::prefetcher::queue_latency)
+ircd::db::prefetcher::queue_latency
+{
+	{ "name", "ircd.db.prefetcher.queue.usec" },
+};
+
+decltype(ircd::db::prefetcher::fetch_latency)
+ircd::db::prefetcher::fetch_latency
+{
+	{ "name", "ircd.db.prefetcher.fetch.usec" },
+};
+
 //
 // db::prefetcher
 //
@@ -3837,21 +4071,22 @@ ircd::db::prefetcher::prefetcher()
 ircd::db::prefetcher::~prefetcher()
 noexcept
 {
-	while(!queue.empty())
+	while(queued())
 	{
 		log::warning
 		{
 			log, "Prefetcher waiting for %zu requests to clear...",
-			queue.size(),
+			queued(),
 		};
 
 		dock.wait_for(seconds(5), [this]
 		{
-			return queue.empty();
+			return !queued();
 		});
 	}
 
-	assert(queue.empty());
+	assert(!queued());
+	assert(pending.empty());
 }
 
 bool
@@ -3872,9 +4107,46 @@ ircd::db::prefetcher::operator()(column &c,
 		return false;
 	}
 
-	queue.emplace_back(d, c, key);
+	const uint8_t prio
+	{
+		test(opts, get::PRIO_HIGH)? uint8_t(0):
+		test(opts, get::PRIO_LOW)? uint8_t(2):
+		uint8_t(1)
+	};
+
+	// The same key is often prefetched by several contexts at once (e.g. by
+	// many syncs iterating the same room); only one request is made for it.
+	// When it's still queued and this query is more urgent it's moved to the
+	// more urgent queue, otherwise this query just shares its result.
+	if(auto *const existing{pending_find(d, c, key)})
+	{
+		const bool promote
+		{
+			prio < existing->prio && existing->req == steady_point::min()
+		};
+
+		if(!promote)
+		{
+			ticker->coalesced++;
+			return true;
+		}
+
+		existing->fin = now<steady_point>();
+		pending_erase(*existing);
+		ticker->promoted++;
+	}
+
+	auto &queue
+	{
+		this->queue.at(prio)
+	};
+
+	queue.emplace_back(d, c, key, prio);
 	queue.back().snd = now<steady_point>();
+	pending.emplace(pending_key(d, queue.back().cid, string_view(queue.back())), &queue.back());
 	ticker->request++;
+	ticker->prio_high += prio == 0;
+	ticker->prio_low += prio == 2;
 
 	// Branch here based on whether it's not possible to directly dispatch
 	// a db::request worker. If all request workers are busy we notify our own
@@ -3902,6 +4174,33 @@ ircd::db::prefetcher::operator()(column &c,
 	return true;
 }
 
+size_t
+ircd::db::prefetcher::cancel(column &c,
+                             const string_view &key)
+{
+	auto &d
+	{
+		static_cast<database &>(c)
+	};
+
+	auto *const request
+	{
+		pending_find(d, c, key)
+	};
+
+	// in progress; can't cancel
+	if(!request || request->req != steady_point::min())
+		return 0;
+
+	request->fin = now<steady_point>();
+	pending_erase(*request);
+	dock.notify_all();
+
+	assert(ticker);
+	ticker->cancels++;
+	return 1;
+}
+
 size_t
 ircd::db::prefetcher::cancel(column &c)
 {
@@ -3926,24 +4225,26 @@ size_t
 ircd::db::prefetcher::cancel(const closure &closure)
 {
 	size_t canceled(0);
-	for(auto &request : queue)
-	{
-		// already finished
-		if(request.fin != steady_point::min())
-			continue;
-
-		// in progress; can't cancel
-		if(request.req != steady_point::min())
-			continue;
-
-		// allow user to accept or reject
-		if(!closure(request))
-			continue;
-
-		// cancel by precociously setting the finish time.
-		request.fin = now<steady_point>();
-		++canceled;
-	}
+	for(auto &queue : this->queue)
+		for(auto &request : queue)
+		{
+			// already finished
+			if(request.fin != steady_point::min())
+				continue;
+
+			// in progress; can't cancel
+			if(request.req != steady_point::min())
+				continue;
+
+			// allow user to accept or reject
+			if(!closure(request))
+				continue;
+
+			// cancel by precociously setting the finish time.
+			request.fin = now<steady_point>();
+			pending_erase(request);
+			++canceled;
+		}
 
 	if(canceled)
 		dock.notify_all();
@@ -3961,7 +4262,7 @@ try
 	{
 		dock.wait([this]
 		{
-			if(queue.empty())
+			if(!queued())
 				return false;
 
 			assert(ticker);
@@ -4022,18 +4323,15 @@ ircd::db::prefetcher::request_worker()
 		request_cleanup()
 	};
 
-	// Find the first request in the queue which does not have its req
-	// timestamp sent.
-	auto request
+	// Find the most urgent request which does not have its req timestamp
+	// sent. References to deque elements remain valid while other requests
+	// are added and removed at the ends.
+	auto *const request
 	{
-		std::find_if(begin(queue), end(queue), []
-		(const auto &request)
-		{
-			return request.req == steady_point::min();
-		})
+		request_next()
 	};
 
-	if(request == end(queue))
+	if(!request)
 		return;
 
 	assert(ticker);
@@ -4041,6 +4339,12 @@ ircd::db::prefetcher::request_worker()
 	request->req = now<steady_point>();
 	ticker->last_snd_req = duration_cast<microseconds>(request->req - request->snd);
 	ticker->accum_snd_req += ticker->last_snd_req;
+	queue_latency(ticker->last_snd_req.count());
+
+	const unwind finished{[this, &request]
+	{
+		pending_erase(*request);
+	}};
 
 	ticker->fetches++;
 	request_handle(*request);
@@ -4050,27 +4354,77 @@ ircd::db::prefetcher::request_worker()
 	#ifdef IRCD_DB_DEBUG_PREFETCH
 	log::debug
 	{
-		log, "prefetcher reject:%zu request:%zu handle:%zu fetch:%zu direct:%zu cancel:%zu queue:%zu rw:%zu",
+		log, "prefetcher reject:%zu request:%zu handle:%zu fetch:%zu direct:%zu cancel:%zu coalesce:%zu expire:%zu queue:%zu rw:%zu",
 		ticker->rejects,
 		ticker->request,
 		ticker->handles,
 		ticker->fetches,
 		ticker->directs,
 		ticker->cancels,
-		queue.size(),
+		ticker->coalesced,
+		ticker->expires,
+		queued(),
 		this->request_workers,
 	};
 	#endif
 }
 
+ircd::db::prefetcher::request *
+ircd::db::prefetcher::request_next()
+noexcept
+{
+	const auto now
+	{
+		ircd::now<steady_point>()
+	};
+
+	for(auto &queue : this->queue)
+		for(auto &request : queue)
+		{
+			if(request.req != steady_point::min())
+				continue;
+
+			if(request.fin != steady_point::min())
+				continue;
+
+			// Drop requests which waited too long; the cleanup will remove
+			// them once they reach the front.
+			if(request_expired(request, now))
+			{
+				request.fin = now;
+				pending_erase(request);
+				ticker->expires++;
+				continue;
+			}
+
+			return &request;
+		}
+
+	return nullptr;
+}
+
+bool
+ircd::db::prefetcher::request_expired(const request &request,
+                                      const steady_point &now)
+const noexcept
+{
+	const milliseconds &expire
+	{
+		this->expire
+	};
+
+	return expire > 0ms && request.snd + expire < now;
+}
+
 size_t
 ircd::db::prefetcher::request_cleanup()
 noexcept
 {
 	size_t removed(0);
 	const ctx::critical_assertion ca;
-	for(; !queue.empty() && queue.front().fin != steady_point::min(); ++removed)
-		queue.pop_front();
+	for(auto &queue : this->queue)
+		for(; !queue.empty() && queue.front().fin != steady_point::min(); ++removed)
+			queue.pop_front();
 
 	return removed;
 }
@@ -4099,6 +4453,7 @@ try
 	request.fin = now<steady_point>();
 	ticker->last_req_fin = duration_cast<microseconds>(request.fin - request.req);
 	ticker->accum_req_fin += ticker->last_req_fin;
+	fetch_latency(ticker->last_req_fin.count());
 	const bool lte
 	{
 		valid_lte(*it, key)
@@ -4124,7 +4479,7 @@ try
 		pretty(pbuf[0], request.req - request.snd, 1),
 		pretty(pbuf[1], request.fin - request.req, 1),
 		pretty(pbuf[2], request.fin - request.snd, 1),
-		queue.size(),
+		queued(),
 	};
 	#endif
 }
@@ -4169,13 +4524,92 @@ ircd::db::prefetcher::wait_pending()
 	return fetched_target - fetched_counter;
 }
 
+size_t
+ircd::db::prefetcher::queued()
+const noexcept
+{
+	return std::accumulate(begin(queue), end(queue), size_t(0), []
+	(const size_t &ret, const auto &queue)
+	{
+		return ret + queue.size();
+	});
+}
+
+ircd::db::prefetcher::request *
+ircd::db::prefetcher::pending_find(database &d,
+                                   const column &c,
+                                   const string_view &key_)
+noexcept
+{
+	const uint32_t cid
+	{
+		db::id(c)
+	};
+
+	// Requests hold at most this much of the key; match on the same.
+	const string_view key
+	{
+		key_.substr(0, sizeof(request::key))
+	};
+
+	const auto it
+	{
+		pending.find(pending_key(d, cid, key))
+	};
+
+	if(it == end(pending))
+		return nullptr;
+
+	auto &request(*it->second);
+	const bool match
+	{
+		request.d == std::addressof(d)
+		&& request.cid == cid
+		&& string_view(request) == key
+	};
+
+	return match? &request : nullptr;
+}
+
+void
+ircd::db::prefetcher::pending_erase(request &request)
+noexcept
+{
+	assert(request.d);
+	const auto it
+	{
+		pending.find(pending_key(*request.d, request.cid, string_view(request)))
+	};
+
+	// On a hash collision the entry might belong to another request.
+	if(it != end(pending) && it->second == &request)
+		pending.erase(it);
+}
+
+size_t
+ircd::db::prefetcher::pending_key(const database &d,
+                                  const uint32_t &cid,
+                                  const string_view &key)
+noexcept
+{
+	size_t ret
+	{
+		std::hash<string_view>{}(key)
+	};
+
+	ret ^= std::hash<const void *>{}(std::addressof(d)) + 0x9e3779b97f4a7c15UL + (ret << 6) + (ret >> 2);
+	ret ^= std::hash<uint32_t>{}(cid) + 0x9e3779b97f4a7c15UL + (ret << 6) + (ret >> 2);
+	return ret;
+}
+
 //
 // prefetcher::request
 //
 
 ircd::db::prefetcher::request::request(database &d,
                                        const column &c,
-                                       const string_view &key)
+                                       const string_view &key,
+                                       const uint8_t &prio)
 noexcept
 :d
 {
@@ -4201,6 +4635,10 @@ noexcept
 {
 	steady_point::min()
 }
+,prio
+{
+	prio
+}
 {
 	const size_t &len
 	{
@@ -9,6 +9,7 @@
 // full license for this software is available in the LICENSE file.
 
 #include <RB_INC_FCNTL_H
+#include <RB_INC_SYS_MMAN_H
 #include "db.h"
 
 decltype(ircd::db::database::env::log)
@@ -3173,6 +3174,20 @@ ircd::db::database::env::random_access_file::default_opts{[]
 	return ret;
 }()};
 
+decltype(ircd::db::database::env::random_access_file::mmap_hits)
+ircd::db::database::env::random_access_file::mmap_hits
+{
+	{ "name", "ircd.db.env.rfile.mmap.hits" },
+	{ "desc", "Reads served directly from a resident memory map" },
+};
+
+decltype(ircd::db::database::env::random_access_file::mmap_misses)
+ircd::db::database::env::random_access_file::mmap_misses
+{
+	{ "name", "ircd.db.env.rfile.mmap.misses" },
+	{ "desc", "Reads of a memory mapped file which fell back to AIO" },
+};
+
 ircd::db::database::env::random_access_file::random_access_file(database *const &d,
                                                                 const std::string &name,
                                                                 const EnvOptions &env_opts)
@@ -3204,6 +3219,14 @@ try
 	// Currently the /proc filesystem doesn't like AIO.
 	!startswith(name, "/proc/")
 }
+,basename
+{
+	token_last(name, '/')
+}
+,use_mmap_reads
+{
+	env_opts.use_mmap_reads
+}
 {
 	#ifdef RB_DEBUG_DB_ENV
 	log::debug
@@ -3216,6 +3239,8 @@ try
 		name
 	};
 	#endif
+
+	_map();
 }
 catch(const std::exception &e)
 {
@@ -3241,6 +3266,61 @@ noexcept
 		int(fd)
 	};
 	#endif
+
+	if(data(map))
+		::munmap(const_cast<char *>(data(map)), size(map));
+}
+
+/// Map the file when it belongs to a column described with mmap_reads. The
+/// columns of table files are only known after the database has opened, so
+/// files opened before that are mapped on their first read afterward.
+void
+ircd::db::database::env::random_access_file::_map()
+const
+{
+	mmap_version = d.env->mmap_files_version;
+
+	// Direct IO bypasses the page cache so there is nothing to map.
+	if(data(map) || opts.direct)
+		return;
+
+	if(!use_mmap_reads && !d.env->mmap_files.count(basename))
+		return;
+
+	const size_t map_size
+	{
+		fs::size(fd)
+	};
+
+	if(!map_size)
+		return;
+
+	void *const ptr
+	{
+		::mmap(nullptr, map_size, PROT_READ, MAP_SHARED, int(fd), 0)
+	};
+
+	if(unlikely(ptr == MAP_FAILED))
+	{
+		log::derror
+		{
+			log, "[%s] rfile:%p mmap of %zu bytes '%s' :%s",
+			d.name,
+			this,
+			map_size,
+			basename,
+			strerror(errno),
+		};
+
+		return;
+	}
+
+	// Block accesses are point lookups; readahead would only pollute.
+	::madvise(ptr, map_size, MADV_RANDOM);
+	map = const_buffer
+	{
+		reinterpret_cast<const char *>(ptr), map_size
+	};
 }
 
 rocksdb::Status
@@ -3310,6 +3390,35 @@ const noexcept try
 	};
 	#endif
 
+	// When the file is mapped, the result can point directly into the map
+	// without a copy; this is only done when the pages are already resident
+	// because a major fault would block every ctx on this thread. Otherwise
+	// the read goes through AIO which also brings the pages into the cache.
+	if(unlikely(mmap_version != d.env->mmap_files_version))
+		_map();
+
+	if(data(map))
+	{
+		const size_t pos
+		{
+			std::min(size_t(offset), size(map))
+		};
+
+		const const_buffer range
+		{
+			data(map) + pos, std::min(length, size(map) - pos)
+		};
+
+		if(fs::fincore(range))
+		{
+			++mmap_hits;
+			*result = slice(range);
+			return Status::OK();
+		}
+
+		++mmap_misses;
+	}
+
 	fs::read_opts opts;
 	opts.offset = offset;
 	opts.aio = this->aio;
@@ -3442,6 +3551,20 @@ noexcept
 		reflect(pattern)
 	};
 	#endif
+
+	if(!data(map))
+		return;
+
+	const int advice
+	{
+		pattern == AccessPattern::RANDOM? MADV_RANDOM:
+		pattern == AccessPattern::SEQUENTIAL? MADV_SEQUENTIAL:
+		pattern == AccessPattern::WILLNEED? MADV_WILLNEED:
+		pattern == AccessPattern::DONTNEED? MADV_DONTNEED:
+		MADV_NORMAL
+	};
+
+	::madvise(const_cast<char *>(data(map)), size(map), advice);
 }
 
 bool
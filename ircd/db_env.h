@@ -44,6 +44,14 @@ struct ircd::db::database::env final
 
 	std::unique_ptr<struct state> st;
 
+	/// Names of the table files (without directory) of columns which were
+	/// described with mmap_reads; maintained by database and its events.
+	std::set<std::string, std::less<>> mmap_files;
+
+	/// Incremented with every change to mmap_files; open files recheck
+	/// their membership when this differs from what they last saw.
+	uint64_t mmap_files_version {0};
+
 	Status NewSequentialFile(const std::string& f, std::unique_ptr<SequentialFile>* r, const EnvOptions& options) noexcept override;
 	Status NewRandomAccessFile(const std::string& f, std::unique_ptr<RandomAccessFile>* r, const EnvOptions& options) noexcept override;
 	Status NewWritableFile(const std::string& f, std::unique_ptr<WritableFile>* r, const EnvOptions& options) noexcept override;
@@ -120,12 +128,20 @@ struct ircd::db::database::env::random_access_file final
 	using Slice = rocksdb::Slice;
 
 	static const fs::fd::opts default_opts;
+	static ircd::stats::item mmap_hits;
+	static ircd::stats::item mmap_misses;
 
 	database &d;
 	fs::fd::opts opts;
 	fs::fd fd;
 	size_t _buffer_align;
 	bool aio;
+	std::string basename;
+	bool use_mmap_reads;
+	mutable uint64_t mmap_version {-1UL};
+	mutable const_buffer map;
+
+	void _map() const;
 
 	bool use_direct_io() const noexcept override;
 	size_t GetRequiredBufferAlignment() const noexcept override;
@@ -15,6 +15,7 @@ __attribute__((visibility("hidden")))
 
 	struct spec;
 	struct specifier;
+	struct program;
 	struct parser extern const parser;
 
 	constexpr char SPECIFIER
@@ -38,7 +39,12 @@ __attribute__((visibility("hidden")))
 	struct pointer_specifier extern const pointer_specifier;
 	struct string_specifier extern const string_specifier;
 
+	extern thread_local std::unordered_map<const char *, std::unique_ptr<program>> programs;
+	extern thread_local size_t executing;
+
 	bool is_specifier(const string_view &name);
+	const program *find_program(const string_view &fmt);
+	void handle_specifier(mutable_buffer &out, const uint &idx, const specifier &, const spec &, const arg &);
 	void handle_specifier(mutable_buffer &out, const uint &idx, const spec &, const arg &);
 	template<class generator> bool generate_string(char *&out, const generator &gen, const arg &val);
 	template<class T, class lambda> bool visit_type(const arg &val, lambda&& closure);
@@ -137,6 +143,72 @@ struct ircd::fmt::parser
 }
 const ircd::fmt::parser;
 
+/// A format string parsed ahead of its arguments. Each step corresponds to
+/// one argument and carries the parsed specifier with its resolved handler
+/// followed by the literal text to append after it. Stepping mirrors exactly
+/// what snprintf::argument() does at each position, so the output of a
+/// program is identical to a parse at runtime.
+struct ircd::fmt::program
+{
+	struct step
+	{
+		fmt::spec spec;
+		const specifier *handler {nullptr};
+		bool parsed {false};
+		string_view text;
+	};
+
+	std::string format;
+	std::vector<step> steps;
+
+	program(const string_view &fmt);
+	program(program &&) = delete;
+	program(const program &) = delete;
+};
+
+decltype(ircd::fmt::programs)
+thread_local
+ircd::fmt::programs;
+
+/// Number of programs being executed on this thread. A specifier handler
+/// can format again (i.e the invalid_format error) while its program runs.
+decltype(ircd::fmt::executing)
+thread_local
+ircd::fmt::executing;
+
+decltype(ircd::fmt::cache::enable)
+ircd::fmt::cache::enable
+{
+	{ "name",     "ircd.fmt.cache.enable" },
+	{ "default",  true                    },
+};
+
+decltype(ircd::fmt::cache::max)
+ircd::fmt::cache::max
+{
+	{ "name",     "ircd.fmt.cache.max" },
+	{ "default",  4096L                },
+	{ "description",
+
+	R"(
+	Maximum number of parsed format strings kept by each thread. The cache
+	is emptied when it is full and refills with the formats in use.
+	)"}
+};
+
+size_t
+ircd::fmt::cache::count()
+{
+	return programs.size();
+}
+
+void
+ircd::fmt::cache::clear()
+{
+	assert(!executing);
+	programs.clear();
+}
+
 struct ircd::fmt::string_specifier
 :specifier
 {
@@ -367,9 +439,45 @@ try
 	assert(data(this->fmt) >= data(fmt));
 	append(string_view(data(fmt), data(this->fmt)));
 
-	// Iterate
+	// Execute the parsed program for this format when one is available.
+	const auto *const program
+	{
+		cache::enable?
+			find_program(fmt):
+			nullptr
+	};
+
 	auto it(begin(v));
-	for(size_t i(0); i < v.size() && !finished(); ++it, i++)
+	if(likely(program))
+	{
+		const scope_count executing
+		{
+			fmt::executing
+		};
+
+		const auto &steps(program->steps);
+		for(size_t i(0); i < v.size() && i < steps.size() && remaining(); ++it, i++)
+		{
+			const auto &step(steps[i]);
+			if(step.parsed)
+			{
+				const void *const &ptr(get<0>(*it));
+				const std::type_index type(*get<1>(*it));
+
+				// A specifier which didn't resolve is reported as the parser
+				// would have, only once an argument reaches it.
+				if(likely(step.handler))
+					handle_specifier(this->out, idx++, *step.handler, step.spec, std::make_tuple(ptr, type));
+				else
+					handle_specifier(this->out, idx++, step.spec, std::make_tuple(ptr, type));
+			}
+
+			append(step.text);
+		}
+	}
+
+	// Otherwise iterate and parse each specifier.
+	else for(size_t i(0); i < v.size() && !finished(); ++it, i++)
 	{
 		const void *const &ptr(get<0>(*it));
 		const std::type_index type(*get<1>(*it));
@@ -424,6 +532,108 @@ ircd::fmt::snprintf::argument(const arg &val)
 	};
 }
 
+//
+// program
+//
+
+ircd::fmt::program::program(const string_view &fmt)
+:format
+{
+	fmt
+}
+{
+	const string_view format
+	{
+		this->format
+	};
+
+	const auto pos(format.find(SPECIFIER));
+	string_view cur
+	{
+		pos != format.npos?
+			format.substr(pos):
+			string_view{}
+	};
+
+	while(!empty(cur))
+	{
+		step step;
+		const char *start(begin(cur)), *const stop(end(cur));
+		step.parsed = qi::parse(start, stop, parser, step.spec);
+		if(step.parsed)
+		{
+			const auto it(specifiers.find(step.spec.name));
+			step.handler = it != end(specifiers)? it->second : nullptr;
+		}
+
+		// An escaped specifier appends the second '%' which is already
+		// adjacent to the text following it.
+		const bool escape
+		{
+			stop - start >= 2 && start[0] == SPECIFIER && start[1] == SPECIFIER
+		};
+
+		const string_view rest
+		{
+			start + (escape? 2 : 0), stop
+		};
+
+		const auto nextpos(rest.find(SPECIFIER));
+		step.text = string_view
+		{
+			start + (escape? 1 : 0), begin(rest) + std::min(nextpos, size(rest))
+		};
+
+		const string_view next
+		{
+			nextpos != rest.npos?
+				rest.substr(nextpos):
+				string_view{}
+		};
+
+		// The runtime parser makes no further progress here; any remaining
+		// arguments are ignored.
+		if(!step.parsed && !escape && begin(next) == begin(cur))
+			break;
+
+		steps.emplace_back(std::move(step));
+		cur = next;
+	}
+}
+
+const ircd::fmt::program *
+ircd::fmt::find_program(const string_view &fmt)
+{
+	const auto it
+	{
+		programs.find(data(fmt))
+	};
+
+	if(likely(it != end(programs)))
+		return it->second->format == fmt?
+			it->second.get():
+			nullptr;
+
+	if(!cache::max)
+		return nullptr;
+
+	// Programs are only referenced while their format is being executed, so
+	// the whole cache can go unless one is running further up this stack;
+	// a format from within another parses at runtime instead.
+	if(programs.size() >= size_t(cache::max) && executing)
+		return nullptr;
+
+	if(programs.size() >= size_t(cache::max))
+		programs.clear();
+
+	const auto iit
+	{
+		programs.emplace(data(fmt), std::make_unique<program>(fmt))
+	};
+
+	return iit.first->second.get();
+}
+
 void
 ircd::fmt::snprintf::append(const string_view &src)
 {
@@ -488,9 +698,28 @@ ircd::fmt::handle_specifier(mutable_buffer &out,
                             const arg &val)
 try
 {
-	const auto &type(get<1>(val));
 	const auto &handler(*specifiers.at(spec.name));
+	handle_specifier(out, idx, handler, spec, val);
+}
+catch(const std::out_of_range &e)
+{
+	throw invalid_format
+	{
+		"Unhandled specifier `%s' for argument #%u in format string",
+		spec.name,
+		idx
+	};
+}
 
+void
+ircd::fmt::handle_specifier(mutable_buffer &out,
+                            const uint &idx,
+                            const specifier &handler,
+                            const spec &spec,
+                            const arg &val)
+try
+{
+	const auto &type(get<1>(val));
 	auto &outp(std::get<0>(out));
 	assert(size(out));
 	const size_t max
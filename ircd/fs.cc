@@ -589,6 +589,38 @@ ircd::fs::fincore(const fd &fd,
 	return fincore(map, map_size, reinterpret_cast<uint8_t *>(vec), vec_size);
 }
 
+bool
+ircd::fs::fincore(const const_buffer &map)
+{
+	const uintptr_t stop
+	{
+		uintptr_t(data(map)) + size(map)
+	};
+
+	uintptr_t start
+	{
+		uintptr_t(data(map)) & ~uintptr_t(info::page_size - 1)
+	};
+
+	thread_local std::array<uint8_t, 256> vec;
+	while(start < stop)
+	{
+		const size_t pages
+		{
+			std::min((stop - start + info::page_size - 1) / info::page_size, vec.size())
+		};
+
+		syscall(::mincore, reinterpret_cast<void *>(start), pages * info::page_size, vec.data());
+		for(size_t i(0); i < pages; ++i)
+			if(!(vec[i] & 0x01))
+				return false;
+
+		start += pages * info::page_size;
+	}
+
+	return true;
+}
+
 bool
 ircd::fs::fincore(void *const &map,
                   const size_t &map_size,
@@ -1419,6 +1451,97 @@ ircd::fs::iou::enable
 	{ "persist",  false                 },
 };
 
+decltype(ircd::fs::iou::submit_coalesce)
+ircd::fs::iou::submit_coalesce
+{
+	{ "name",     "ircd.fs.iou.submit.coalesce"  },
+	{ "default",  true                           },
+	{ "description",
+
+	R"(
+	Requests made by any context are written to the submission ring but the
+	kernel is entered once for all of them when the event loop comes around,
+	rather than once per request. See ircd.fs.aio.submit.coalesce.
+	)"}
+};
+
+decltype(ircd::fs::iou::sqpoll_enable)
+ircd::fs::iou::sqpoll_enable
+{
+	{ "name",     "ircd.fs.iou.sqpoll.enable"  },
+	{ "default",  false                        },
+	{ "persist",  false                        },
+	{ "description",
+
+	R"(
+	Create the ring with a kernel thread polling the submission queue, so
+	requests are picked up without any system call while it is awake. The
+	thread costs a core while spinning. Requires Linux 5.11; takes effect at
+	startup.
+	)"}
+};
+
+decltype(ircd::fs::iou::sqpoll_idle)
+ircd::fs::iou::sqpoll_idle
+{
+	{ "name",     "ircd.fs.iou.sqpoll.idle"  },
+	{ "default",  50L                        },
+	{ "persist",  false                      },
+};
+
+decltype(ircd::fs::iou::buffers_enable)
+ircd::fs::iou::buffers_enable
+{
+	{ "name",     "ircd.fs.iou.buffers.enable"  },
+	{ "default",  true                          },
+	{ "description",
+
+	R"(
+	Small reads are made into a pool of buffers registered with the ring
+	(READ_FIXED) and copied out on completion, so the kernel does not map and
+	pin the user's pages for each request. The pool is registered at startup;
+	this item can be toggled at runtime to bypass it.
+	)"}
+};
+
+decltype(ircd::fs::iou::buffers_count)
+ircd::fs::iou::buffers_count
+{
+	{ "name",     "ircd.fs.iou.buffers.count"  },
+	{ "default",  64L                          },
+	{ "persist",  false                        },
+};
+
+decltype(ircd::fs::iou::buffers_size)
+ircd::fs::iou::buffers_size
+{
+	{ "name",     "ircd.fs.iou.buffers.size"  },
+	{ "default",  long(16_KiB)                },
+	{ "persist",  false                       },
+};
+
+decltype(ircd::fs::iou::files_enable)
+ircd::fs::iou::files_enable
+{
+	{ "name",     "ircd.fs.iou.files.enable"  },
+	{ "default",  true                        },
+	{ "description",
+
+	R"(
+	Add the descriptors of files read through the ring to its registered file
+	table on first use (e.g. open SST files) so requests skip the per-request
+	file lookup and reference counting. Can be toggled at runtime.
+	)"}
+};
+
+decltype(ircd::fs::iou::files_max)
+ircd::fs::iou::files_max
+{
+	{ "name",     "ircd.fs.iou.files.max"  },
+	{ "default",  1024L                    },
+	{ "persist",  false                    },
+};
+
 /// Global stats structure
 decltype(ircd::fs::iou::stats)
 ircd::fs::iou::stats;
@@ -1739,6 +1862,13 @@ noexcept
 ircd::fs::fd::~fd()
 noexcept
 {
+	// The number can be reused for another file once closed; it has to leave
+	// the ring's registered file table first.
+	#ifdef IRCD_USE_IOU
+	if(iou::system && fdno >= 0)
+		iou::system->file_close(fdno);
+	#endif
+
 	if(likely(fdno >= 0)) try
 	{
 		syscall(::close, fdno);
@@ -1758,6 +1888,11 @@ int
 ircd::fs::fd::release()
 noexcept
 {
+	#ifdef IRCD_USE_IOU
+	if(iou::system && this->fdno >= 0)
+		iou::system->file_close(this->fdno);
+	#endif
+
 	const int fdno(this->fdno);
 	this->fdno = -1;
 	return fdno;
@@ -45,18 +45,43 @@ ircd::fs::iou::init::init()
 	if(!iou::enable)
 		return;
 
-	system = new struct iou::system
-	(
-		size_t(max_events),
-		size_t(max_submit)
-	);
+	if(!iou::support)
+		return;
+
+	// Failing to establish the ring is not fatal; fs::aio::init follows this
+	// and will serve as the fallback.
+	try
+	{
+		system = new struct iou::system
+		(
+			size_t(max_events),
+			size_t(max_submit)
+		);
+	}
+	catch(const std::exception &e)
+	{
+		log::warning
+		{
+			log, "io_uring not available; falling back :%s",
+			e.what(),
+		};
+
+		system = nullptr;
+	}
 }
 
 ircd::fs::iou::init::~init()
 noexcept
 {
+	// Null the instance before destruction so descriptors closed meanwhile
+	// (including the ring's own) don't reach the registered file table.
+	auto *const system
+	{
+		iou::system
+	};
+
+	iou::system = nullptr;
 	delete system;
-	system = nullptr;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -85,6 +110,7 @@ ircd::fs::iou::translate(const int &val)
 	return op::NOOP;
 }
 
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // fs/iou.h
@@ -93,73 +119,85 @@ ircd::fs::iou::translate(const int &val)
 size_t
 ircd::fs::iou::count(const op &op)
 {
-	return 0;
+	return count(state::QUEUED, op);
 }
 
 size_t
 ircd::fs::iou::count(const state &state)
 {
-	return 0;
+	size_t ret(0);
+	for_each(state, [&ret]
+	(const request &request)
+	{
+		++ret;
+		return true;
+	});
+
+	return ret;
 }
 
 size_t
 ircd::fs::iou::count(const state &state,
                      const op &op)
 {
-	return 0;
+	size_t ret(0);
+	for_each(state, [&ret, &op]
+	(const request &request)
+	{
+		ret += request.op == op;
+		return true;
+	});
+
+	return ret;
 }
 
+/// Only requests in our userspace queue can be iterated; once submitted they
+/// are referenced only by the kernel until their completion is reaped.
 bool
 ircd::fs::iou::for_each(const state &state,
                         const std::function<bool (const request &)> &closure)
 {
 	assert(system);
+	if(state != state::QUEUED)
+		return true;
+
+	for(size_t i(0); i < system->qcount; ++i)
+		if(!closure(*system->queue.at(i)))
+			return false;
+
 	return true;
 }
 
 bool
 ircd::fs::iou::for_each(const std::function<bool (const request &)> &closure)
 {
-	assert(system);
-	return true;
+	return for_each(state::QUEUED, closure);
 }
 
 struct ::io_uring_sqe &
 ircd::fs::iou::sqe(request &request)
 {
 	assert(system);
-	::io_uring_sqe *const ret
-	{
-		nullptr
-	};
-
-	if(request.id < 0)
+	if(request.id < 0 || request.status != state::SUBMITTED)
 		throw std::out_of_range
 		{
 			"request has no entry on the submit queue."
 		};
 
-	assert(ret);
-	return *ret;
+	return system->sqe[request.id];
 }
 
 const struct ::io_uring_sqe &
 ircd::fs::iou::sqe(const request &request)
 {
 	assert(system);
-	const ::io_uring_sqe *const ret
-	{
-		nullptr
-	};
-
-	if(request.id < 0)
+	if(request.id < 0 || request.status != state::SUBMITTED)
 		throw std::out_of_range
 		{
 			"request has no entry on the submit queue."
 		};
 
-	assert(ret);
-	return *ret;
+	return system->sqe[request.id];
 }
 
 ircd::string_view
@@ -180,10 +218,85 @@ ircd::fs::iou::reflect(const state &s)
 ircd::fs::const_iovec_view
 ircd::fs::iou::iovec(const request &request)
 {
-	return
+	return request.iov;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// fs_iou.h
+//
+
+void
+ircd::fs::iou::fsync(const fd &fd,
+                     const sync_opts &opts)
+{
+	assert(opts.op == op::SYNC);
+	iou::request request
+	{
+		fd, {}, &opts
+	};
+
+	request();
+}
+
+size_t
+ircd::fs::iou::read(const fd &fd,
+                    const const_iovec_view &bufs,
+                    const read_opts &opts)
+{
+	assert(opts.op == op::READ);
+	iou::request request
 	{
-		//reinterpret_cast<const ::iovec *>(iou_buf), iou_nbytes
+		fd, bufs, &opts
 	};
+
+	const scope_count cur_reads{stats.cur_reads};
+	stats.max_reads = std::max(stats.max_reads, stats.cur_reads);
+
+	const size_t bytes
+	{
+		request()
+	};
+
+	stats.bytes_read += bytes;
+	stats.reads++;
+	return bytes;
+}
+
+size_t
+ircd::fs::iou::write(const fd &fd,
+                     const const_iovec_view &bufs,
+                     const write_opts &opts)
+{
+	assert(opts.op == op::WRITE);
+	iou::request request
+	{
+		fd, bufs, &opts
+	};
+
+	const size_t req_bytes
+	{
+		fs::bytes(bufs)
+	};
+
+	const scope_count cur_writes{stats.cur_writes};
+	stats.max_writes = std::max(stats.max_writes, stats.cur_writes);
+
+	stats.cur_bytes_write += req_bytes;
+	const unwind dec{[&req_bytes]
+	{
+		stats.cur_bytes_write -= req_bytes;
+	}};
+
+	const size_t bytes
+	{
+		request()
+	};
+
+	assert(!opts.blocking || bytes == req_bytes);
+	stats.bytes_write += bytes;
+	stats.writes++;
+	return bytes;
 }
 
 //
@@ -199,20 +312,161 @@ ircd::fs::iou::request::request(const fs::fd &fd,
 }
 ,op
 {
-	fs::op::NOOP
+	opts? opts->op : fs::op::NOOP
+}
+,fd
+{
+	int(fd)
 }
+,iov
 {
+	iov
+}
+{
+	assert(system);
+	assert(ctx::current);
 }
 
 ircd::fs::iou::request::~request()
 noexcept
 {
+	assert(status != state::QUEUED);
+	assert(status != state::SUBMITTED);
+}
+
+/// Cancel a request. Only possible while it's still in our userspace queue;
+/// the waiter is notified directly from here.
+bool
+ircd::fs::iou::request::cancel()
+{
+	assert(system);
+	if(!system->cancel(*this))
+		return false;
+
+	stats.bytes_cancel += bytes(iov);
+	stats.cancel++;
+	return true;
+}
+
+/// Submit a request and properly yield the ircd::ctx. When this returns the
+/// result will be available or an exception will be thrown.
+size_t
+ircd::fs::iou::request::operator()()
+{
+	assert(system);
+	assert(ctx::current);
+	assert(opts);
+
+	const size_t submitted_bytes
+	{
+		bytes(iov)
+	};
+
+	stats.bytes_requests += submitted_bytes;
+	stats.requests++;
+
+	const uint16_t &curcnt(stats.requests - stats.complete);
+	stats.max_requests = std::max(stats.max_requests, curcnt);
+
+	// Wait here until there's room to submit a request
+	system->dock.wait([]
+	{
+		return system->request_avail() > 0;
+	});
+
+	system->submit(*this);
+
+	while(!wait());
+
+	assert(completed());
+	assert(res <= ssize_t(submitted_bytes));
+
+	stats.bytes_complete += submitted_bytes;
+	stats.complete++;
+
+	if(likely(res >= 0))
+		return size_t(res);
+
+	static_assert(EAGAIN == EWOULDBLOCK);
+	if(!opts->blocking && res == -EAGAIN)
+		return 0UL;
+
+	stats.errors++;
+	stats.bytes_errors += submitted_bytes;
+	thread_local char errbuf[512]; fmt::sprintf
+	{
+		errbuf, "fd:%d size:%zu off:%zd op:%u buf:%d file:%d #%d",
+		fd,
+		submitted_bytes,
+		opts->offset,
+		uint(op),
+		buf,
+		file,
+		-res,
+	};
+
+	throw std::system_error
+	{
+		ec, errbuf
+	};
+}
+
+/// Block the current context while waiting for results. See the
+/// documentation of fs::aio::request::wait(); the semantics are the same.
+bool
+ircd::fs::iou::request::wait()
+try
+{
+	waiter.wait([this]
+	{
+		return completed();
+	});
+
+	return true;
+}
+catch(...)
+{
+	if(completed())
+		throw;
+
+	if(queued())
+	{
+		cancel();
+		throw;
+	}
+
+	return false;
+}
+
+bool
+ircd::fs::iou::request::queued()
+const
+{
+	return status == state::QUEUED;
+}
+
+bool
+ircd::fs::iou::request::completed()
+const
+{
+	return status == state::COMPLETED;
 }
 
 //
 // system::system
 //
 
+namespace ircd::fs::iou
+{
+	// Before Linux 5.11 the SQPOLL thread requires every request to use a
+	// registered file, and the setup requires privilege.
+	static const bool support_sqpoll
+	{
+		info::kernel_version[0] > 5 ||
+		(info::kernel_version[0] >= 5 && info::kernel_version[1] >= 11)
+	};
+}
+
 ircd::fs::iou::system::system(const size_t &max_events,
                               const size_t &max_submit)
 try
@@ -222,7 +476,37 @@ try
 }
 ,fd
 {
-	int(syscall<__NR_io_uring_setup>(max_events, &p))
+	[this, &max_events]
+	{
+		if(iou::sqpoll_enable && iou::support_sqpoll)
+		{
+			const milliseconds &idle(iou::sqpoll_idle);
+			p.flags |= IORING_SETUP_SQPOLL;
+			p.sq_thread_idle = idle.count();
+		}
+
+		if(!iou::sqpoll_enable || iou::support_sqpoll) try
+		{
+			return int(syscall<__NR_io_uring_setup>(max_events, &p));
+		}
+		catch(const std::system_error &e)
+		{
+			if(~p.flags & IORING_SETUP_SQPOLL)
+				throw;
+
+			log::warning
+			{
+				log, "io_uring SQPOLL not available :%s", e.what()
+			};
+		}
+		else log::warning
+		{
+			log, "io_uring SQPOLL requires Linux 5.11 or later.",
+		};
+
+		p = {0};
+		return int(syscall<__NR_io_uring_setup>(max_events, &p));
+	}()
 }
 ,sq_len
 {
@@ -355,6 +639,10 @@ try
 {
 	reinterpret_cast<::io_uring_cqe *>(cq_p.get() + p.cq_off.cqes)
 }
+,queue
+{
+	std::min(max_submit?: size_t(p.sq_entries), size_t(p.sq_entries))
+}
 ,ev_count
 {
 	0
@@ -372,14 +660,36 @@ try
 	0
 }
 {
-	log::debug
+	// Completions are signaled on our eventfd which is integrated with the
+	// ircd::ios event loop in the same manner as fs::aio.
+	const int ev_fd_no
+	{
+		ev_fd.native_handle()
+	};
+
+	syscall<__NR_io_uring_register>(int(fd), IORING_REGISTER_EVENTFD, &ev_fd_no, 1);
+
+	const bool buffers
+	{
+		buf_register()
+	};
+
+	const bool files
 	{
-		log, "io_uring sq_entries:%u cq_entries:%u flags:%u sq_thread_cpu:%u sq_thread_idle:%u",
+		file_register()
+	};
+
+	log::info
+	{
+		log, "io_uring sq:%u cq:%u submit:%zu sqpoll:%b buffers:%zu:%zu files:%zu features:%x",
 		p.sq_entries,
 		p.cq_entries,
-		p.flags,
-		p.sq_thread_cpu,
-		p.sq_thread_idle,
+		this->max_submit(),
+		sqpoll(),
+		buffers? buf_iov.size() : 0UL,
+		buffers? buf_size : 0UL,
+		files? file_table.size() : 0UL,
+		p.features,
 	};
 
 	log::debug
@@ -419,8 +729,6 @@ try
 		cq_p.get(),
 		cq_len,
 	};
-
-	assert(0);
 }
 catch(const std::exception &e)
 {
@@ -435,6 +743,7 @@ catch(const std::exception &e)
 ircd::fs::iou::system::~system()
 noexcept try
 {
+	assert(qcount == 0);
 	const ctx::uninterruptible::nothrow ui;
 
 	interrupt();
@@ -483,8 +792,555 @@ ircd::fs::iou::system::wait()
 		return ev_count == uint64_t(-1);
 	});
 
+	assert(request_count() == 0);
+	return true;
+}
+
+bool
+ircd::fs::iou::system::cancel(request &request)
+{
+	if(!request.queued())
+		return false;
+
+	const auto eit
+	{
+		std::remove(begin(queue), begin(queue) + qcount, &request)
+	};
+
+	assert(std::distance(begin(queue), eit) == ssize_t(qcount - 1));
+	qcount--;
+	stats.cur_queued--;
+	dock.notify_one();
+
+	request.res = -ECANCELED;
+	request.ec = make_error_code(ECANCELED);
+	request.status = state::COMPLETED;
+	request.waiter.notify_one();
+	return true;
+}
+
+bool
+ircd::fs::iou::system::submit(request &request)
+{
+	assert(request.opts);
+	assert(qcount < queue.size());
+	assert(request_count() < max_events());
+	assert(!request.completed());
+	const ctx::critical_assertion ca;
+
+	queue.at(qcount++) = &request;
+	request.status = state::QUEUED;
+	stats.cur_queued++;
+	stats.max_queued = std::max(stats.max_queued, stats.cur_queued);
+	assert(stats.cur_queued == qcount);
+
+	// Requests from all contexts are written to the ring together by the
+	// chaser once per ios iteration unless one of these holds.
+	const bool submit_now
+	{
+		false
+		|| !iou::submit_coalesce
+		|| request.opts->nodelay
+		|| qcount >= max_submit()
+	};
+
+	if(submit_now)
+		submit();
+
+	if(qcount == 1)
+	{
+		static ios::descriptor descriptor
+		{
+			"ircd::fs::iou chase"
+		};
+
+		auto handler(std::bind(&system::chase, this));
+		ircd::post(descriptor, std::move(handler));
+	}
+
+	return true;
+}
+
+void
+ircd::fs::iou::system::chase()
+noexcept try
+{
+	if(!qcount)
+		return;
+
+	submit();
+	stats.chases++;
+	assert(!qcount);
+}
+catch(const std::exception &e)
+{
+	terminate
+	{
+		panic
+		{
+			"iou(%p) system::chase() qcount:%zu :%s", this, qcount, e.what()
+		}
+	};
+}
+
+/// Write all queued requests to the submission ring, publish them with one
+/// store of the tail, then enter the kernel once for all of them (or wake
+/// the SQPOLL thread only if it went idle).
+size_t
+ircd::fs::iou::system::submit()
+noexcept try
+{
+	assert(qcount > 0);
+	assert(in_flight + qcount <= max_events());
+	const bool idle
+	{
+		in_flight == 0
+	};
+
+	const uint32_t mask
+	{
+		*ring_mask[0]
+	};
+
+	uint32_t tail
+	{
+		*this->tail[0]
+	};
+
+	for(size_t i(0); i < qcount; ++i, ++tail)
+	{
+		auto &request(*queue.at(i));
+		const uint32_t idx
+		{
+			tail & mask
+		};
+
+		prepare(request, sqe[idx]);
+		sq[idx] = idx;
+		request.id = idx;
+		request.status = state::SUBMITTED;
+	}
+
+	__atomic_store_n(this->tail[0], tail, __ATOMIC_RELEASE);
+
+	const size_t submitted
+	{
+		qcount
+	};
+
+	in_flight += submitted;
+	qcount = 0;
+
+	stats.submits++;
+	stats.cur_queued -= submitted;
+	stats.cur_submits += submitted;
+	stats.max_submits = std::max(stats.max_submits, stats.cur_submits);
+	assert(stats.cur_queued == qcount);
+	assert(stats.cur_submits == in_flight);
+
+	if(idle && !handle_set)
+		set_handle();
+
+	enter(submitted);
+	return submitted;
+}
+catch(const std::exception &e)
+{
+	ircd::terminate{ircd::error
+	{
+		"iou(%p) system::submit() qcount:%zu :%s",
+		this,
+		qcount,
+		e.what()
+	}};
+
+	__builtin_unreachable();
+}
+
+size_t
+ircd::fs::iou::system::enter(const size_t &to_submit)
+{
+	if(sqpoll())
+	{
+		// Full barrier between publishing the tail and reading the flags;
+		// otherwise the thread can go idle unnoticed.
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if(~__atomic_load_n(flags[0], __ATOMIC_RELAXED) & IORING_SQ_NEED_WAKEUP)
+			return to_submit;
+
+		stats.wakeups++;
+		syscall<__NR_io_uring_enter>(int(fd), 0U, 0U, IORING_ENTER_SQ_WAKEUP, nullptr, 0UL);
+		return to_submit;
+	}
+
+	size_t ret(0);
+	while(ret < to_submit)
+	{
+		stats.enters++;
+		ret += syscall_nointr<__NR_io_uring_enter>(int(fd), uint(to_submit - ret), 0U, 0U, nullptr, 0UL);
+	}
+
+	return ret;
+}
+
+void
+ircd::fs::iou::system::prepare(request &request,
+                               ::io_uring_sqe &sqe)
+noexcept
+{
+	assert(request.opts);
+	const auto &opts(*request.opts);
+
+	std::memset(&sqe, 0x0, sizeof(sqe));
+	sqe.user_data = uintptr_t(&request);
+	sqe.off = opts.offset;
+
+	request.file = iou::files_enable? file_get(request.fd) : -1;
+	sqe.fd = request.file >= 0? request.file : request.fd;
+	sqe.flags |= request.file >= 0? IOSQE_FIXED_FILE : 0;
+	stats.fixed_files += request.file >= 0;
+
+	#if defined(RWF_HIPRI)
+	if(support_hipri && reqprio(opts.priority) == reqprio(opts::highest_priority))
+		sqe.rw_flags |= RWF_HIPRI;
+	#endif
+
+	switch(request.op)
+	{
+		case op::READ:
+		{
+			#if defined(RWF_NOWAIT)
+			if(support_nowait && !opts.blocking)
+				sqe.rw_flags |= RWF_NOWAIT;
+			#endif
+
+			const size_t bytes
+			{
+				fs::bytes(request.iov)
+			};
+
+			request.buf = iou::buffers_enable? buf_acquire(bytes) : -1;
+			if(request.buf >= 0)
+			{
+				sqe.opcode = IORING_OP_READ_FIXED;
+				sqe.addr = uintptr_t(buf_iov.at(request.buf).iov_base);
+				sqe.len = bytes;
+				sqe.buf_index = request.buf;
+				stats.fixed_reads++;
+				break;
+			}
+
+			sqe.opcode = IORING_OP_READV;
+			sqe.addr = uintptr_t(request.iov.data());
+			sqe.len = request.iov.size();
+			break;
+		}
+
+		case op::WRITE:
+		{
+			const auto &wopts
+			{
+				static_cast<const write_opts &>(opts)
+			};
+
+			sqe.opcode = IORING_OP_WRITEV;
+			sqe.addr = uintptr_t(request.iov.data());
+			sqe.len = request.iov.size();
+
+			#if defined(RWF_APPEND)
+			if(support_append && wopts.offset == -1)
+			{
+				sqe.off = 0;
+				sqe.rw_flags |= RWF_APPEND;
+			}
+			#endif
+
+			#if defined(RWF_DSYNC)
+			if(support_dsync && wopts.sync && !wopts.metadata)
+				sqe.rw_flags |= RWF_DSYNC;
+			#endif
+
+			#if defined(RWF_SYNC)
+			if(support_sync && wopts.sync && wopts.metadata)
+				sqe.rw_flags |= RWF_SYNC;
+			#endif
+
+			#ifdef RWF_WRITE_LIFE_SHIFT
+			if(support_rwf_write_life && wopts.write_life)
+				sqe.rw_flags |= (wopts.write_life << (RWF_WRITE_LIFE_SHIFT));
+			#endif
+			break;
+		}
+
+		case op::SYNC:
+		{
+			const auto &sopts
+			{
+				static_cast<const sync_opts &>(opts)
+			};
+
+			sqe.opcode = IORING_OP_FSYNC;
+			sqe.off = 0;
+			sqe.rw_flags = 0;
+			sqe.fsync_flags = sopts.metadata? 0U : IORING_FSYNC_DATASYNC;
+			break;
+		}
+
+		default:
+			sqe.opcode = IORING_OP_NOP;
+			break;
+	}
+}
+
+//
+// registered buffers
+//
+
+bool
+ircd::fs::iou::system::buf_register()
+try
+{
+	const size_t count
+	{
+		std::min(size_t(iou::buffers_count), size_t(UINT16_MAX))
+	};
+
+	const size_t size
+	{
+		(size_t(iou::buffers_size) + info::page_size - 1) / info::page_size * info::page_size
+	};
+
+	if(!count || !size)
+		return false;
+
+	buf_pool = unique_mutable_buffer
+	{
+		count * size, info::page_size
+	};
+
+	buf_iov.resize(count);
+	buf_free.resize(count);
+	for(size_t i(0); i < count; ++i)
+	{
+		buf_iov[i].iov_base = data(buf_pool) + i * size;
+		buf_iov[i].iov_len = size;
+		buf_free[i] = count - i - 1;
+	}
+
+	syscall<__NR_io_uring_register>(int(fd), IORING_REGISTER_BUFFERS, buf_iov.data(), uint(count));
+	buf_size = size;
 	return true;
 }
+catch(const std::exception &e)
+{
+	// Commonly ENOMEM from RLIMIT_MEMLOCK; reads just use READV instead.
+	log::warning
+	{
+		log, "io_uring registered buffers not available :%s",
+		e.what(),
+	};
+
+	buf_size = 0;
+	buf_free.clear();
+	buf_iov.clear();
+	buf_pool = {};
+	return false;
+}
+
+int32_t
+ircd::fs::iou::system::buf_acquire(const size_t &bytes)
+noexcept
+{
+	if(!buf_size || bytes > buf_size)
+		return -1;
+
+	if(unlikely(buf_free.empty()))
+	{
+		stats.fixed_misses++;
+		return -1;
+	}
+
+	const auto ret(buf_free.back());
+	buf_free.pop_back();
+	return ret;
+}
+
+void
+ircd::fs::iou::system::buf_release(request &request)
+noexcept
+{
+	assert(request.buf >= 0);
+	assert(size_t(request.buf) < buf_iov.size());
+	buf_free.emplace_back(request.buf);
+	request.buf = -1;
+}
+
+void
+ircd::fs::iou::system::buf_copyout(request &request)
+noexcept
+{
+	assert(request.buf >= 0);
+	assert(request.res >= 0);
+	const auto &src
+	{
+		buf_iov.at(request.buf)
+	};
+
+	size_t off(0);
+	const size_t max(std::min(size_t(request.res), src.iov_len));
+	for(const auto &iov : request.iov)
+	{
+		const size_t len
+		{
+			std::min(iov.iov_len, max - off)
+		};
+
+		std::memcpy(iov.iov_base, reinterpret_cast<const char *>(src.iov_base) + off, len);
+		off += len;
+		if(off >= max)
+			break;
+	}
+}
+
+//
+// registered files
+//
+
+bool
+ircd::fs::iou::system::file_register()
+try
+{
+	const size_t count
+	{
+		files_max
+	};
+
+	if(!count)
+		return false;
+
+	file_table.assign(count, -1);
+	file_free.resize(count);
+	for(size_t i(0); i < count; ++i)
+		file_free[i] = count - i - 1;
+
+	// A sparse table; descriptors are added by file_get() on first use.
+	syscall<__NR_io_uring_register>(int(fd), IORING_REGISTER_FILES, file_table.data(), uint(count));
+	return true;
+}
+catch(const std::exception &e)
+{
+	log::warning
+	{
+		log, "io_uring registered files not available :%s",
+		e.what(),
+	};
+
+	file_table.clear();
+	file_free.clear();
+	return false;
+}
+
+int32_t
+ircd::fs::iou::system::file_get(const int &fd)
+noexcept try
+{
+	if(file_table.empty() || fd < 0)
+		return -1;
+
+	const auto it
+	{
+		file_slot.find(fd)
+	};
+
+	if(it != end(file_slot))
+		return it->second;
+
+	if(file_free.empty())
+		return -1;
+
+	const uint32_t slot
+	{
+		file_free.back()
+	};
+
+	int32_t fds[1]
+	{
+		fd
+	};
+
+	struct ::io_uring_files_update update {0};
+	update.offset = slot;
+	update.fds = uintptr_t(fds);
+	syscall<__NR_io_uring_register>(int(this->fd), IORING_REGISTER_FILES_UPDATE, &update, 1);
+
+	file_free.pop_back();
+	file_table.at(slot) = fd;
+	file_slot.emplace(fd, slot);
+	stats.file_registers++;
+	return slot;
+}
+catch(const std::exception &e)
+{
+	// Updating the table requires Linux 5.5; stop trying.
+	log::warning
+	{
+		log, "io_uring registered files disabled; fd:%d :%s",
+		fd,
+		e.what(),
+	};
+
+	file_table.clear();
+	file_free.clear();
+	file_slot.clear();
+	return -1;
+}
+
+void
+ircd::fs::iou::system::file_close(const int &fd)
+noexcept try
+{
+	const auto it
+	{
+		file_slot.find(fd)
+	};
+
+	if(it == end(file_slot))
+		return;
+
+	const uint32_t slot
+	{
+		it->second
+	};
+
+	file_slot.erase(it);
+	file_table.at(slot) = -1;
+
+	int32_t fds[1]
+	{
+		-1
+	};
+
+	struct ::io_uring_files_update update {0};
+	update.offset = slot;
+	update.fds = uintptr_t(fds);
+	syscall<__NR_io_uring_register>(int(this->fd), IORING_REGISTER_FILES_UPDATE, &update, 1);
+
+	file_free.emplace_back(slot);
+	stats.file_unregisters++;
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "io_uring failed to unregister fd:%d :%s",
+		fd,
+		e.what(),
+	};
+}
+
+//
+// system::handle
+//
 
 void
 ircd::fs::iou::system::set_handle()
@@ -537,7 +1393,10 @@ ircd::fs::iou::system::handle_descriptor
 	},
 
 	// no deallocation; satisfied by class member unique_ptr
-	[](auto &handler, void *const &ptr, const auto &size) {}
+	[](auto &handler, void *const &ptr, const auto &size) {},
+
+	// continuation
+	true,
 };
 
 /// Handle notifications that requests are complete.
@@ -571,7 +1430,8 @@ noexcept try
 			__builtin_unreachable();
 	}
 
-	set_handle();
+	if(in_flight > 0 && !handle_set)
+		set_handle();
 }
 catch(const ctx::interrupted &)
 {
@@ -590,7 +1450,38 @@ noexcept try
 {
 	assert(!ctx::current);
 
+	const uint32_t mask
+	{
+		*ring_mask[1]
+	};
+
+	const uint32_t tail
+	{
+		__atomic_load_n(this->tail[1], __ATOMIC_ACQUIRE)
+	};
+
+	uint32_t head
+	{
+		*this->head[1]
+	};
+
+	const size_t count
+	{
+		uint32_t(tail - head)
+	};
+
+	for(; head != tail; ++head)
+		handle_cqe(cqe[head & mask]);
 
+	// Release the entries to the kernel only after they were consumed.
+	__atomic_store_n(this->head[1], head, __ATOMIC_RELEASE);
+
+	assert(count <= in_flight);
+	in_flight -= count;
+	stats.cur_submits -= count;
+	stats.handles++;
+	if(likely(count))
+		dock.notify_one();
 }
 catch(const std::exception &e)
 {
@@ -601,3 +1492,82 @@ catch(const std::exception &e)
 		e.what()
 	};
 }
+
+void
+ircd::fs::iou::system::handle_cqe(const ::io_uring_cqe &cqe)
+noexcept try
+{
+	auto *const request
+	{
+		reinterpret_cast<iou::request *>(cqe.user_data)
+	};
+
+	assert(request);
+	assert(request->status == state::SUBMITTED);
+
+	request->res = cqe.res;
+	request->ec = cqe.res < 0?
+		make_error_code(-cqe.res):
+		std::error_code{};
+
+	// Data for a fixed read is in our buffer; it's copied to the user's
+	// buffers here before the buffer goes back to the pool.
+	if(request->buf >= 0)
+	{
+		if(cqe.res > 0)
+			buf_copyout(*request);
+
+		buf_release(*request);
+	}
+
+	request->id = -1;
+	request->status = state::COMPLETED;
+	request->waiter.notify_one();
+	stats.events++;
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "Unhandled request(%lu) cqe(%p) error: %s",
+		cqe.user_data,
+		&cqe,
+		e.what()
+	};
+}
+
+size_t
+ircd::fs::iou::system::request_avail()
+const
+{
+	assert(request_count() <= max_events());
+	return max_events() - request_count();
+}
+
+size_t
+ircd::fs::iou::system::request_count()
+const
+{
+	return qcount + in_flight;
+}
+
+size_t
+ircd::fs::iou::system::max_submit()
+const
+{
+	return queue.size();
+}
+
+size_t
+ircd::fs::iou::system::max_events()
+const
+{
+	return p.sq_entries;
+}
+
+bool
+ircd::fs::iou::system::sqpoll()
+const
+{
+	return p.flags & IORING_SETUP_SQPOLL;
+}
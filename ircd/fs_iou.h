@@ -22,6 +22,37 @@ namespace ircd::fs::iou
 	void fsync(const fd &, const sync_opts &);
 }
 
+/// Generic request control block.
+struct ircd::fs::iou::request
+{
+	const fs::opts *opts {nullptr};
+	fs::op op {fs::op::NOOP};
+	std::error_code ec;
+	int32_t res {-1};
+	int32_t id {-1};
+	int fd {-1};
+	const_iovec_view iov;
+	int32_t buf {-1};                  // registered buffer index (READ_FIXED)
+	int32_t file {-1};                 // registered file index (FIXED_FILE)
+	enum state status {state::INVALID};
+	ctx::dock waiter;
+
+  public:
+	bool completed() const;
+	bool queued() const;
+	bool wait();
+
+	size_t operator()();
+	bool cancel();
+
+	request() = default;
+	request(const fs::fd &, const const_iovec_view &, const fs::opts *const &);
+	~request() noexcept;
+};
+
+/// io_uring context instance from the system. Like fs::aio this is a
+/// singleton with an extern instance pointer at fs::iou::system maintained by
+/// fs::iou::init.
 struct ircd::fs::iou::system
 {
 	ctx::dock dock;
@@ -41,6 +72,22 @@ struct ircd::fs::iou::system
 	::io_uring_sqe *sqe;
 	::io_uring_cqe *cqe;
 
+	/// submission queue (out); written to the ring by submit().
+	std::vector<request *> queue;
+	size_t qcount {0};
+	size_t in_flight {0};
+
+	/// registered buffers; a contiguous aligned pool split into equal parts.
+	size_t buf_size {0};
+	unique_mutable_buffer buf_pool;
+	std::vector<::iovec> buf_iov;
+	std::vector<uint16_t> buf_free;
+
+	/// registered files; slot to fd and fd to slot.
+	std::vector<int32_t> file_table;
+	std::unordered_map<int, uint32_t> file_slot;
+	std::vector<uint32_t> file_free;
+
 	size_t ev_count;
 	asio::posix::stream_descriptor ev_fd;
 	bool handle_set;
@@ -48,10 +95,37 @@ struct ircd::fs::iou::system
 	std::unique_ptr<uint8_t[]> handle_data;
 	static ios::descriptor handle_descriptor;
 
+	size_t max_events() const;
+	size_t max_submit() const;
+	size_t request_count() const; // qcount + in_flight
+	size_t request_avail() const; // max_events - request_count()
+	bool sqpoll() const;
+
+	// Callback stack invoked when the eventfd is notified of completions.
+	void handle_cqe(const ::io_uring_cqe &) noexcept;
 	void handle_events() noexcept;
 	void handle(const boost::system::error_code &ec, const size_t bytes) noexcept;
 	void set_handle();
 
+	int32_t buf_acquire(const size_t &bytes) noexcept;
+	void buf_release(request &) noexcept;
+	void buf_copyout(request &) noexcept;
+	bool buf_register();
+
+	int32_t file_get(const int &fd) noexcept;
+	bool file_register();
+
+	void prepare(request &, ::io_uring_sqe &) noexcept;
+	size_t enter(const size_t &to_submit);
+	size_t submit() noexcept;
+	void chase() noexcept;
+
+	bool submit(request &);
+	bool cancel(request &);
+
+  public:
+	void file_close(const int &fd) noexcept;
+
 	bool interrupt();
 	bool wait();
 
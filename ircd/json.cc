@@ -8,11 +8,14 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
+#include <RB_INC_X86INTRIN_H
+
 namespace ircd { namespace json
 __attribute__((visibility("hidden")))
 {
 	using namespace ircd::spirit;
 
+	struct string_run;
 	struct input;
 	struct output;
 
@@ -21,6 +24,11 @@ __attribute__((visibility("hidden")))
 	struct printer extern const printer;
 
 	const size_t &error_show_max {48};
+
+	// bulk string content
+	static bool string_escaped(const char &) noexcept;
+	static const string_view &escaped(const char &) noexcept;
+	static void _escape(mutable_buffer &, const string_view &);
 }}
 
 BOOST_FUSION_ADAPT_STRUCT
@@ -37,6 +45,44 @@ BOOST_FUSION_ADAPT_STRUCT
     ( decltype(ircd::json::object::member::second),  second )
 )
 
+/// Parser primitive consuming a run of one or more characters which don't
+/// require escaping. This replaces per-character grammar iteration over the
+/// body of a string with the bulk scanner; escape sequences terminating the
+/// run are still checked by the grammar.
+struct ircd::json::string_run
+:qi::primitive_parser<string_run>
+{
+	template<class context,
+	         class it>
+	struct attribute
+	{
+		using type = unused_type;
+	};
+
+	template<class it,
+	         class context,
+	         class skipper,
+	         class attr>
+	bool parse(it &start, const it &stop, context &, const skipper &s, attr &) const
+	{
+		qi::skip_over(start, stop, s);
+		const char *const ret
+		{
+			string_scan(start, stop)
+		};
+
+		const bool consumed(ret != start);
+		start = ret;
+		return consumed;
+	}
+
+	template<class context>
+	boost::spirit::info what(context &) const
+	{
+		return boost::spirit::info("characters");
+	}
+};
+
 struct ircd::json::input
 :qi::grammar<const char *, unused_type>
 {
@@ -129,7 +175,7 @@ struct ircd::json::input
 
 	const rule<string_view> chars
 	{
-		raw[*((char_ - escaped) | (escape >> escaper_nc))]
+		raw[*(string_run{} | (escape >> escaper_nc))]
 		,"characters"
 	};
 
@@ -1380,6 +1426,20 @@ ircd::json::stack::array::append(const json::value &value)
 	});
 }
 
+void
+ircd::json::stack::array::splice(const string_view &json)
+{
+	assert(s);
+	assert(!empty(json));
+	_pre_append();
+	const unwind post{[this]
+	{
+		_post_append();
+	}};
+
+	s->append(json);
+}
+
 void
 ircd::json::stack::array::_pre_append()
 {
@@ -1561,6 +1621,20 @@ ircd::json::stack::member::append(const json::value &value)
 	});
 }
 
+void
+ircd::json::stack::member::splice(const string_view &json)
+{
+	assert(s);
+	assert(!empty(json));
+	_pre_append();
+	const unwind post{[this]
+	{
+		_post_append();
+	}};
+
+	s->append(json);
+}
+
 void
 ircd::json::stack::member::_pre_append()
 {
@@ -2438,6 +2512,95 @@ ircd::json::empty(const object &object)
 	return object.empty();
 }
 
+//
+// object::index
+//
+
+ircd::json::object::index::index(const json::object &object)
+:object{object}
+{
+	size_t capacity(INLINE_MAX);
+	for(const auto &member : object)
+	{
+		if(unlikely(_count >= capacity))
+		{
+			capacity *= 2;
+			auto arena(std::make_unique<object::member[]>(capacity));
+			std::copy(members, members + _count, arena.get());
+			member_arena = std::move(arena);
+			members = member_arena.get();
+		}
+
+		members[_count++] = member;
+	}
+
+	if(unlikely(_count > INLINE_MAX))
+	{
+		slot_arena = std::make_unique<slot[]>(_count);
+		slots = slot_arena.get();
+	}
+
+	for(size_t i(0); i < _count; ++i)
+		slots[i] = slot
+		{
+			name_hash(members[i].first), i
+		};
+
+	std::sort(slots, slots + _count, []
+	(const slot &a, const slot &b)
+	{
+		return a.hash < b.hash || (a.hash == b.hash && a.pos < b.pos);
+	});
+}
+
+ircd::string_view
+ircd::json::object::index::operator[](const string_view &key)
+const
+{
+	const auto *const member(find(key));
+	return member? member->second : string_view{};
+}
+
+ircd::string_view
+ircd::json::object::index::get(const string_view &key,
+                               const string_view &def)
+const
+{
+	return get<string_view>(key, def);
+}
+
+bool
+ircd::json::object::index::has(const string_view &key)
+const
+{
+	return find(key) != nullptr;
+}
+
+const ircd::json::object::member *
+ircd::json::object::index::find(const string_view &key)
+const
+{
+	const name_hash_t hash
+	{
+		name_hash(key)
+	};
+
+	auto it
+	{
+		std::lower_bound(slots, slots + _count, hash, []
+		(const slot &a, const name_hash_t &hash)
+		{
+			return a.hash < hash;
+		})
+	};
+
+	for(; it != slots + _count && it->hash == hash; ++it)
+		if(members[it->pos].first == key)
+			return members + it->pos;
+
+	return nullptr;
+}
+
 //
 // object
 //
@@ -3252,30 +3415,370 @@ ircd::json::operator==(const member &a, const string_view &b)
 // json/string.h
 //
 
+namespace ircd::json
+{
+	static uint _unhex(const char *, const char *const &);
+	static void _unescape_put(mutable_buffer &, const char &);
+	static void _unescape_put(mutable_buffer &, const uint32_t &codepoint);
+}
+
 ircd::const_buffer
 ircd::json::unescape(const mutable_buffer &buf,
                      const string &in)
 {
-	throw ircd::not_implemented{};
+	mutable_buffer out{buf};
+	const char *it(begin(in)), *const stop(end(in));
+	while(it != stop)
+	{
+		// Clean runs are copied in bulk; the scan only stops at escapes in a
+		// well-formed string, but other stops are passed through leniently.
+		const char *const run
+		{
+			string_scan(it, stop)
+		};
+
+		const string_view clean
+		{
+			it, run
+		};
+
+		if(unlikely(size(clean) > size(out)))
+			throw print_error
+			{
+				"Insufficient buffer to unescape string (%zu bytes remain)",
+				size(out),
+			};
+
+		consume(out, copy(out, clean));
+		if(run == stop)
+			break;
+
+		if(*run != '\\')
+		{
+			_unescape_put(out, *run);
+			it = run + 1;
+			continue;
+		}
+
+		if(unlikely(run + 1 == stop))
+			throw parse_error
+			{
+				"Unterminated escape sequence at end of string."
+			};
+
+		it = run + 2;
+		switch(run[1])
+		{
+			case '"':
+			case '\\':
+			case '/':  _unescape_put(out, run[1]);    continue;
+			case 'b':  _unescape_put(out, '\b');      continue;
+			case 'f':  _unescape_put(out, '\f');      continue;
+			case 'n':  _unescape_put(out, '\n');      continue;
+			case 'r':  _unescape_put(out, '\r');      continue;
+			case 't':  _unescape_put(out, '\t');      continue;
+			case '0':  _unescape_put(out, '\0');      continue;
+			case 'u':  break;
+			default:
+				throw parse_error
+				{
+					"Invalid escape sequence '\\%c' in string.", run[1]
+				};
+		}
+
+		uint32_t codepoint
+		{
+			_unhex(it, stop)
+		};
+
+		it += 4;
+		const bool high
+		{
+			codepoint >= 0xD800 && codepoint <= 0xDBFF
+		};
+
+		const bool paired
+		{
+			high
+			&& stop - it >= 6
+			&& it[0] == '\\'
+			&& it[1] == 'u'
+		};
+
+		const uint32_t low
+		{
+			paired? _unhex(it + 2, stop): 0U
+		};
+
+		if(paired && low >= 0xDC00 && low <= 0xDFFF)
+		{
+			codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+			it += 6;
+		}
+		else if(codepoint >= 0xD800 && codepoint <= 0xDFFF)
+			codepoint = 0xFFFD;
+
+		_unescape_put(out, codepoint);
+	}
+
+	return const_buffer
+	{
+		data(buf), data(out)
+	};
+}
+
+void
+ircd::json::_unescape_put(mutable_buffer &out,
+                          const uint32_t &cp)
+{
+	char enc[4];
+	const size_t len
+	{
+		cp < 0x80?    1UL:
+		cp < 0x800?   2UL:
+		cp < 0x10000? 3UL:
+		              4UL
+	};
+
+	switch(len)
+	{
+		case 1:
+			enc[0] = cp;
+			break;
+
+		case 2:
+			enc[0] = 0xC0 | (cp >> 6);
+			enc[1] = 0x80 | (cp & 0x3F);
+			break;
+
+		case 3:
+			enc[0] = 0xE0 | (cp >> 12);
+			enc[1] = 0x80 | ((cp >> 6) & 0x3F);
+			enc[2] = 0x80 | (cp & 0x3F);
+			break;
+
+		case 4:
+			enc[0] = 0xF0 | (cp >> 18);
+			enc[1] = 0x80 | ((cp >> 12) & 0x3F);
+			enc[2] = 0x80 | ((cp >> 6) & 0x3F);
+			enc[3] = 0x80 | (cp & 0x3F);
+			break;
+	}
+
+	for(size_t i(0); i < len; ++i)
+		_unescape_put(out, enc[i]);
+}
+
+void
+ircd::json::_unescape_put(mutable_buffer &out,
+                          const char &c)
+{
+	if(unlikely(empty(out)))
+		throw print_error
+		{
+			"Insufficient buffer to unescape string."
+		};
+
+	*begin(out) = c;
+	consume(out, 1);
+}
+
+uint
+ircd::json::_unhex(const char *it,
+                   const char *const &stop)
+{
+	if(unlikely(stop - it < 4))
+		throw parse_error
+		{
+			"Truncated unicode escape sequence in string."
+		};
+
+	uint ret(0);
+	for(const char *const end(it + 4); it != end; ++it)
+	{
+		const char &c(*it);
+		const uint nibble
+		{
+			c >= '0' && c <= '9'? uint(c - '0'):
+			c >= 'a' && c <= 'f'? uint(c - 'a' + 10):
+			c >= 'A' && c <= 'F'? uint(c - 'A' + 10):
+			                      16U
+		};
+
+		if(unlikely(nibble > 15))
+			throw parse_error
+			{
+				"Invalid hex digit '%c' in unicode escape sequence.", c
+			};
+
+		ret = (ret << 4) | nibble;
+	}
+
+	return ret;
 }
 
 ircd::json::string
 ircd::json::escape(const mutable_buffer &buf,
                    const string_view &in)
 {
-	static const printer::rule<string_view> characters
-	{
-		*(printer.character)
-	};
-
 	mutable_buffer out{buf};
-	printer(out, characters, in);
+	_escape(out, in);
 	return string_view
 	{
 		data(buf), data(out)
 	};
 }
 
+/// Copies clean runs found by the bulk scanner and substitutes the escape
+/// sequences from the output grammar's table for everything else; produces
+/// output identical to printer.character over the same input.
+void
+ircd::json::_escape(mutable_buffer &out,
+                    const string_view &in)
+{
+	const auto overflow{[&out]
+	(const size_t &need)
+	{
+		throw print_panic
+		{
+			"Failed to escape string (%zu bytes required; %zu bytes in buffer)",
+			need,
+			size(out),
+		};
+	}};
+
+	const char *it(begin(in)), *const stop(end(in));
+	while(it != stop)
+	{
+		const char *const run
+		{
+			string_scan(it, stop)
+		};
+
+		const string_view clean
+		{
+			it, run
+		};
+
+		if(unlikely(size(clean) > size(out)))
+			overflow(size(clean));
+
+		consume(out, copy(out, clean));
+		if(run == stop)
+			break;
+
+		const string_view &seq
+		{
+			escaped(*run)
+		};
+
+		if(unlikely(size(seq) > size(out)))
+			overflow(size(seq));
+
+		consume(out, copy(out, seq));
+		it = run + 1;
+	}
+}
+
+size_t
+ircd::json::escaped_size(const string_view &in)
+noexcept
+{
+	size_t ret(size(in));
+	const char *it(begin(in)), *const stop(end(in));
+	for(it = string_scan(it, stop); it != stop; it = string_scan(it + 1, stop))
+		ret += size(escaped(*it)) - 1;
+
+	return ret;
+}
+
+const ircd::string_view &
+ircd::json::escaped(const char &c)
+noexcept
+{
+	static const auto table{[]
+	{
+		std::array<string_view, 256> ret;
+		for(const auto &[ch, seq] : printer.escapes)
+			ret.at(uint8_t(ch)) = seq;
+
+		return ret;
+	}()};
+
+	assert(string_escaped(c));
+	assert(!empty(table[uint8_t(c)]));
+	return table[uint8_t(c)];
+}
+
+#if defined(HAVE_X86INTRIN_H) && (defined(__AVX2__) || defined(__SSE2__))
+const char *
+ircd::json::string_scan(const char *it,
+                        const char *const stop)
+noexcept
+{
+	#if defined(__AVX2__)
+	for(; stop - it >= ssize_t(sizeof(__m256i)); it += sizeof(__m256i))
+	{
+		const __m256i lit_quote   { _mm256_set1_epi8('"')                         };
+		const __m256i lit_escape  { _mm256_set1_epi8('\\')                        };
+		const __m256i lit_ctrl    { _mm256_set1_epi8(0x1F)                        };
+		const __m256i src         { _mm256_loadu_si256((const __m256i *)it)       };
+		const __m256i is_quote    { _mm256_cmpeq_epi8(src, lit_quote)             };
+		const __m256i is_escape   { _mm256_cmpeq_epi8(src, lit_escape)            };
+		const __m256i le_ctrl     { _mm256_max_epu8(src, lit_ctrl)                };
+		const __m256i is_ctrl     { _mm256_cmpeq_epi8(le_ctrl, lit_ctrl)          };
+		const __m256i is_special  { _mm256_or_si256(is_quote, is_escape)          };
+		const __m256i match       { _mm256_or_si256(is_special, is_ctrl)          };
+		const uint32_t mask       ( _mm256_movemask_epi8(match)                   );
+		if(mask)
+			return it + __builtin_ctz(mask);
+	}
+	#endif
+
+	for(; stop - it >= ssize_t(sizeof(__m128i)); it += sizeof(__m128i))
+	{
+		const __m128i lit_quote   { _mm_set1_epi8('"')                            };
+		const __m128i lit_escape  { _mm_set1_epi8('\\')                           };
+		const __m128i lit_ctrl    { _mm_set1_epi8(0x1F)                           };
+		const __m128i src         { _mm_loadu_si128((const __m128i *)it)          };
+		const __m128i is_quote    { _mm_cmpeq_epi8(src, lit_quote)                };
+		const __m128i is_escape   { _mm_cmpeq_epi8(src, lit_escape)               };
+		const __m128i le_ctrl     { _mm_max_epu8(src, lit_ctrl)                   };
+		const __m128i is_ctrl     { _mm_cmpeq_epi8(le_ctrl, lit_ctrl)             };
+		const __m128i is_special  { _mm_or_si128(is_quote, is_escape)             };
+		const __m128i match       { _mm_or_si128(is_special, is_ctrl)             };
+		const uint32_t mask       ( _mm_movemask_epi8(match)                      );
+		if(mask)
+			return it + __builtin_ctz(mask);
+	}
+
+	for(; it != stop; ++it)
+		if(string_escaped(*it))
+			return it;
+
+	return stop;
+}
+#else
+const char *
+ircd::json::string_scan(const char *it,
+                        const char *const stop)
+noexcept
+{
+	for(; it != stop; ++it)
+		if(string_escaped(*it))
+			return it;
+
+	return stop;
+}
+#endif
+
+bool
+ircd::json::string_escaped(const char &c)
+noexcept
+{
+	return c == '"' || c == '\\' || uint8_t(c) < 0x20;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // json/value.h
@@ -3358,7 +3861,9 @@ ircd::json::stringify(mutable_buffer &buf,
 				break;
 			}
 
-			printer(buf, printer.string, sv);
+			printer(buf, printer.quote);
+			_escape(buf, sv);
+			printer(buf, printer.quote);
 			break;
 		}
 
@@ -3498,11 +4003,8 @@ ircd::json::serialized(const value &v)
 			if(v.serial)
 				return v.len;
 
-			thread_local char test_buffer[value::max_string_size];
 			const string_view sv{v.string, v.len};
-			mutable_buffer buf{test_buffer};
-			printer(buf, printer.string, sv);
-			return begin(buf) - test_buffer;
+			return 1 + escaped_size(sv) + 1;
 		}
 	};
 
@@ -38,8 +38,65 @@ namespace ircd::log
 	extern std::array<ulong, num_of<level>()> console_quiet_stderr;
 	std::ostream &out_console{std::cout};
 	std::ostream &err_console{std::cerr};
+	bool initialized;
+
+	static void write(const level &, const uint8_t &dest, const string_view &msg);
+	static void flush(const level &, const uint8_t &dest);
 }
 
+/// Asynchronous output. Messages are formatted as usual on the main thread
+/// and then copied into a ring buffer which a writer thread drains to the
+/// files and console in batches. There is a single producer (the main thread;
+/// other threads already post their messages to it) and the consumer side is
+/// serialized by the mutex, which also protects the streams while the writer
+/// is running.
+namespace ircd::log::async
+{
+	struct record;
+	struct sync;
+
+	enum dest :uint8_t
+	{
+		FILE    = 0x01,
+		STDOUT  = 0x02,
+		STDERR  = 0x04,
+	};
+
+	extern conf::item<bool> enable;
+	extern conf::item<size_t> buffer_size;
+	extern conf::item<std::string> overflow;
+	extern conf::item<milliseconds> interval;
+	extern stats::item queued;
+	extern stats::item dropped;
+	extern stats::item blocked;
+	extern stats::item synced;
+
+	unique_mutable_buffer ring;
+	std::atomic<size_t> head, tail;
+	std::atomic<bool> sleeping;
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::thread thread;
+	bool termination;
+	bool running;
+
+	static size_t drain();
+	static bool push(const level &, const uint8_t &dest, const string_view &msg);
+	static bool submit(const level &, const uint8_t &dest, const string_view &msg);
+	static void worker() noexcept;
+	static void start();
+	static void stop();
+}
+
+/// Holding this on the main thread excludes the writer thread from the
+/// streams, after anything it had pending has been written out.
+struct ircd::log::async::sync
+{
+	std::unique_lock<std::mutex> lock;
+
+	sync();
+};
+
 struct ircd::log::confs
 {
 	conf::item<bool> file_enable;
@@ -120,6 +177,10 @@ ircd::log::init()
 	if(!ircd::debugmode)
 		console_disable(level::DEBUG);
 
+	initialized = true;
+	if(async::enable)
+		async::start();
+
 	if(ircd::write_avoid)
 		return;
 
@@ -129,6 +190,8 @@ ircd::log::init()
 void
 ircd::log::fini()
 {
+	initialized = false;
+	async::stop();
 	flush();
 	close();
 }
@@ -154,6 +217,7 @@ ircd::log::mkdir()
 void
 ircd::log::open()
 {
+	const async::sync sync;
 	for_each<level>([](const level &lev)
 	{
 		if(lev > RB_LOG_LEVEL)
@@ -175,6 +239,7 @@ ircd::log::open()
 void
 ircd::log::close()
 {
+	const async::sync sync;
 	for_each<level>([](const level &lev)
 	{
 		if(lev > RB_LOG_LEVEL)
@@ -188,6 +253,7 @@ ircd::log::close()
 void
 ircd::log::flush()
 {
+	const async::sync sync;
 	for_each<level>([](const level &lev)
 	{
 		if(lev > RB_LOG_LEVEL)
@@ -661,9 +727,10 @@ noexcept
 	if(!copy_to_file || !msg)
 		return;
 
-	file[lev].clear();
-	check(file[lev]);
-	file[lev].write(data(msg), size(msg));
+	if(async::submit(lev, async::FILE, msg))
+		return;
+
+	write(lev, async::FILE, msg);
 	if(conf.file_flush)
 		std::flush(file[lev]);
 }
@@ -702,23 +769,394 @@ noexcept
 	if((!copy_to_stdout && !copy_to_stderr) || !msg)
 		return;
 
-	if(unlikely(copy_to_stderr))
+	const uint8_t dest
+	{
+		uint8_t((copy_to_stdout? async::STDOUT : 0) | (copy_to_stderr? async::STDERR : 0))
+	};
+
+	if(async::submit(lev, dest, msg))
+		return;
+
+	write(lev, dest, msg);
+	if(copy_to_stdout && conf.console_flush)
+		std::flush(out_console);
+}
+
+void
+ircd::log::write(const level &lev,
+                 const uint8_t &dest,
+                 const string_view &msg)
+{
+	if(dest & async::FILE)
+	{
+		file[lev].clear();
+		check(file[lev]);
+		file[lev].write(data(msg), size(msg));
+	}
+
+	if(unlikely(dest & async::STDERR))
 	{
 		err_console.clear();
 		check(err_console);
 		err_console.write(data(msg), size(msg));
 	}
 
-	if(likely(copy_to_stdout))
+	if(likely(dest & async::STDOUT))
 	{
 		out_console.clear();
 		check(out_console);
 		out_console.write(data(msg), size(msg));
-		if(conf.console_flush)
-			std::flush(out_console);
 	}
 }
 
+void
+ircd::log::flush(const level &lev,
+                 const uint8_t &dest)
+{
+	const auto &conf
+	{
+		confs.at(lev)
+	};
+
+	if((dest & async::FILE) && conf.file_flush)
+		std::flush(file[lev]);
+
+	if((dest & async::STDOUT) && conf.console_flush)
+		std::flush(out_console);
+}
+
+//
+// async
+//
+
+/// Record header in the ring; the message follows it. A record with no
+/// destination is padding to skip at the end of the ring.
+struct ircd::log::async::record
+{
+	uint32_t len;
+	uint8_t lev;
+	uint8_t dest;
+	uint16_t _pad_;
+};
+
+decltype(ircd::log::async::enable)
+ircd::log::async::enable
+{
+	{
+		{ "name",     "ircd.log.async.enable" },
+		{ "default",  false                   },
+	}, []
+	{
+		if(!initialized)
+			return;
+
+		if(enable)
+			start();
+		else
+			stop();
+	}
+};
+
+decltype(ircd::log::async::buffer_size)
+ircd::log::async::buffer_size
+{
+	{ "name",     "ircd.log.async.buffer.size" },
+	{ "default",  long(1_MiB)                  },
+};
+
+/// Policy when the ring is full. "drop" discards the message and counts it;
+/// "block" drains the ring and writes the message on the main thread.
+decltype(ircd::log::async::overflow)
+ircd::log::async::overflow
+{
+	{ "name",     "ircd.log.async.overflow" },
+	{ "default",  "drop"                    },
+};
+
+/// Upper bound on how long the writer sleeps when it has nothing to do.
+decltype(ircd::log::async::interval)
+ircd::log::async::interval
+{
+	{ "name",     "ircd.log.async.interval" },
+	{ "default",  100L                      },
+};
+
+decltype(ircd::log::async::queued)
+ircd::log::async::queued
+{
+	{ "name", "ircd.log.async.queued" },
+};
+
+decltype(ircd::log::async::dropped)
+ircd::log::async::dropped
+{
+	{ "name", "ircd.log.async.dropped" },
+};
+
+decltype(ircd::log::async::blocked)
+ircd::log::async::blocked
+{
+	{ "name", "ircd.log.async.blocked" },
+};
+
+decltype(ircd::log::async::synced)
+ircd::log::async::synced
+{
+	{ "name", "ircd.log.async.synced" },
+};
+
+ircd::log::async::sync::sync()
+:lock
+{
+	mutex, std::defer_lock
+}
+{
+	if(!running)
+		return;
+
+	lock.lock();
+	drain();
+}
+
+void
+ircd::log::async::start()
+{
+	if(running)
+		return;
+
+	const size_t size
+	{
+		std::max((size_t(buffer_size) + 7UL) & ~7UL, size_t(64_KiB))
+	};
+
+	ring = unique_mutable_buffer
+	{
+		size, 64
+	};
+
+	head = 0;
+	tail = 0;
+	sleeping = false;
+	termination = false;
+	thread = std::thread(&worker);
+	running = true;
+}
+
+void
+ircd::log::async::stop()
+{
+	if(!running)
+		return;
+
+	{
+		const std::lock_guard lock
+		{
+			mutex
+		};
+
+		termination = true;
+		cond.notify_all();
+	}
+
+	thread.join();
+	running = false;
+	assert(head == tail);
+	ring = {};
+}
+
+void
+ircd::log::async::worker()
+noexcept try
+{
+	std::unique_lock lock
+	{
+		mutex
+	};
+
+	while(!termination)
+	{
+		if(drain())
+			continue;
+
+		// The producer only signals when it sees this flag; the timed wait
+		// bounds the delay if that races with our check of the ring.
+		sleeping.store(true, std::memory_order_seq_cst);
+		if(head.load(std::memory_order_seq_cst) != tail.load(std::memory_order_relaxed))
+		{
+			sleeping.store(false, std::memory_order_relaxed);
+			continue;
+		}
+
+		const milliseconds interval(async::interval);
+		cond.wait_for(lock, interval);
+		sleeping.store(false, std::memory_order_relaxed);
+	}
+
+	drain();
+}
+catch(const std::exception &e)
+{
+	fprintf(stderr, "log writer thread fatal: %s\n", e.what());
+	fflush(stderr);
+	ircd::terminate();
+}
+
+/// Write out everything in the ring. The caller holds the mutex. Streams
+/// are flushed once per batch according to the same confs as the
+/// synchronous path.
+size_t
+ircd::log::async::drain()
+{
+	const auto cap
+	{
+		size(ring)
+	};
+
+	const auto buf
+	{
+		data(ring)
+	};
+
+	const size_t head
+	{
+		async::head.load(std::memory_order_acquire)
+	};
+
+	size_t tail
+	{
+		async::tail.load(std::memory_order_relaxed)
+	};
+
+	size_t ret(0);
+	std::array<uint8_t, num_of<level>()> flushes {0};
+	while(tail != head)
+	{
+		const auto &rec
+		{
+			*reinterpret_cast<const record *>(buf + tail % cap)
+		};
+
+		if(likely(rec.dest))
+		{
+			const auto lev(level(rec.lev));
+			const string_view msg
+			{
+				buf + tail % cap + sizeof(record), rec.len
+			};
+
+			write(lev, rec.dest, msg);
+			flushes.at(lev) |= rec.dest;
+			++ret;
+		}
+
+		tail += (sizeof(record) + rec.len + 7UL) & ~7UL;
+	}
+
+	for(size_t i(0); i < flushes.size(); ++i)
+		if(flushes[i])
+			flush(level(i), flushes[i]);
+
+	async::tail.store(tail, std::memory_order_release);
+	return ret;
+}
+
+/// Copy the message into the ring; false if it doesn't fit.
+bool
+ircd::log::async::push(const level &lev,
+                       const uint8_t &dest,
+                       const string_view &msg)
+{
+	const auto cap
+	{
+		size(ring)
+	};
+
+	const auto buf
+	{
+		data(ring)
+	};
+
+	const size_t need
+	{
+		(sizeof(record) + size(msg) + 7UL) & ~7UL
+	};
+
+	const size_t head
+	{
+		async::head.load(std::memory_order_relaxed)
+	};
+
+	const size_t tail
+	{
+		async::tail.load(std::memory_order_acquire)
+	};
+
+	// A record is never split; the remainder at the end of the ring is
+	// skipped with a padding record.
+	const size_t pos(head % cap);
+	const size_t gap
+	{
+		cap - pos < need? cap - pos: 0
+	};
+
+	if(cap - (head - tail) < need + gap)
+		return false;
+
+	if(gap)
+		new (buf + pos) record
+		{
+			uint32_t(gap - sizeof(record)), 0, 0, 0
+		};
+
+	const size_t at((head + gap) % cap);
+	new (buf + at) record
+	{
+		uint32_t(size(msg)), uint8_t(lev), dest, 0
+	};
+
+	std::memcpy(buf + at + sizeof(record), data(msg), size(msg));
+	async::head.store(head + gap + need, std::memory_order_seq_cst);
+	if(sleeping.load(std::memory_order_seq_cst) && sleeping.exchange(false))
+		cond.notify_one();
+
+	return true;
+}
+
+/// Hand the message to the writer thread. False if async output is not
+/// running and the caller should write it. CRITICAL messages are written
+/// synchronously, in order after anything pending.
+bool
+ircd::log::async::submit(const level &lev,
+                         const uint8_t &dest,
+                         const string_view &msg)
+{
+	if(!running)
+		return false;
+
+	if(likely(lev != level::CRITICAL))
+	{
+		if(likely(push(lev, dest, msg)))
+		{
+			++queued;
+			return true;
+		}
+
+		if(string_view(overflow) != "block")
+		{
+			++dropped;
+			return true;
+		}
+
+		++blocked;
+	}
+	else ++synced;
+
+	const sync sync;
+	write(lev, dest, msg);
+	flush(lev, dest);
+	return true;
+}
+
 //
 // ircd::log util
 //
@@ -544,6 +544,14 @@ ircd::m::sync::stats_info
 	{ "default",  false                    },
 };
 
+/// Prefetches made while a client waits on its sync are taken by the
+/// prefetcher ahead of bulk work.
+decltype(ircd::m::sync::prefetch_opts)
+ircd::m::sync::prefetch_opts
+{
+	db::gopts{db::get::PRIO_HIGH}
+};
+
 template<>
 decltype(ircd::util::instance_multimap<std::string, ircd::m::sync::item, std::less<>>::map)
 ircd::util::instance_multimap<std::string, ircd::m::sync::item, std::less<>>::map
@@ -1135,6 +1143,159 @@ ircd::m::vm::reflect(const enum fault &code)
 	return "??????";
 }
 
+ircd::string_view
+ircd::m::vm::reflect(const enum stage &stage)
+{
+	switch(stage)
+	{
+		case stage::CONFORM:          return "conform";
+		case stage::ACCESS:           return "access";
+		case stage::VERIFY:           return "verify";
+		case stage::FETCH:            return "fetch";
+		case stage::AUTH_STATIC:      return "auth_static";
+		case stage::SEQUENCE:         return "sequence";
+		case stage::AUTH_RELATIVE:    return "auth_relative";
+		case stage::COMMITTING:       return "committing";
+		case stage::AUTH_PRESENT:     return "auth_present";
+		case stage::EVAL:             return "eval";
+		case stage::WRITE_PREPARE:    return "write_prepare";
+		case stage::WRITE_APPEND:     return "write_append";
+		case stage::POST:             return "post";
+		case stage::WRITE_COMMIT:     return "write_commit";
+		case stage::RETIRE:           return "retire";
+		case stage::_NUM_:            break;
+	}
+
+	return "??????";
+}
+
+//
+// timing
+//
+
+decltype(ircd::m::vm::timing::enable)
+ircd::m::vm::timing::enable
+{
+	{ "name",     "ircd.m.vm.timing.enable" },
+	{ "default",  true                      },
+};
+
+decltype(ircd::m::vm::timing::slow_threshold)
+ircd::m::vm::timing::slow_threshold
+{
+	{ "name",     "ircd.m.vm.timing.slow.threshold" },
+	{ "default",  1000L                             },
+	{ "description",
+
+	R"(
+	Evaluations taking longer than this many milliseconds are retained in
+	the ring of slow evaluations with their per-stage timing.
+	)"}
+};
+
+decltype(ircd::m::vm::timing::slow_max)
+ircd::m::vm::timing::slow_max
+{
+	{ "name",     "ircd.m.vm.timing.slow.max" },
+	{ "default",  64L                         },
+};
+
+decltype(ircd::m::vm::timing::slow)
+ircd::m::vm::timing::slow;
+
+decltype(ircd::m::vm::timing::counters)
+ircd::m::vm::timing::counters
+{[]
+{
+	decltype(counters) ret;
+	for(size_t i(0); i < ret.size(); ++i)
+		ret[i] = std::make_unique<counter>(stage(i));
+
+	return ret;
+}()};
+
+ircd::m::vm::timing::timing()
+:last
+{
+	enable? prof::cycles() : 0UL
+}
+{
+}
+
+/// Called from the unwind of an eval, during which nothing may propagate.
+void
+ircd::m::vm::timing::commit(const event &event,
+                            const microseconds &elapsed)
+noexcept try
+{
+	if(!last)
+		return;
+
+	// Stages past the last one reached weren't run; a zero sample for them
+	// would only drag down their histograms.
+	for(size_t i(0); i < reached; ++i)
+	{
+		auto &counter(*counters[i]);
+		counter.total += cycles[i];
+		counter.histogram(cycles[i]);
+	}
+
+	if(elapsed < milliseconds(slow_threshold) || !slow_max)
+		return;
+
+	this->event_id = event.event_id;
+	this->elapsed = elapsed;
+	this->ts = ircd::time<milliseconds>();
+	strlcpy(this->type, json::get<"type"_>(event));
+
+	while(slow.size() >= size_t(slow_max))
+		slow.pop_front();
+
+	slow.emplace_back(*this);
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		log, "Failed to record timing for %s :%s",
+		string_view{event.event_id},
+		e.what(),
+	};
+}
+
+uint64_t
+ircd::m::vm::timing::total()
+const
+{
+	return std::accumulate(begin(cycles), end(cycles), uint64_t(0));
+}
+
+ircd::m::vm::timing::counter::counter(const stage &stage)
+:total
+{
+	json::members
+	{
+		{ "name", fmt::snstringf
+		{
+			stats::item::NAME_MAX_LEN, "ircd.m.vm.stage.%s.cycles.total",
+			reflect(stage),
+		}},
+	}
+}
+,histogram
+{
+	json::members
+	{
+		{ "name", fmt::snstringf
+		{
+			stats::item::NAME_MAX_LEN, "ircd.m.vm.stage.%s.cycles",
+			reflect(stage),
+		}},
+	}
+}
+{
+}
+
 //
 // Eval
 //
@@ -1375,6 +1536,66 @@ ircd::m::vm::eval::eval(const event &event,
 	operator()(event);
 }
 
+namespace ircd::m::vm
+{
+	static void fetch_keys(const vector_view<const m::event> &, const vm::opts &);
+}
+
+void
+ircd::m::vm::fetch_keys(const vector_view<const m::event> &events,
+                        const vm::opts &opts)
+try
+{
+	using prototype = size_t (const keys::queries &);
+
+	//TODO: Remove this import once this callsite is outside of libircd.
+	static mods::import<prototype> fetch
+	{
+		"m_keys", "ircd::m::keys::fetch"
+	};
+
+	std::vector<m::v1::key::server_key> queries;
+	queries.reserve(events.size());
+	for(const auto &event : events)
+		for(const auto &[server_name, signatures] : json::get<"signatures"_>(event))
+			for(const auto &[key_id, signature] : json::object(signatures))
+				if(!my_host(unquote(server_name)))
+					queries.emplace_back(unquote(server_name), unquote(key_id));
+
+	std::sort(begin(queries), end(queries));
+	queries.erase(std::unique(begin(queries), end(queries)), end(queries));
+	if(queries.empty())
+		return;
+
+	const size_t fetched
+	{
+		fetch(queries)
+	};
+
+	log::debug
+	{
+		log, "Prefetched %zu of %zu keys for %zu events",
+		fetched,
+		queries.size(),
+		events.size(),
+	};
+}
+catch(const ctx::interrupted &e)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	// This is an optimization; keys not acquired here are fetched during
+	// verification of each event.
+	log::derror
+	{
+		log, "Failed to prefetch keys for %zu events :%s",
+		events.size(),
+		e.what(),
+	};
+}
+
 ircd::m::vm::eval::eval(const json::array &pdus,
                         const vm::opts &opts)
 :opts{&opts}
@@ -1385,6 +1606,11 @@ ircd::m::vm::eval::eval(const json::array &pdus,
 	std::sort(begin(events), end(events));
 	this->pdus = events;
 
+	// Acquire all of the keys the batch will need in one pass rather than
+	// discovering them one at a time during each verification.
+	if(opts.verify && opts.fetch_keys && events.size() > 1)
+		fetch_keys(events, opts);
+
 	// Conduct each eval without letting any one exception ruin things for the
 	// others, including an interrupt. The only exception is a termination.
 	for(auto it(begin(events)); it != end(events); ++it) try
@@ -1673,6 +1899,248 @@ ircd::m::redacted::prefetch(const event::idx &event_idx)
 	return refs.prefetch(dbs::ref::M_ROOM_REDACTION);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// m/visible.h
+//
+
+namespace ircd::m
+{
+	struct visibility_cache_room
+	{
+		std::string room_id;
+		std::map<std::string, bool, std::less<>> mxid;
+	};
+
+	using visibility_cache_list = std::list<visibility_cache_room>;
+
+	static void visibility_cache_evict();
+
+	static visibility_cache_list visibility_cache_lru;
+	static std::map<string_view, visibility_cache_list::iterator, std::less<>> visibility_cache_map;
+	static std::map<std::string, event::idx, std::less<>> visibility_cache_barrier;
+	static uint64_t visibility_cache_generation;
+}
+
+decltype(ircd::m::visibility::cache::enable)
+ircd::m::visibility::cache::enable
+{
+	{ "name",     "ircd.m.visibility.cache.enable" },
+	{ "default",  true                             },
+	{ "description",
+
+	R"(
+	Remember the result of visibility tests against the present state of a
+	room for each requesting user or server until the room's
+	m.room.history_visibility or m.room.member state changes.
+	)"}
+};
+
+decltype(ircd::m::visibility::cache::max_rooms)
+ircd::m::visibility::cache::max_rooms
+{
+	{ "name",     "ircd.m.visibility.cache.max_rooms" },
+	{ "default",  4096L                               },
+};
+
+decltype(ircd::m::visibility::cache::max_room_entries)
+ircd::m::visibility::cache::max_room_entries
+{
+	{ "name",     "ircd.m.visibility.cache.max_room_entries" },
+	{ "default",  1024L                                      },
+};
+
+decltype(ircd::m::visibility::cache::hits)
+ircd::m::visibility::cache::hits
+{
+	{ "name", "ircd.m.visibility.cache.hits"                            },
+	{ "desc", "Present state visibility tests answered by the cache"    },
+};
+
+decltype(ircd::m::visibility::cache::misses)
+ircd::m::visibility::cache::misses
+{
+	{ "name", "ircd.m.visibility.cache.misses"                          },
+	{ "desc", "Present state visibility tests evaluated against state"  },
+};
+
+decltype(ircd::m::visibility::cache::invalidations)
+ircd::m::visibility::cache::invalidations
+{
+	{ "name", "ircd.m.visibility.cache.invalidations"                   },
+	{ "desc", "State writes to tracked types dropping a room's entries" },
+};
+
+bool
+ircd::m::visibility::cache::get(const m::room::id &room_id,
+                                const string_view &mxid,
+                                bool &ret)
+{
+	if(!enable)
+		return false;
+
+	const auto it
+	{
+		visibility_cache_map.find(room_id)
+	};
+
+	if(it == end(visibility_cache_map))
+	{
+		++misses;
+		return false;
+	}
+
+	const auto &room(*it->second);
+	const auto mit
+	{
+		room.mxid.find(mxid)
+	};
+
+	if(mit == end(room.mxid))
+	{
+		++misses;
+		return false;
+	}
+
+	++hits;
+	ret = mit->second;
+	visibility_cache_lru.splice(begin(visibility_cache_lru), visibility_cache_lru, it->second);
+	return true;
+}
+
+/// The generation argument is the value of generation() observed before
+/// the decision was evaluated; the decision is discarded if any tracked
+/// state was written in the meantime.
+void
+ircd::m::visibility::cache::set(const m::room::id &room_id,
+                                const string_view &mxid,
+                                const bool &value,
+                                const uint64_t &generation)
+{
+	if(!enable)
+		return;
+
+	if(generation != visibility_cache_generation)
+		return;
+
+	const auto barrier
+	{
+		visibility_cache_barrier.find(room_id)
+	};
+
+	if(barrier != end(visibility_cache_barrier))
+	{
+		if(barrier->second > vm::sequence::retired)
+			return;
+
+		visibility_cache_barrier.erase(barrier);
+	}
+
+	auto it
+	{
+		visibility_cache_map.find(room_id)
+	};
+
+	if(it == end(visibility_cache_map))
+	{
+		visibility_cache_lru.emplace_front(visibility_cache_room
+		{
+			std::string(room_id), {}
+		});
+
+		const auto &lit(begin(visibility_cache_lru));
+		it = visibility_cache_map.emplace(lit->room_id, lit).first;
+	}
+	else visibility_cache_lru.splice(begin(visibility_cache_lru), visibility_cache_lru, it->second);
+
+	auto &room(*it->second);
+	if(room.mxid.size() >= size_t(max_room_entries))
+		room.mxid.clear();
+
+	room.mxid.insert_or_assign(std::string(mxid), value);
+	visibility_cache_evict();
+}
+
+void
+ircd::m::visibility::cache::invalidate(const m::room::id &room_id,
+                                       const event::idx &sequence)
+{
+	++visibility_cache_generation;
+	if(sequence > vm::sequence::retired)
+	{
+		auto it
+		{
+			visibility_cache_barrier.lower_bound(room_id)
+		};
+
+		if(it == end(visibility_cache_barrier) || it->first != string_view{room_id})
+			it = visibility_cache_barrier.emplace_hint(it, std::string(room_id), 0UL);
+
+		it->second = std::max(it->second, sequence);
+	}
+
+	const auto it
+	{
+		visibility_cache_map.find(room_id)
+	};
+
+	if(it == end(visibility_cache_map))
+		return;
+
+	++invalidations;
+	const auto lit(it->second);
+	visibility_cache_map.erase(it);
+	visibility_cache_lru.erase(lit);
+}
+
+void
+ircd::m::visibility::cache::clear()
+noexcept
+{
+	++visibility_cache_generation;
+	visibility_cache_map.clear();
+	visibility_cache_lru.clear();
+}
+
+size_t
+ircd::m::visibility::cache::size()
+noexcept
+{
+	return visibility_cache_map.size();
+}
+
+uint64_t
+ircd::m::visibility::cache::generation()
+noexcept
+{
+	return visibility_cache_generation;
+}
+
+bool
+ircd::m::visibility::cache::tracked(const string_view &type)
+noexcept
+{
+	return type == "m.room.history_visibility"
+	    || type == "m.room.member";
+}
+
+void
+ircd::m::visibility_cache_evict()
+{
+	while(visibility_cache_map.size() > size_t(visibility::cache::max_rooms))
+	{
+		assert(!visibility_cache_lru.empty());
+		visibility_cache_map.erase(visibility_cache_lru.back().room_id);
+		visibility_cache_lru.pop_back();
+	}
+
+	for(auto it(begin(visibility_cache_barrier)); it != end(visibility_cache_barrier); )
+		if(it->second <= vm::sequence::retired)
+			it = visibility_cache_barrier.erase(it);
+		else
+			++it;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // m/presence.h
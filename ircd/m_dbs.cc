@@ -61,6 +61,16 @@ decltype(ircd::m::dbs::room_events)
 ircd::m::dbs::room_events
 {};
 
+/// Linkage for a reference to the room_type column
+decltype(ircd::m::dbs::room_type)
+ircd::m::dbs::room_type
+{};
+
+/// Linkage for a reference to the user_dir column
+decltype(ircd::m::dbs::user_dir)
+ircd::m::dbs::user_dir
+{};
+
 /// Linkage for a reference to the room_joined column
 decltype(ircd::m::dbs::room_joined)
 ircd::m::dbs::room_joined
@@ -186,9 +196,11 @@ ircd::m::dbs::init::init(const string_view &servername,
 	event_type = db::domain{*events, desc::events__event_type.name};
 	room_head = db::domain{*events, desc::events__room_head.name};
 	room_events = db::domain{*events, desc::events__room_events.name};
+	room_type = db::domain{*events, desc::events__room_type.name};
 	room_joined = db::domain{*events, desc::events__room_joined.name};
 	room_state = db::domain{*events, desc::events__room_state.name};
 	room_state_space = db::domain{*events, desc::events__room_state_space.name};
+	user_dir = db::column{*events, desc::events__user_dir.name};
 }
 
 /// Shuts down the m::dbs subsystem; closes the events database. The extern
@@ -235,12 +247,15 @@ ircd::m::dbs::write_opts::appendix_all{[]
 
 namespace ircd::m::dbs
 {
+	static void _index_user_dir(db::txn &, const db::op &, const id::user &, const id::room &, const string_view &displayname, const event::idx &);
+	static void _index_user_dir(db::txn &, const event &, const write_opts &); //query
 	static void _index_room_joined(db::txn &, const event &, const write_opts &);
 	static void _index_room_redact(db::txn &, const event &, const write_opts &); //query
 	static void _index_room_state_space(db::txn &,  const event &, const write_opts &);
 	static void _index_room_state(db::txn &, const event &, const write_opts &);
 	static void _index_room_head_resolve(db::txn &, const event &, const write_opts &);
 	static void _index_room_head(db::txn &, const event &, const write_opts &);
+	static void _index_room_type(db::txn &,  const event &, const write_opts &);
 	static void _index_room_events(db::txn &,  const event &, const write_opts &);
 	static void _index_room(db::txn &, const event &, const write_opts &);
 	static void _index_event_type(db::txn &, const event &, const write_opts &);
@@ -1202,6 +1217,9 @@ ircd::m::dbs::_index_room(db::txn &txn,
 	if(opts.appendix.test(appendix::ROOM_EVENTS))
 		_index_room_events(txn, event, opts);
 
+	if(opts.appendix.test(appendix::ROOM_TYPE))
+		_index_room_type(txn, event, opts);
+
 	if(opts.appendix.test(appendix::ROOM_HEAD))
 		_index_room_head(txn, event, opts);
 
@@ -1218,6 +1236,9 @@ ircd::m::dbs::_index_room(db::txn &txn,
 
 		if(opts.appendix.test(appendix::ROOM_JOINED) && at<"type"_>(event) == "m.room.member")
 			_index_room_joined(txn, event, opts);
+
+		if(opts.appendix.test(appendix::USER_DIR) && at<"type"_>(event) == "m.room.member")
+			_index_user_dir(txn, event, opts);
 	}
 
 	if(opts.appendix.test(appendix::ROOM_REDACT) && json::get<"type"_>(event) == "m.room.redaction")
@@ -1249,6 +1270,31 @@ ircd::m::dbs::_index_room_events(db::txn &txn,
 	};
 }
 
+/// Adds the entry for the room_type column into the txn.
+void
+ircd::m::dbs::_index_room_type(db::txn &txn,
+                               const event &event,
+                               const write_opts &opts)
+{
+	assert(opts.appendix.test(appendix::ROOM_TYPE));
+
+	thread_local char buf[ROOM_TYPE_KEY_MAX_SIZE];
+	const ctx::critical_assertion ca;
+	const string_view &key
+	{
+		room_type_key(buf, at<"room_id"_>(event), at<"type"_>(event), at<"depth"_>(event), opts.event_idx)
+	};
+
+	db::txn::append
+	{
+		txn, room_type,
+		{
+			opts.op,        // db::op
+			key,            // key,
+		}
+	};
+}
+
 void
 ircd::m::dbs::_index_room_head(db::txn &txn,
                                const event &event,
@@ -1344,6 +1390,14 @@ ircd::m::dbs::_index_room_state(db::txn &txn,
 			value_required(opts.op)? val : string_view{},
 		}
 	};
+
+	// The decoded power events for the present state of this room are now
+	// stale; entries can't be rebuilt until this write is retired.
+	if(room::auth::cache::tracked(at<"type"_>(event)))
+		room::auth::cache::invalidate(at<"room_id"_>(event), opts.event_idx);
+
+	if(visibility::cache::tracked(at<"type"_>(event)))
+		visibility::cache::invalidate(at<"room_id"_>(event), opts.event_idx);
 }
 
 void
@@ -1490,6 +1544,98 @@ ircd::m::dbs::_index_room_joined(db::txn &txn,
 	};
 }
 
+// NOTE: QUERY
+/// Adds the entries for the user_dir column into the txn. The tokens of the
+/// member's prior present state in the room are retracted first; for a join
+/// the tokens of this event are then set, superseding any retraction of the
+/// same key earlier in the batch.
+void
+ircd::m::dbs::_index_user_dir(db::txn &txn,
+                              const event &event,
+                              const write_opts &opts)
+{
+	assert(opts.appendix.test(appendix::USER_DIR));
+	assert(at<"type"_>(event) == "m.room.member");
+
+	if(!valid(id::USER, at<"state_key"_>(event)))
+		return;
+
+	const id::user &user_id
+	{
+		at<"state_key"_>(event)
+	};
+
+	const id::room &room_id
+	{
+		at<"room_id"_>(event)
+	};
+
+	const event::idx prior_idx
+	{
+		opts.op == db::op::SET && opts.allow_queries?
+			room::state(room_id).get(std::nothrow, "m.room.member", user_id):
+			0UL
+	};
+
+	if(prior_idx && prior_idx != opts.event_idx && m::membership(prior_idx, "join"))
+		m::get(std::nothrow, prior_idx, "content", [&txn, &user_id, &room_id, &prior_idx]
+		(const json::object &content)
+		{
+			const json::string &displayname
+			{
+				content.get("displayname")
+			};
+
+			_index_user_dir(txn, db::op::DELETE, user_id, room_id, displayname, prior_idx);
+		});
+
+	const json::string &displayname
+	{
+		json::get<"content"_>(event).get("displayname")
+	};
+
+	if(opts.op == db::op::DELETE)
+		_index_user_dir(txn, db::op::DELETE, user_id, room_id, displayname, opts.event_idx);
+	else if(opts.op == db::op::SET && m::membership(event) == "join")
+		_index_user_dir(txn, db::op::SET, user_id, room_id, displayname, opts.event_idx);
+}
+
+void
+ircd::m::dbs::_index_user_dir(db::txn &txn,
+                              const db::op &op,
+                              const id::user &user_id,
+                              const id::room &room_id,
+                              const string_view &displayname,
+                              const event::idx &event_idx)
+{
+	const string_view val
+	{
+		byte_view<string_view>(event_idx)
+	};
+
+	user_dir_tokens(user_id, displayname, [&txn, &op, &user_id, &room_id, &val]
+	(const string_view &token)
+	{
+		thread_local char buf[USER_DIR_KEY_MAX_SIZE];
+		const string_view &key
+		{
+			user_dir_key(buf, token, user_id, room_id)
+		};
+
+		db::txn::append
+		{
+			txn, user_dir,
+			{
+				op,
+				key,
+				value_required(op)? val : string_view{},
+			}
+		};
+
+		return true;
+	});
+}
+
 // NOTE: QUERY
 ircd::m::event::idx
 ircd::m::dbs::find_event_idx(const event::id &event_id,
@@ -1671,6 +1817,19 @@ ircd::m::dbs::desc::events__event_json__bloom__bits
 	{ "default",  9L                                         },
 };
 
+decltype(ircd::m::dbs::desc::events__event_json__mmap_reads)
+ircd::m::dbs::desc::events__event_json__mmap_reads
+{
+	{ "name",     "ircd.m.dbs.events._event_json.mmap_reads" },
+	{ "default",  false                                      },
+	{
+		"description",
+		"Serve reads of the event_json table files from a memory map when"
+		" their pages are resident. Intended for hosts where the events"
+		" database fits in RAM. This is read once when the server starts."
+	},
+};
+
 const ircd::db::descriptor
 ircd::m::dbs::desc::events__event_json
 {
@@ -1742,6 +1901,9 @@ ircd::m::dbs::desc::events__event_json
 		{      0L,   15L }, // max_bytes_for_level[5]
 		{      0L,   31L }, // max_bytes_for_level[6]
 	},
+
+	// mmap reads
+	bool(events__event_json__mmap_reads),
 };
 
 //
@@ -2914,6 +3076,265 @@ ircd::m::dbs::desc::events__room_events
 	size_t(events__room_events__meta_block__size),
 };
 
+//
+// room_type
+//
+
+decltype(ircd::m::dbs::desc::events__room_type__block__size)
+ircd::m::dbs::desc::events__room_type__block__size
+{
+	{ "name",     "ircd.m.dbs.events._room_type.block.size" },
+	{ "default",  512L                                      },
+};
+
+decltype(ircd::m::dbs::desc::events__room_type__meta_block__size)
+ircd::m::dbs::desc::events__room_type__meta_block__size
+{
+	{ "name",     "ircd.m.dbs.events._room_type.meta_block.size" },
+	{ "default",  8192L                                          },
+};
+
+decltype(ircd::m::dbs::desc::events__room_type__cache__size)
+ircd::m::dbs::desc::events__room_type__cache__size
+{
+	{
+		{ "name",     "ircd.m.dbs.events._room_type.cache.size" },
+		{ "default",  long(16_MiB)                              },
+	}, []
+	{
+		const size_t &value{events__room_type__cache__size};
+		db::capacity(db::cache(room_type), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::events__room_type__cache_comp__size)
+ircd::m::dbs::desc::events__room_type__cache_comp__size
+{
+	{
+		{ "name",     "ircd.m.dbs.events._room_type.cache_comp.size" },
+		{ "default",  long(8_MiB)                                    },
+	}, []
+	{
+		const size_t &value{events__room_type__cache_comp__size};
+		db::capacity(db::cache_compressed(room_type), value);
+	}
+};
+
+ircd::string_view
+ircd::m::dbs::room_type_key(const mutable_buffer &out_,
+                            const id::room &room_id,
+                            const string_view &type,
+                            const uint64_t &depth,
+                            const event::idx &event_idx)
+{
+	mutable_buffer out{out_};
+	consume(out, copy(out, room_id));
+	consume(out, copy(out, "\0"_sv));
+	consume(out, copy(out, type));
+	consume(out, copy(out, "\0"_sv));
+	consume(out, copy(out, byte_view<string_view>(depth)));
+	consume(out, copy(out, byte_view<string_view>(event_idx)));
+	return { data(out_), data(out) };
+}
+
+ircd::m::dbs::room_type_key_parts
+ircd::m::dbs::room_type_key(const string_view &amalgam)
+{
+	// The amalgam starts at the separator following the room_id prefix; the
+	// type is followed by another separator and the fixed-width depth and
+	// index, so it's delimited from the end rather than by searching.
+	static const size_t tail_size
+	{
+		1 + sizeof(uint64_t) + sizeof(event::idx)
+	};
+
+	assert(startswith(amalgam, "\0"_sv));
+	const string_view &key
+	{
+		amalgam.substr(1)
+	};
+
+	const string_view &type
+	{
+		size(key) >= tail_size?
+			key.substr(0, size(key) - tail_size):
+			split(key, "\0"_sv).first
+	};
+
+	const string_view &after_type
+	{
+		size(key) >= tail_size?
+			key.substr(size(key) - tail_size + 1):
+			split(key, "\0"_sv).second
+	};
+
+	const uint64_t &depth
+	{
+		size(after_type) >= 8?
+			uint64_t(byte_view<uint64_t>(after_type.substr(0, 8))):
+			-1UL
+	};
+
+	const event::idx &event_idx
+	{
+		size(after_type) >= 16?
+			event::idx(byte_view<event::idx>(after_type.substr(8, 8))):
+			-1UL
+	};
+
+	return
+	{
+		type, depth, event_idx
+	};
+}
+
+const ircd::db::prefix_transform
+ircd::m::dbs::desc::events__room_type__pfx
+{
+	"_room_type",
+	[](const string_view &key)
+	{
+		return has(key, "\0"_sv);
+	},
+
+	[](const string_view &key)
+	{
+		return split(key, "\0"_sv).first;
+	}
+};
+
+const ircd::db::comparator
+ircd::m::dbs::desc::events__room_type__cmp
+{
+	"_room_type",
+
+	// less
+	[](const string_view &a, const string_view &b)
+	{
+		static const auto &pt
+		{
+			events__room_type__pfx
+		};
+
+		const string_view pre[2]
+		{
+			pt.get(a),
+			pt.get(b),
+		};
+
+		if(size(pre[0]) != size(pre[1]))
+			return size(pre[0]) < size(pre[1]);
+
+		if(pre[0] != pre[1])
+			return pre[0] < pre[1];
+
+		const string_view post[2]
+		{
+			a.substr(size(pre[0])),
+			b.substr(size(pre[1])),
+		};
+
+		// These conditions are matched on some queries when the user only
+		// supplies a room_id.
+		if(empty(post[0]))
+			return !empty(post[1]);
+
+		if(empty(post[1]))
+			return false;
+
+		const room_type_key_parts k[2]
+		{
+			room_type_key(post[0]),
+			room_type_key(post[1])
+		};
+
+		// type
+		if(std::get<0>(k[0]) < std::get<0>(k[1]))
+			return true;
+		else if(std::get<0>(k[0]) > std::get<0>(k[1]))
+			return false;
+
+		// depth (ORDER IS DESCENDING!)
+		if(std::get<1>(k[0]) > std::get<1>(k[1]))
+			return true;
+		else if(std::get<1>(k[0]) < std::get<1>(k[1]))
+			return false;
+
+		// event_idx (ORDER IS DESCENDING!)
+		if(std::get<2>(k[0]) > std::get<2>(k[1]))
+			return true;
+		else if(std::get<2>(k[0]) < std::get<2>(k[1]))
+			return false;
+
+		return false;
+	},
+
+	// equal
+	[](const string_view &a, const string_view &b)
+	{
+		return a == b;
+	}
+};
+
+/// This column is the timeline of a room partitioned by event type:
+///
+/// [room_id | type + depth + event_idx]
+///
+/// Within the room_id prefix all keys are ordered by type (ascending) and
+/// then by depth and event_idx from HIGHEST TO LOWEST, same as room_events.
+/// A query for the events of one type in a room seeks directly into the
+/// partition for that type rather than testing every event in room_events.
+/// NOTE: depth and event_idx are fixed 8 byte binary integers.
+///
+const ircd::db::descriptor
+ircd::m::dbs::desc::events__room_type
+{
+	// name
+	"_room_type",
+
+	// explanation
+	R"(Indexes events in timeline sequence for a room by type.
+
+	[room_id | type + depth + event_idx]
+
+	)",
+
+	// typing (key, value)
+	{
+		typeid(string_view), typeid(string_view)
+	},
+
+	// options
+	{},
+
+	// comparator
+	events__room_type__cmp,
+
+	// prefix transform
+	events__room_type__pfx,
+
+	// drop column
+	false,
+
+	// cache size
+	bool(events_cache_enable)? -1 : 0,
+
+	// cache size for compressed assets
+	bool(events_cache_comp_enable)? -1 : 0,
+
+	// bloom filter bits
+	0, // no bloom filter because of possible comparator issues
+
+	// expect queries hit
+	false,
+
+	// block size
+	size_t(events__room_type__block__size),
+
+	// meta_block size
+	size_t(events__room_type__meta_block__size),
+};
+
 //
 // joined sequential
 //
@@ -3533,6 +3954,257 @@ ircd::m::dbs::desc::events__room_state_space
 	size_t(events__room_state_space__meta_block__size),
 };
 
+//
+// user directory
+//
+
+decltype(ircd::m::dbs::desc::events__user_dir__block__size)
+ircd::m::dbs::desc::events__user_dir__block__size
+{
+	{ "name",     "ircd.m.dbs.events._user_dir.block.size" },
+	{ "default",  512L                                     },
+};
+
+decltype(ircd::m::dbs::desc::events__user_dir__meta_block__size)
+ircd::m::dbs::desc::events__user_dir__meta_block__size
+{
+	{ "name",     "ircd.m.dbs.events._user_dir.meta_block.size" },
+	{ "default",  4096L                                         },
+};
+
+decltype(ircd::m::dbs::desc::events__user_dir__cache__size)
+ircd::m::dbs::desc::events__user_dir__cache__size
+{
+	{
+		{ "name",     "ircd.m.dbs.events._user_dir.cache.size" },
+		{ "default",  long(8_MiB)                              },
+	}, []
+	{
+		const size_t &value{events__user_dir__cache__size};
+		db::capacity(db::cache(user_dir), value);
+	}
+};
+
+decltype(ircd::m::dbs::desc::events__user_dir__cache_comp__size)
+ircd::m::dbs::desc::events__user_dir__cache_comp__size
+{
+	{
+		{ "name",     "ircd.m.dbs.events._user_dir.cache_comp.size" },
+		{ "default",  long(0_MiB)                                   },
+	}, []
+	{
+		const size_t &value{events__user_dir__cache_comp__size};
+		db::capacity(db::cache_compressed(user_dir), value);
+	}
+};
+
+/// Normalizes text into search tokens. ASCII letters are folded to lower
+/// case and any other ASCII character which is not a digit separates tokens;
+/// multibyte UTF-8 sequences are kept as-is. Tokens are truncated to the
+/// maximum size on a character boundary. Searches match a token by prefix,
+/// so only whole words are emitted.
+bool
+ircd::m::dbs::user_dir_tokens(const string_view &text,
+                              const user_dir_token_closure &closure)
+{
+	char buf[USER_DIR_TOKEN_MAX_SIZE];
+	size_t len(0);
+	bool truncated(false);
+	const auto emit{[&buf, &len, &truncated, &closure]
+	{
+		// Back off any partial multibyte sequence left by the truncation.
+		if(truncated)
+			for(size_t i(len); i > 0; --i)
+			{
+				const uint8_t lead(buf[i - 1]);
+				if((lead & 0xc0) == 0x80)
+					continue;
+
+				const size_t need
+				{
+					lead >= 0xf0? 4UL:
+					lead >= 0xe0? 3UL:
+					lead >= 0xc0? 2UL:
+					              1UL
+				};
+
+				if(i - 1 + need > len)
+					len = i - 1;
+
+				break;
+			}
+
+		const string_view token
+		{
+			buf, len
+		};
+
+		len = 0;
+		truncated = false;
+		return !token || closure(token);
+	}};
+
+	for(const uint8_t c : text)
+	{
+		const bool ascii(c < 0x80);
+		if(ascii && !isalnum(c))
+		{
+			if(!emit())
+				return false;
+
+			continue;
+		}
+
+		if(len >= sizeof(buf))
+		{
+			truncated = true;
+			continue;
+		}
+
+		buf[len++] = ascii? tolower(c) : c;
+	}
+
+	return emit();
+}
+
+/// Tokens for a member of the directory: the words of the localpart and of
+/// the display name. Duplicates are suppressed and the number of tokens is
+/// bounded so a pathological display name can't flood the column.
+bool
+ircd::m::dbs::user_dir_tokens(const id::user &user_id,
+                              const string_view &displayname,
+                              const user_dir_token_closure &closure)
+{
+	static const size_t max
+	{
+		16
+	};
+
+	char seen_buf[max][USER_DIR_TOKEN_MAX_SIZE];
+	string_view seen[max];
+	size_t count(0);
+	bool full(false);
+	const auto each{[&seen_buf, &seen, &count, &full, &closure]
+	(const string_view &token)
+	{
+		if((full = count >= max))
+			return false;
+
+		if(std::find(seen, seen + count, token) != seen + count)
+			return true;
+
+		seen[count] = string_view
+		{
+			seen_buf[count], copy(seen_buf[count], token)
+		};
+
+		return closure(seen[count++]);
+	}};
+
+	if(!user_dir_tokens(user_id.local(), each))
+		return full;
+
+	return user_dir_tokens(displayname, each) || full;
+}
+
+ircd::string_view
+ircd::m::dbs::user_dir_key(const mutable_buffer &out_,
+                           const string_view &token,
+                           const id::user &user_id,
+                           const id::room &room_id)
+{
+	assert(size(token) <= USER_DIR_TOKEN_MAX_SIZE);
+	mutable_buffer out{out_};
+	consume(out, copy(out, token));
+	if(!user_id)
+		return { data(out_), data(out) };
+
+	consume(out, copy(out, "\0"_sv));
+	consume(out, copy(out, user_id));
+	if(!room_id)
+		return { data(out_), data(out) };
+
+	consume(out, copy(out, "\0"_sv));
+	consume(out, copy(out, room_id));
+	return { data(out_), data(out) };
+}
+
+ircd::m::dbs::user_dir_key_parts
+ircd::m::dbs::user_dir_key(const string_view &amalgam)
+{
+	const auto &[token, rest]
+	{
+		split(amalgam, "\0"_sv)
+	};
+
+	const auto &[user_id, room_id]
+	{
+		split(rest, "\0"_sv)
+	};
+
+	return
+	{
+		token,
+		user_id? id::user{user_id} : id::user{},
+		room_id? id::room{room_id} : id::room{},
+	};
+}
+
+const ircd::db::descriptor
+ircd::m::dbs::desc::events__user_dir
+{
+	// name
+	"_user_dir",
+
+	// explanation
+	R"(Search tokens for the user directory.
+
+	token | user_id, room_id => event_idx
+
+	The token is a normalized word of the localpart or of the display name of
+	a member presently joined to the room. The value is the index of that
+	m.room.member event. Entries are made and retracted as the present state
+	of a member changes. Searches seek the token by prefix in total order, so
+	this column has no prefix transform and no bloom filter.
+
+	)",
+
+	// typing (key, value)
+	{
+		typeid(string_view), typeid(uint64_t)
+	},
+
+	// options
+	{},
+
+	// comparator
+	{},
+
+	// prefix transform
+	{},
+
+	// drop column
+	false,
+
+	// cache size
+	bool(events_cache_enable)? -1 : 0,
+
+	// cache size for compressed assets
+	bool(events_cache_comp_enable)? -1 : 0,
+
+	// bloom filter bits
+	0,
+
+	// expect queries hit
+	false,
+
+	// block size
+	size_t(events__user_dir__block__size),
+
+	// meta_block size
+	size_t(events__user_dir__meta_block__size),
+};
+
 //
 // Direct column descriptors
 //
@@ -4907,6 +5579,10 @@ ircd::m::dbs::desc::events
 	// Sequence of all events for a room, ever.
 	events__room_events,
 
+	// (room_id, (type, depth, event_idx))
+	// Sequence of all events for a room, partitioned by type.
+	events__room_type,
+
 	// (room_id, (origin, user_id))
 	// Sequence of all PRESENTLY JOINED joined for a room.
 	events__room_joined,
@@ -4923,6 +5599,10 @@ ircd::m::dbs::desc::events
 	// Mapping of all current head events for a room.
 	events__room_head,
 
+	// (token, (user_id, room_id)) => (event_idx)
+	// Search tokens of the members presently joined to rooms.
+	events__user_dir,
+
 	//
 	// These columns are legacy; they have been dropped from the schema.
 	//
@@ -486,10 +486,18 @@ ircd::m::vm::conform_report
 			return;
 		}
 
+		// The event_id of a trusted issue was just computed by make_id(); the
+		// reference hash does not have to be computed again to check it.
+		const uint64_t skip
+		{
+			opts.non_conform.report |
+			(eval.trusted? 1UL << event::conforms::MISMATCH_EVENT_ID : 0UL)
+		};
+
 		// Generate the report here.
 		eval.report = event::conforms
 		{
-			event, opts.non_conform.report
+			event, skip
 		};
 
 		// When opts.conforming is false a bad report is not an error.
@@ -578,14 +586,13 @@ ircd::m::event::conforms::reflect(const string_view &name)
 	return code(std::distance(begin(event_conforms_reflects), it));
 }
 
-ircd::m::event::conforms::conforms(const event &e,
-                                   const uint64_t &skip)
-:conforms{e}
+ircd::m::event::conforms::conforms(const event &e)
+:conforms{e, 0UL}
 {
-	report &= ~skip;
 }
 
-ircd::m::event::conforms::conforms(const event &e)
+ircd::m::event::conforms::conforms(const event &e,
+                                   const uint64_t &skip)
 :report{0}
 {
 	if(!e.event_id)
@@ -595,7 +602,9 @@ ircd::m::event::conforms::conforms(const event &e)
 		if(!valid(m::id::EVENT, json::get<"event_id"_>(e)))
 			set(INVALID_OR_MISSING_EVENT_ID);
 
-	if(!has(INVALID_OR_MISSING_EVENT_ID))
+	// Recomputing the reference hash is the costliest check here; it is
+	// bypassed entirely when the caller is masking the result anyway.
+	if(!has(INVALID_OR_MISSING_EVENT_ID) && !(skip & (1UL << MISMATCH_EVENT_ID)))
 		if(!m::check_id(e))
 			set(MISMATCH_EVENT_ID);
 
@@ -709,6 +718,8 @@ ircd::m::event::conforms::conforms(const event &e)
 				if(event_id == prev.prev_event(j))
 					set(DUP_PREV_EVENT);
 	}
+
+	report &= ~skip;
 }
 
 void
@@ -811,7 +822,7 @@ ircd::m::prefetch(const event::idx &event_idx,
 		if(!event_idx)
 			return false;
 
-		return db::prefetch(dbs::event_json, byte_view<string_view>{event_idx});
+		return db::prefetch(dbs::event_json, byte_view<string_view>{event_idx}, opts.gopts);
 	}
 
 	const event::keys keys
@@ -827,14 +838,15 @@ ircd::m::prefetch(const event::idx &event_idx,
 	bool ret{false};
 	for(const auto &col : cols)
 		if(col)
-			ret |= prefetch(event_idx, col);
+			ret |= prefetch(event_idx, col, opts.gopts);
 
 	return ret;
 }
 
 bool
 ircd::m::prefetch(const event::idx &event_idx,
-                  const string_view &key)
+                  const string_view &key,
+                  const db::gopts &gopts)
 {
 	const auto &column_idx
 	{
@@ -842,7 +854,7 @@ ircd::m::prefetch(const event::idx &event_idx,
 	};
 
 	if(column_idx >= dbs::event_column.size())
-		return prefetch(event_idx, event::fetch::default_opts);
+		return prefetch(event_idx, event::fetch::opts{gopts});
 
 	auto &column
 	{
@@ -852,7 +864,7 @@ ircd::m::prefetch(const event::idx &event_idx,
 	if(!event_idx)
 		return false;
 
-	return db::prefetch(column, byte_view<string_view>{event_idx});
+	return db::prefetch(column, byte_view<string_view>{event_idx}, gopts);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1275,6 +1287,33 @@ decltype(ircd::m::event::fetch::default_opts)
 ircd::m::event::fetch::default_opts
 {};
 
+/// Options for events which will be appended to federation responses with
+/// append_pdu(). The event_json query is always made so the stored JSON is
+/// available to be copied out; the tuple is only populated with the keys
+/// used for visibility and graph traversal by the handlers.
+decltype(ircd::m::event::fetch::pdu_opts)
+ircd::m::event::fetch::pdu_opts{[]
+{
+	opts ret
+	{
+		event::keys::include
+		{
+			"content",
+			"depth",
+			"event_id",
+			"membership",
+			"prev_events",
+			"room_id",
+			"sender",
+			"state_key",
+			"type",
+		}
+	};
+
+	ret.query_json_force = true;
+	return ret;
+}()};
+
 //
 // event::fetch::fetch
 //
@@ -1553,6 +1592,79 @@ ircd::m::event::fetch::key(const event::idx *const &event_idx)
 	return byte_view<string_view>(*event_idx);
 }
 
+//
+// append_pdu
+//
+
+void
+ircd::m::append_pdu(json::stack::array &array,
+                    const event::fetch &event)
+{
+	append_pdu(array, event, json::object{});
+}
+
+/// Appends the event to the array as it is found in the event_json column;
+/// the value is copied directly from the pinned cell without stringifying
+/// the tuple. When unsigned_ is not empty it replaces any unsigned member of
+/// the stored JSON; that is the only case where the top-level members are
+/// spliced individually. Events not loaded from event_json are refetched.
+void
+ircd::m::append_pdu(json::stack::array &array,
+                    const event::fetch &event,
+                    const json::object &unsigned_)
+{
+	assert(event.valid);
+	const bool has_json
+	{
+		event.event_idx && event._json.valid(event::fetch::key(&event.event_idx))
+	};
+
+	if(unlikely(!has_json))
+	{
+		const event::fetch full
+		{
+			event.event_idx, std::nothrow
+		};
+
+		if(!full.valid || !full._json.valid(event::fetch::key(&full.event_idx)))
+			return;
+
+		return append_pdu(array, full, unsigned_);
+	}
+
+	const json::object source
+	{
+		event._json.val()
+	};
+
+	if(empty(unsigned_) && !source.has("unsigned"))
+		return array.splice(source);
+
+	json::stack::object object
+	{
+		array
+	};
+
+	for(const auto &[key, val] : source)
+	{
+		if(key == "unsigned")
+			continue;
+
+		json::stack::member member
+		{
+			object, key
+		};
+
+		member.splice(val);
+	}
+
+	if(!empty(unsigned_))
+		json::stack::member
+		{
+			object, "unsigned", unsigned_
+		};
+}
+
 //
 // event::fetch::opts
 //
@@ -1829,76 +1941,6 @@ ircd::m::event::horizon::for_every(const closure_bool &closure)
 // event/refs.h
 //
 
-void
-ircd::m::event::refs::rebuild()
-{
-	static const size_t pool_size{96};
-	static const size_t log_interval{8192};
-
-	db::txn txn
-	{
-		*m::dbs::events
-	};
-
-	auto &column
-	{
-		dbs::event_json
-	};
-
-	auto it
-	{
-		column.begin()
-	};
-
-	ctx::dock dock;
-	ctx::pool pool;
-	pool.min(pool_size);
-
-	size_t i(0), j(0);
-	const ctx::uninterruptible::nothrow ui;
-	for(; it; ++it)
-	{
-		if(ctx::interruption_requested())
-			break;
-
-		const m::event::idx event_idx
-		{
-			byte_view<m::event::idx>(it->first)
-		};
-
-		std::string event{it->second};
-		pool([&txn, &dock, &i, &j, event(std::move(event)), event_idx]
-		{
-			m::dbs::write_opts wopts;
-			wopts.event_idx = event_idx;
-			wopts.appendix.reset();
-			wopts.appendix.set(dbs::appendix::EVENT_REFS);
-			m::dbs::write(txn, json::object{event}, wopts);
-
-			if(++j % log_interval == 0) log::info
-			{
-				m::log, "Refs builder @%zu:%zu of %lu (@idx: %lu)",
-				i,
-				j,
-				m::vm::sequence::retired,
-				event_idx
-			};
-
-			if(j >= i)
-				dock.notify_one();
-		});
-
-		++i;
-	}
-
-	dock.wait([&i, &j]
-	{
-		return i == j;
-	});
-
-	txn();
-}
-
 bool
 ircd::m::event::refs::prefetch()
 const
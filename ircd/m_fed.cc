@@ -1530,15 +1530,22 @@ ircd::m::v1::_make_server_keys(const vector_view<const key::server_key> &keys,
 		top, "server_keys"
 	};
 
-	for(const auto &[server_name, key_id] : keys)
+	// Adjacent queries for the same server are listed under one object;
+	// callers sort their queries to make the most of this.
+	for(auto it(begin(keys)); it != end(keys); )
 	{
+		const auto &server_name(it->first);
 		json::stack::object server_object
 		{
 			server_keys, server_name
 		};
 
-		if(key_id)
+		for(; it != end(keys) && it->first == server_name; ++it)
 		{
+			const auto &key_id(it->second);
+			if(!key_id)
+				continue;
+
 			json::stack::object key_object
 			{
 				server_object, key_id
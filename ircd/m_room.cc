@@ -875,6 +875,12 @@ ircd::m::join_rule(const mutable_buffer &out,
 		"invite"
 	};
 
+	if(!room.event_id)
+		if(const auto cached{room::auth::cache::get(room.room_id)})
+			return !empty(cached->join_rule)?
+				string_view{data(out), copy(out, string_view{cached->join_rule})}:
+				default_join_rule;
+
 	string_view ret
 	{
 		default_join_rule
@@ -941,6 +947,13 @@ ircd::m::version(const mutable_buffer &buf,
                  const room &room,
                  std::nothrow_t)
 {
+	if(!room.event_id)
+		if(const auto cached{room::auth::cache::get(room.room_id)})
+			return strlcpy
+			{
+				buf, cached->room_version
+			};
+
 	const auto event_idx
 	{
 		room.get(std::nothrow, "m.room.create", "")
@@ -998,6 +1011,9 @@ ircd::m::type(const mutable_buffer &buf,
 ircd::m::id::user::buf
 ircd::m::creator(const id::room &room_id)
 {
+	if(const auto cached{room::auth::cache::get(room_id)})
+		return cached->creator;
+
 	// Query the sender field of the event to get the creator. This is for
 	// future compatibility if the content.creator field gets eliminated.
 	static const event::fetch::opts fopts
@@ -1129,6 +1145,9 @@ ircd::m::creator(const room::id &room_id,
 bool
 ircd::m::federated(const id::room &room_id)
 {
+	if(const auto cached{room::auth::cache::get(room_id)})
+		return json::object{cached->create_content}.get("m.federate", true);
+
 	static const m::event::fetch::opts fopts
 	{
 		event::keys::include { "content" },
@@ -1809,6 +1828,267 @@ const
 	return std::get<0>(part);
 }
 
+//
+// room::type
+//
+
+decltype(ircd::m::room::type::enable)
+ircd::m::room::type::enable
+{
+	{ "name",     "ircd.m.room.type.enable" },
+	{ "default",  false                     },
+	{ "description",
+
+	R"(
+	Allow queries which depend on the room_type index being complete, such as
+	type-filtered /messages, to use it. Events written before this index
+	existed must first be added with the `room type rebuild *` command.
+	)"}
+};
+
+decltype(ircd::m::room::type::rebuild_batch_size)
+ircd::m::room::type::rebuild_batch_size
+{
+	{ "name",     "ircd.m.room.type.rebuild.batch_size" },
+	{ "default",  int64_t(64_MiB)                       },
+	{ "description",
+
+	R"(
+	Size of the transaction at which a rebuild of the room_type index
+	commits. This bounds the memory used to rebuild a large room.
+	)"}
+};
+
+ircd::m::room::type::type(const m::room &room,
+                          const string_view &type,
+                          const uint64_t &depth,
+                          const event::idx &idx)
+:room{room}
+,_type{type}
+,_depth{depth}
+,_idx{idx}
+{
+	assert(room.room_id);
+	assert(_type);
+}
+
+bool
+ircd::m::room::type::empty()
+const
+{
+	return for_each([]
+	(const auto &type, const auto &depth, const auto &event_idx)
+	{
+		return false;
+	});
+}
+
+size_t
+ircd::m::room::type::count()
+const
+{
+	size_t ret(0);
+	for_each([&ret]
+	(const auto &type, const auto &depth, const auto &event_idx)
+	{
+		++ret;
+		return true;
+	});
+
+	return ret;
+}
+
+bool
+ircd::m::room::type::prefetch()
+const
+{
+	char buf[dbs::ROOM_TYPE_KEY_MAX_SIZE];
+	const string_view &key
+	{
+		dbs::room_type_key(buf, room.room_id, _type, _depth, _idx)
+	};
+
+	return db::prefetch(dbs::room_type, key);
+}
+
+bool
+ircd::m::room::type::for_each(const closure &closure)
+const
+{
+	char buf[dbs::ROOM_TYPE_KEY_MAX_SIZE];
+	const string_view &key
+	{
+		dbs::room_type_key(buf, room.room_id, _type, _depth, _idx)
+	};
+
+	auto it
+	{
+		dbs::room_type.begin(key)
+	};
+
+	for(; it; ++it)
+	{
+		const auto &[type, depth, event_idx]
+		{
+			dbs::room_type_key(it->first)
+		};
+
+		if(type != _type)
+			break;
+
+		if(!closure(type, depth, event_idx))
+			return false;
+	}
+
+	return true;
+}
+
+/// The column is ordered by descending depth and RocksDB does not support
+/// reverse iteration within a prefix, so this walks back over the whole
+/// column in total order and bounds the iteration by checking the key.
+bool
+ircd::m::room::type::rfor_each(const closure &closure)
+const
+{
+	static const db::gopts gopts
+	{
+		db::get::ORDERED
+	};
+
+	static const auto &pt
+	{
+		dbs::desc::events__room_type__pfx
+	};
+
+	char buf[dbs::ROOM_TYPE_KEY_MAX_SIZE];
+	const string_view &key
+	{
+		dbs::room_type_key(buf, room.room_id, _type, _depth, _idx)
+	};
+
+	db::column &column
+	{
+		dbs::room_type
+	};
+
+	auto it
+	{
+		column.lower_bound(key, gopts)
+	};
+
+	// The seek lands at or above the starting position. Past the end of the
+	// column the last key is the one before it; otherwise unless it's an
+	// exact match the one before it is the previous key.
+	if(!it)
+		seek(it, db::pos::BACK);
+	else if(it->first != key)
+		seek(it, db::pos::PREV);
+
+	for(; it; --it)
+	{
+		const auto &pre
+		{
+			pt.get(it->first)
+		};
+
+		if(pre != room.room_id)
+			break;
+
+		const auto &[type, depth, event_idx]
+		{
+			dbs::room_type_key(it->first.substr(size(pre)))
+		};
+
+		if(type != _type)
+			break;
+
+		if(!closure(type, depth, event_idx))
+			return false;
+	}
+
+	return true;
+}
+
+//
+// room::type::rebuild
+//
+
+ircd::m::room::type::rebuild::rebuild(const room::id &room_id)
+{
+	static const event::fetch::opts fopts
+	{
+		event::keys::include { "event_id", "room_id", "type", "depth" },
+	};
+
+	db::txn txn
+	{
+		*m::dbs::events
+	};
+
+	m::room::events it
+	{
+		room_id, uint64_t(0), &fopts
+	};
+
+	if(!it)
+		return;
+
+	size_t count(0), elems(0), bytes(0), batches(0);
+	const auto commit{[&txn, &elems, &bytes, &batches]
+	{
+		elems += txn.size();
+		bytes += txn.bytes();
+		txn();
+		txn.clear();
+		++batches;
+	}};
+
+	for(; it; ++it, ++count) try
+	{
+		const m::event &event{*it};
+
+		dbs::write_opts opts;
+		opts.event_idx = it.event_idx();
+		opts.appendix.reset();
+		opts.appendix.set(dbs::appendix::ROOM_TYPE);
+		dbs::write(txn, event, opts);
+
+		if(txn.bytes() >= size_t(rebuild_batch_size))
+			commit();
+	}
+	catch(const ctx::interrupted &e)
+	{
+		log::dwarning
+		{
+			log, "room::type::rebuild :%s",
+			e.what()
+		};
+
+		throw;
+	}
+	catch(const std::exception &e)
+	{
+		log::error
+		{
+			log, "room::type::rebuild :%s",
+			e.what()
+		};
+	}
+
+	if(txn.size())
+		commit();
+
+	log::info
+	{
+		log, "room::type::rebuild %s complete events:%zu batches:%zu transaction elems:%zu size:%s",
+		string_view{room_id},
+		count,
+		batches,
+		elems,
+		pretty(iec(bytes))
+	};
+}
+
 //
 // room::state
 //
@@ -1880,7 +2160,7 @@ const
 		dbs::room_state_key(buf, room_id, type, state_key)
 	};
 
-	return db::prefetch(dbs::room_state, key);
+	return db::prefetch(dbs::room_state, key, fopts? fopts->gopts : db::gopts{});
 }
 
 ircd::m::event::idx
@@ -3732,6 +4012,290 @@ ircd::m::room::aliases::cache::for_each(const string_view &s,
 	return call(s, c);
 }
 
+//
+// room::auth::cache
+//
+
+namespace ircd::m
+{
+	using auth_cache_entry = room::auth::cache::entry;
+	using auth_cache_list = std::list<std::shared_ptr<const auth_cache_entry>>;
+
+	static void auth_cache_levels(room::auth::cache::levels &, const json::object &);
+	static void auth_cache_evict();
+
+	static auth_cache_list auth_cache_lru;
+	static std::map<string_view, auth_cache_list::iterator, std::less<>> auth_cache_map;
+	static std::map<std::string, event::idx, std::less<>> auth_cache_barrier;
+	static uint64_t auth_cache_generation;
+}
+
+decltype(ircd::m::room::auth::cache::enable)
+ircd::m::room::auth::cache::enable
+{
+	{ "name",     "ircd.m.room.auth.cache.enable" },
+	{ "default",  true                            },
+	{ "description",
+
+	R"(
+	Serve the create, power_levels and join_rules content of the present state
+	of a room from a decoded copy rather than fetching and parsing the events
+	for each auth check and power level query.
+	)"}
+};
+
+decltype(ircd::m::room::auth::cache::max_rooms)
+ircd::m::room::auth::cache::max_rooms
+{
+	{ "name",     "ircd.m.room.auth.cache.max_rooms" },
+	{ "default",  4096L                              },
+};
+
+decltype(ircd::m::room::auth::cache::hits)
+ircd::m::room::auth::cache::hits
+{
+	{ "name", "ircd.m.room.auth.cache.hits"                           },
+	{ "desc", "Lookups answered by a decoded entry in the auth cache" },
+};
+
+decltype(ircd::m::room::auth::cache::misses)
+ircd::m::room::auth::cache::misses
+{
+	{ "name", "ircd.m.room.auth.cache.misses"                         },
+	{ "desc", "Lookups which decoded the room's power events again"   },
+};
+
+decltype(ircd::m::room::auth::cache::invalidations)
+ircd::m::room::auth::cache::invalidations
+{
+	{ "name", "ircd.m.room.auth.cache.invalidations"                  },
+	{ "desc", "State writes to tracked types dropping a room's entry" },
+};
+
+std::shared_ptr<const ircd::m::room::auth::cache::entry>
+ircd::m::room::auth::cache::get(const m::room::id &room_id)
+{
+	if(!enable)
+		return {};
+
+	const auto it
+	{
+		auth_cache_map.find(room_id)
+	};
+
+	if(it != end(auth_cache_map))
+	{
+		++hits;
+		auth_cache_lru.splice(begin(auth_cache_lru), auth_cache_lru, it->second);
+		return *it->second;
+	}
+
+	++misses;
+	const auto generation
+	{
+		auth_cache_generation
+	};
+
+	// Decoding the entry yields this ctx for database queries.
+	auto ret
+	{
+		std::make_shared<const entry>(room_id)
+	};
+
+	// Unknown rooms are not cached so remote input can't fill the cache.
+	if(!ret->create_idx)
+		return {};
+
+	// The state was written while decoding; the result can be returned but
+	// it might have been read from either side of the write.
+	if(generation != auth_cache_generation)
+		return ret;
+
+	// A write to this room's tracked state hasn't been committed yet, so
+	// what we decoded is not the state which will be present.
+	const auto barrier
+	{
+		auth_cache_barrier.find(room_id)
+	};
+
+	if(barrier != end(auth_cache_barrier))
+	{
+		if(barrier->second > vm::sequence::retired)
+			return ret;
+
+		auth_cache_barrier.erase(barrier);
+	}
+
+	// Another ctx may have filled this room while we were decoding.
+	const auto exists
+	{
+		auth_cache_map.find(room_id)
+	};
+
+	if(exists != end(auth_cache_map))
+		return *exists->second;
+
+	auth_cache_lru.emplace_front(ret);
+	auth_cache_map.emplace(ret->room_id, begin(auth_cache_lru));
+	auth_cache_evict();
+	return ret;
+}
+
+void
+ircd::m::room::auth::cache::invalidate(const m::room::id &room_id,
+                                       const event::idx &sequence)
+{
+	++auth_cache_generation;
+	if(sequence > vm::sequence::retired)
+	{
+		auto it
+		{
+			auth_cache_barrier.lower_bound(room_id)
+		};
+
+		if(it == end(auth_cache_barrier) || it->first != string_view{room_id})
+			it = auth_cache_barrier.emplace_hint(it, std::string(room_id), 0UL);
+
+		it->second = std::max(it->second, sequence);
+	}
+
+	const auto it
+	{
+		auth_cache_map.find(room_id)
+	};
+
+	if(it == end(auth_cache_map))
+		return;
+
+	++invalidations;
+	const auto lit(it->second);
+	auth_cache_map.erase(it);
+	auth_cache_lru.erase(lit);
+}
+
+void
+ircd::m::room::auth::cache::clear()
+noexcept
+{
+	++auth_cache_generation;
+	auth_cache_map.clear();
+	auth_cache_lru.clear();
+}
+
+size_t
+ircd::m::room::auth::cache::size()
+noexcept
+{
+	return auth_cache_map.size();
+}
+
+bool
+ircd::m::room::auth::cache::tracked(const string_view &type)
+noexcept
+{
+	return type == "m.room.create"
+	    || type == "m.room.power_levels"
+	    || type == "m.room.join_rules";
+}
+
+void
+ircd::m::auth_cache_evict()
+{
+	while(auth_cache_map.size() > size_t(room::auth::cache::max_rooms))
+	{
+		assert(!auth_cache_lru.empty());
+		auth_cache_map.erase(auth_cache_lru.back()->room_id);
+		auth_cache_lru.pop_back();
+	}
+
+	// Barriers are only needed until their write retires; sweep them here so
+	// rooms which aren't queried again don't accumulate.
+	for(auto it(begin(auth_cache_barrier)); it != end(auth_cache_barrier); )
+		if(it->second <= vm::sequence::retired)
+			it = auth_cache_barrier.erase(it);
+		else
+			++it;
+}
+
+void
+ircd::m::auth_cache_levels(room::auth::cache::levels &out,
+                           const json::object &object)
+{
+	// Only numbers are levels; a quoted number is a string and is skipped.
+	for(const auto &[key, value] : object)
+	{
+		if(json::type(value, std::nothrow) != json::NUMBER)
+			continue;
+
+		if(!try_lex_cast<int64_t>(value))
+			continue;
+
+		out.emplace(unquote(key), lex_cast<int64_t>(value));
+	}
+}
+
+//
+// room::auth::cache::entry
+//
+
+ircd::m::room::auth::cache::entry::entry(const m::room::id &room_id)
+:room_id
+{
+	room_id
+}
+{
+	const m::room room
+	{
+		room_id
+	};
+
+	create_idx = room.get(std::nothrow, "m.room.create", "");
+	power_idx = room.get(std::nothrow, "m.room.power_levels", "");
+	join_rules_idx = room.get(std::nothrow, "m.room.join_rules", "");
+
+	if(create_idx)
+	{
+		create_content = m::get(std::nothrow, create_idx, "content");
+		const json::object &content
+		{
+			create_content
+		};
+
+		room_version = json::string
+		{
+			content.get("room_version", "1")
+		};
+
+		m::get(std::nothrow, create_idx, "sender", [this]
+		(const string_view &sender)
+		{
+			creator = m::user::id{sender};
+		});
+	}
+
+	if(join_rules_idx)
+		m::get(std::nothrow, join_rules_idx, "content", [this]
+		(const json::object &content)
+		{
+			join_rule = json::string
+			{
+				content.get("join_rule")
+			};
+		});
+
+	if(power_idx)
+	{
+		m::event_id(power_idx, power_event_id, std::nothrow);
+		m::get(std::nothrow, power_idx, "content", [this]
+		(const json::object &content)
+		{
+			auth_cache_levels(level, content);
+			auth_cache_levels(events, content.get("events"));
+			auth_cache_levels(users, content.get("users"));
+		});
+	}
+}
+
 //
 // room::power
 //
@@ -3864,9 +4428,47 @@ ircd::m::room::power::compose_content(const mutable_buffer &buf,
 //
 
 ircd::m::room::power::power(const m::room &room)
-:power
+:room
+{
+	room
+}
+,cached
+{
+	!room.event_id?
+		auth::cache::get(room.room_id):
+		nullptr
+}
+,power_event_idx
 {
-	room, room.get(std::nothrow, "m.room.power_levels", "")
+	cached?
+		cached->power_idx:
+		room.get(std::nothrow, "m.room.power_levels", "")
+}
+,room_creator_id
+{
+	cached?
+		m::id::user{cached->creator}:
+		m::id::user{}
+}
+{
+}
+
+ircd::m::room::power::power(std::shared_ptr<const auth::cache::entry> cached)
+:room
+{
+	cached->room_id
+}
+,cached
+{
+	std::move(cached)
+}
+,power_event_idx
+{
+	this->cached->power_idx
+}
+,room_creator_id
+{
+	this->cached->creator
 }
 {
 }
@@ -3955,6 +4557,18 @@ int64_t
 ircd::m::room::power::level_user(const m::user::id &user_id)
 const try
 {
+	if(cached && !cached->power_idx)
+		return cached->creator == user_id?
+			default_creator_level:
+			default_user_level;
+
+	if(cached)
+		return cached_level
+		(
+			cached->users, user_id,
+			cached_level(cached->level, "users_default", default_user_level)
+		);
+
 	int64_t ret
 	{
 		default_user_level
@@ -4001,6 +4615,16 @@ int64_t
 ircd::m::room::power::level_event(const string_view &type)
 const try
 {
+	if(cached && !cached->power_idx)
+		return default_event_level;
+
+	if(cached)
+		return cached_level
+		(
+			cached->events, type,
+			cached_level(cached->level, "events_default", default_event_level)
+		);
+
 	int64_t ret
 	{
 		default_event_level
@@ -4042,6 +4666,16 @@ const try
 	if(!defined(state_key))
 		return level_event(type);
 
+	if(cached && !cached->power_idx)
+		return default_power_level;
+
+	if(cached)
+		return cached_level
+		(
+			cached->events, type,
+			cached_level(cached->level, "state_default", default_power_level)
+		);
+
 	int64_t ret
 	{
 		default_power_level
@@ -4079,6 +4713,9 @@ int64_t
 ircd::m::room::power::level(const string_view &prop)
 const try
 {
+	if(cached)
+		return cached_level(cached->level, prop, default_power_level);
+
 	int64_t ret
 	{
 		default_power_level
@@ -4299,6 +4936,21 @@ const
 	return ret;
 }
 
+int64_t
+ircd::m::room::power::cached_level(const auth::cache::levels &levels,
+                                   const string_view &key,
+                                   const int64_t &default_)
+{
+	const auto it
+	{
+		levels.find(key)
+	};
+
+	return it != end(levels)?
+		it->second:
+		default_;
+}
+
 bool
 ircd::m::room::power::view(const std::function<void (const json::object &)> &closure)
 const
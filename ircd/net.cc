@@ -11,14 +11,62 @@
 #include <ircd/asio.h>
 #include <RB_INC_IFADDRS_H
 
+#ifdef HAVE_LINUX_TLS_H
+#include <linux/tls.h>
+#endif
+
 namespace ircd::net
 {
 	ctx::dock dock;
 
+	static void ktls_close_notify(socket &) noexcept;
 	static void init_ipv6();
 	static void wait_close_sockets();
 }
 
+/// Sends a TLS close_notify alert on a socket which has had its record layer
+/// offloaded to the kernel. The alert is an ordinary write of the two byte
+/// alert body with the record content type conveyed in the ancillary data.
+void
+ircd::net::ktls_close_notify(socket &socket)
+noexcept
+{
+	#if defined(HAVE_LINUX_TLS_H) && defined(TLS_SET_RECORD_TYPE) && defined(SOL_TLS)
+	static const uint8_t alert_type {21};
+	static const uint8_t alert[2]
+	{
+		1, 0 // warning, close_notify
+	};
+
+	char cbuf[CMSG_SPACE(sizeof(alert_type))] {0};
+	struct iovec iov
+	{
+		const_cast<uint8_t *>(alert), sizeof(alert)
+	};
+
+	struct msghdr msg {0};
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = cbuf;
+	msg.msg_controllen = sizeof(cbuf);
+
+	struct cmsghdr *const cmsg(CMSG_FIRSTHDR(&msg));
+	cmsg->cmsg_level = SOL_TLS;
+	cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(alert_type));
+	memcpy(CMSG_DATA(cmsg), &alert_type, sizeof(alert_type));
+
+	ip::tcp::socket &sd(socket);
+	if(::sendmsg(sd.native_handle(), &msg, MSG_DONTWAIT) < 0)
+		log::dwarning
+		{
+			log, "%s ktls close_notify :%s",
+			loghead(socket),
+			strerror(errno),
+		};
+	#endif
+}
+
 void
 ircd::net::wait_close_sockets()
 {
@@ -249,6 +297,16 @@ ircd::net::readable(const socket &socket)
 	return command.get();
 }
 
+std::pair<bool, bool>
+ircd::net::ktls(const socket &socket)
+noexcept
+{
+	return
+	{
+		socket.ktls_rx, socket.ktls_tx
+	};
+}
+
 bool
 ircd::net::opened(const socket &socket)
 noexcept try
@@ -1903,6 +1961,10 @@ noexcept try
 
 	// Toggles the behavior of non-async functions; see func comment
 	blocking(*sock, false);
+
+	if(ssl_ktls_enable)
+		sock->enable_ktls();
+
 	cb(*listener_, sock);
 }
 catch(const ctx::interrupted &e)
@@ -2715,6 +2777,23 @@ ircd::net::ssl_cipher_blacklist
 	{ "default",  string_view{}                   },
 };
 
+decltype(ircd::net::ssl_ktls_enable)
+ircd::net::ssl_ktls_enable
+{
+	{ "name",     "ircd.net.ssl.ktls.enable" },
+	{ "default",  false                      },
+	{ "description",
+
+	R"(
+	Offload the TLS record layer to the kernel (Linux kTLS) after the handshake
+	completes. When successful, record encryption and decryption is conducted
+	by the kernel rather than by OpenSSL in userspace on the ircd thread. This
+	is only possible for TLS 1.2 sessions using AES-GCM; all other sessions and
+	hosts without kernel support remain in userspace. Only affects sockets
+	handshaking after this is set.
+	)"},
+};
+
 boost::asio::ssl::context
 ircd::net::sslv23_client
 {
@@ -2757,6 +2836,27 @@ ircd::net::socket::total_calls_out
 	{ "desc", "The total number of write operations on all sockets"  },
 };
 
+decltype(ircd::net::socket::total_ktls_tx)
+ircd::net::socket::total_ktls_tx
+{
+	{ "name", "ircd.net.socket.ktls.tx"                                  },
+	{ "desc", "The number of sockets with writes offloaded to kernel TLS" },
+};
+
+decltype(ircd::net::socket::total_ktls_rx)
+ircd::net::socket::total_ktls_rx
+{
+	{ "name", "ircd.net.socket.ktls.rx"                                  },
+	{ "desc", "The number of sockets with reads offloaded to kernel TLS"  },
+};
+
+decltype(ircd::net::socket::total_ktls_fallback)
+ircd::net::socket::total_ktls_fallback
+{
+	{ "name", "ircd.net.socket.ktls.fallback"                                },
+	{ "desc", "The number of sockets which could not be offloaded to kernel TLS" },
+};
+
 //
 // socket
 //
@@ -2937,6 +3037,15 @@ try
 
 		case dc::SSL_NOTIFY:
 		{
+			// OpenSSL no longer has the record state after an offload, so
+			// the close_notify alert is sent through the kernel instead.
+			if(ktls_tx)
+			{
+				ktls_close_notify(*this);
+				sd.shutdown(ip::tcp::socket::shutdown_send);
+				break;
+			}
+
 			static ios::descriptor desc
 			{
 				"ircd::net::socket shutdown"
@@ -3120,7 +3229,7 @@ try
 			// real socket wait.
 			static char buf[64];
 			static const ilist<mutable_buffer> bufs{buf};
-			if(SSL_peek(ssl.native_handle(), buf, sizeof(buf)) > 0)
+			if(!ktls_rx && SSL_peek(ssl.native_handle(), buf, sizeof(buf)) > 0)
 			{
 				ircd::post(desc[1], [handle(std::move(handle))]
 				{
@@ -3189,7 +3298,7 @@ noexcept
 		return make_error_code(std::errc::not_connected);
 
 	std::error_code ret;
-	if(SSL_peek(ssl.native_handle(), buf, sizeof(buf)) > 0)
+	if(!ktls_rx && SSL_peek(ssl.native_handle(), buf, sizeof(buf)) > 0)
 		return ret;
 
 	assert(!blocking(*this));
@@ -3234,7 +3343,9 @@ try
 		continuation::asio_predicate, interruption, [this, &ret, &bufs]
 		(auto &yield)
 		{
-			ret = asio::async_read(ssl, std::forward<iov>(bufs), completion, yield);
+			ret = ktls_rx?
+				asio::async_read(sd, std::forward<iov>(bufs), completion, yield):
+				asio::async_read(ssl, std::forward<iov>(bufs), completion, yield);
 		}
 	};
 
@@ -3273,7 +3384,9 @@ try
 		continuation::asio_predicate, interruption, [this, &ret, &bufs]
 		(auto &yield)
 		{
-			ret = ssl.async_read_some(std::forward<iov>(bufs), yield);
+			ret = ktls_rx?
+				sd.async_read_some(std::forward<iov>(bufs), yield):
+				ssl.async_read_some(std::forward<iov>(bufs), yield);
 		}
 	};
 
@@ -3309,7 +3422,9 @@ ircd::net::socket::read_any(iov&& bufs)
 	boost::system::error_code ec;
 	const size_t ret
 	{
-		asio::read(ssl, std::forward<iov>(bufs), completion, ec)
+		ktls_rx?
+			asio::read(sd, std::forward<iov>(bufs), completion, ec):
+			asio::read(ssl, std::forward<iov>(bufs), completion, ec)
 	};
 
 	++in.calls;
@@ -3337,7 +3452,9 @@ ircd::net::socket::read_one(iov&& bufs)
 	boost::system::error_code ec;
 	const size_t ret
 	{
-		ssl.read_some(std::forward<iov>(bufs), ec)
+		ktls_rx?
+			sd.read_some(std::forward<iov>(bufs), ec):
+			ssl.read_some(std::forward<iov>(bufs), ec)
 	};
 
 	++in.calls;
@@ -3379,7 +3496,9 @@ try
 		continuation::asio_predicate, interruption, [this, &ret, &bufs]
 		(auto &yield)
 		{
-			ret = asio::async_write(ssl, std::forward<iov>(bufs), completion, yield);
+			ret = ktls_tx?
+				asio::async_write(sd, std::forward<iov>(bufs), completion, yield):
+				asio::async_write(ssl, std::forward<iov>(bufs), completion, yield);
 		}
 	};
 
@@ -3413,7 +3532,9 @@ try
 		continuation::asio_predicate, interruption, [this, &ret, &bufs]
 		(auto &yield)
 		{
-			ret = ssl.async_write_some(std::forward<iov>(bufs), yield);
+			ret = ktls_tx?
+				sd.async_write_some(std::forward<iov>(bufs), yield):
+				ssl.async_write_some(std::forward<iov>(bufs), yield);
 		}
 	};
 
@@ -3443,7 +3564,9 @@ try
 	assert(!blocking(*this));
 	const size_t ret
 	{
-		asio::write(ssl, std::forward<iov>(bufs), completion)
+		ktls_tx?
+			asio::write(sd, std::forward<iov>(bufs), completion):
+			asio::write(ssl, std::forward<iov>(bufs), completion)
 	};
 
 	++out.calls;
@@ -3467,7 +3590,9 @@ try
 	assert(!blocking(*this));
 	const size_t ret
 	{
-		ssl.write_some(std::forward<iov>(bufs))
+		ktls_tx?
+			sd.write_some(std::forward<iov>(bufs)):
+			ssl.write_some(std::forward<iov>(bufs))
 	};
 
 	++out.calls;
@@ -3813,6 +3938,9 @@ noexcept try
 	if(!ec)
 		blocking(*this, false);
 
+	if(!ec && ssl_ktls_enable)
+		enable_ktls();
+
 	// This is the end of the asynchronous call chain; the user is called
 	// back with or without error here.
 	call_user(callback, ec);
@@ -3853,6 +3981,205 @@ catch(const std::exception &e)
 	call_user(callback, ec);
 }
 
+/// Attempt to offload the TLS record layer of this socket to the kernel
+/// after a successful handshake. This is opportunistic: any condition which
+/// precludes the offload leaves the socket in userspace TLS as it was and the
+/// fallback is counted. Both directions are offloaded or neither is; nothing
+/// is offloaded if OpenSSL has already consumed any bytes following the
+/// handshake from the socket.
+///
+/// Only TLS 1.2 with AES-GCM is offloaded. The key block can be derived with
+/// public OpenSSL interfaces and the record sequence is deterministic at this
+/// point (the Finished message in each direction was record zero). TLS 1.3
+/// traffic secrets and post-handshake record sequences (i.e session tickets)
+/// are not exposed through the asio engine so those sessions remain here.
+bool
+ircd::net::socket::enable_ktls()
+noexcept try
+{
+	#if defined(HAVE_LINUX_TLS_H) && defined(TLS_CIPHER_AES_GCM_256) \
+	&& defined(SOL_TCP) && defined(TCP_ULP) && defined(SOL_TLS)
+	static const string_view ulp
+	{
+		"tls"
+	};
+
+	assert(!ktls_tx && !ktls_rx);
+	assert(ssl.native_handle());
+	SSL &ssl(*this->ssl.native_handle());
+	const auto cipher
+	{
+		openssl::current_cipher(ssl)
+	};
+
+	const int nid
+	{
+		cipher? SSL_CIPHER_get_cipher_nid(cipher): NID_undef
+	};
+
+	const size_t key_len
+	{
+		nid == NID_aes_128_gcm? TLS_CIPHER_AES_GCM_128_KEY_SIZE:
+		nid == NID_aes_256_gcm? TLS_CIPHER_AES_GCM_256_KEY_SIZE:
+		0UL
+	};
+
+	if(openssl::version(ssl) != TLS1_2_VERSION || !key_len || openssl::pending(ssl))
+	{
+		++total_ktls_fallback;
+		return false;
+	}
+
+	// Attach the upper layer protocol. This fails with ENOENT when the kernel
+	// was built without (or has not loaded) the tls module.
+	const int fd(sd.native_handle());
+	if(::setsockopt(fd, SOL_TCP, TCP_ULP, ulp.data(), ulp.size()) != 0)
+	{
+		++total_ktls_fallback;
+		return false;
+	}
+
+	static const size_t salt_len
+	{
+		TLS_CIPHER_AES_GCM_128_SALT_SIZE
+	};
+
+	// For AEAD ciphers the key block is client_write_key, server_write_key,
+	// client_write_IV (salt), server_write_IV (salt).
+	char key_block_buf[2 * (TLS_CIPHER_AES_GCM_256_KEY_SIZE + salt_len)];
+	const unwind cleanse{[&key_block_buf]
+	{
+		OPENSSL_cleanse(key_block_buf, sizeof(key_block_buf));
+	}};
+
+	const const_buffer key_block
+	{
+		openssl::key_block(mutable_buffer(key_block_buf, 2 * (key_len + salt_len)), ssl)
+	};
+
+	const bool server
+	{
+		bool(SSL_is_server(&ssl))
+	};
+
+	const auto *const client_key(reinterpret_cast<const uint8_t *>(data(key_block)));
+	const uint8_t *const server_key(client_key + key_len);
+	const uint8_t *const client_salt(server_key + key_len);
+	const uint8_t *const server_salt(client_salt + salt_len);
+
+	// Record sequence number one in network byte order.
+	static const uint8_t rec_seq[TLS_CIPHER_AES_GCM_128_REC_SEQ_SIZE]
+	{
+		0, 0, 0, 0, 0, 0, 0, 1
+	};
+
+	const auto set{[&fd, &nid]
+	(const int &dir, const uint8_t *const &key, const uint8_t *const &salt)
+	{
+		const auto fill{[&key, &salt](auto &info, const uint16_t &type)
+		{
+			info.info.version = TLS_1_2_VERSION;
+			info.info.cipher_type = type;
+			memcpy(info.key, key, sizeof(info.key));
+			memcpy(info.salt, salt, sizeof(info.salt));
+			memcpy(info.rec_seq, rec_seq, sizeof(info.rec_seq));
+			memcpy(info.iv, rec_seq, sizeof(info.iv));
+			return sizeof(info);
+		}};
+
+		union
+		{
+			tls12_crypto_info_aes_gcm_128 aes128;
+			tls12_crypto_info_aes_gcm_256 aes256;
+		}
+		info;
+
+		const size_t len
+		{
+			nid == NID_aes_128_gcm?
+				fill(info.aes128, TLS_CIPHER_AES_GCM_128):
+				fill(info.aes256, TLS_CIPHER_AES_GCM_256)
+		};
+
+		const auto ret
+		{
+			::setsockopt(fd, SOL_TLS, dir, &info, len)
+		};
+
+		OPENSSL_cleanse(&info, sizeof(info));
+		return ret == 0;
+	}};
+
+	// Reception is installed first; kernels which only offload transmission
+	// refuse it and the session remains in userspace with nothing installed.
+	ktls_rx = set
+	(
+		TLS_RX,
+		server? client_key : server_key,
+		server? client_salt : server_salt
+	);
+
+	if(!ktls_rx)
+	{
+		++total_ktls_fallback;
+		return false;
+	}
+
+	ktls_tx = set
+	(
+		TLS_TX,
+		server? server_key : client_key,
+		server? server_salt : client_salt
+	);
+
+	// Reception can't be returned to userspace once offloaded, so the session
+	// can't continue in either mode; the connection is shut down and fails
+	// through the usual paths.
+	if(unlikely(!ktls_tx))
+	{
+		log::error
+		{
+			log, "%s ktls tx :%s; shutting down.",
+			loghead(*this),
+			strerror(errno),
+		};
+
+		++total_ktls_fallback;
+		::shutdown(fd, SHUT_RDWR);
+		return false;
+	}
+
+	++total_ktls_tx;
+	++total_ktls_rx;
+
+	log::debug
+	{
+		log, "%s ktls tx:%b rx:%b cipher:%s",
+		loghead(*this),
+		ktls_tx,
+		ktls_rx,
+		openssl::name(*cipher),
+	};
+
+	return true;
+	#else
+	++total_ktls_fallback;
+	return false;
+	#endif
+}
+catch(const std::exception &e)
+{
+	log::derror
+	{
+		log, "%s ktls :%s",
+		loghead(*this),
+		e.what(),
+	};
+
+	++total_ktls_fallback;
+	return ktls_tx && ktls_rx;
+}
+
 bool
 ircd::net::socket::handle_verify(const bool valid,
                                  asio::ssl::verify_context &vc,
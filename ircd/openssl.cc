@@ -20,6 +20,7 @@
 #include <RB_INC_OPENSSL_RIPEMD_H
 #include <RB_INC_OPENSSL_DH_H
 #include <RB_INC_OPENSSL_TLS1_H
+#include <RB_INC_OPENSSL_KDF_H
 
 // Metaconditions for which OpenSSL API to use. This produces a single #define
 // to simplify further #ifdef's throught this definition file.
@@ -76,6 +77,188 @@ ircd::openssl::libressl_version_api
 };
 #endif LIBRESSL_VERSION_NUMBER
 
+//
+// Session suite
+//
+
+int
+ircd::openssl::version(const SSL &ssl)
+{
+	return SSL_version(&ssl);
+}
+
+/// True if the SSL holds any input which has not been consumed by the user;
+/// this includes both decrypted application data and raw records still
+/// sitting in the read BIO. Offloading the record layer (i.e kTLS) is only
+/// possible when this is false, otherwise those bytes would be lost.
+bool
+ircd::openssl::pending(const SSL &ssl)
+{
+	auto &mssl
+	{
+		const_cast<SSL &>(ssl)
+	};
+
+	if(SSL_pending(&mssl) > 0)
+		return true;
+
+	#ifdef IRCD_OPENSSL_API_1_1_X
+	if(SSL_has_pending(&mssl))
+		return true;
+	#endif
+
+	BIO *const rbio
+	{
+		SSL_get_rbio(&mssl)
+	};
+
+	return rbio && BIO_ctrl_pending(rbio) > 0;
+}
+
+ircd::const_buffer
+ircd::openssl::client_random(const mutable_buffer &buf,
+                             const SSL &ssl)
+{
+	const size_t len
+	{
+		SSL_get_client_random(&ssl, reinterpret_cast<uint8_t *>(data(buf)), size(buf))
+	};
+
+	return const_buffer
+	{
+		data(buf), len
+	};
+}
+
+ircd::const_buffer
+ircd::openssl::server_random(const mutable_buffer &buf,
+                             const SSL &ssl)
+{
+	const size_t len
+	{
+		SSL_get_server_random(&ssl, reinterpret_cast<uint8_t *>(data(buf)), size(buf))
+	};
+
+	return const_buffer
+	{
+		data(buf), len
+	};
+}
+
+ircd::const_buffer
+ircd::openssl::master_key(const mutable_buffer &buf,
+                          const SSL &ssl)
+{
+	const SSL_SESSION *const sess
+	{
+		SSL_get_session(&ssl)
+	};
+
+	if(unlikely(!sess))
+		throw error
+		{
+			"No session established."
+		};
+
+	const size_t len
+	{
+		SSL_SESSION_get_master_key(sess, reinterpret_cast<uint8_t *>(data(buf)), size(buf))
+	};
+
+	return const_buffer
+	{
+		data(buf), len
+	};
+}
+
+/// Derives the TLS 1.2 key block (RFC 5246 6.3) for the current session into
+/// the buffer; the size of the buffer determines the amount derived. The
+/// layout of the result depends on the cipher; for the AEAD ciphers it is
+/// client_write_key, server_write_key, client_write_IV, server_write_IV.
+ircd::const_buffer
+ircd::openssl::key_block(const mutable_buffer &buf,
+                         const SSL &ssl)
+{
+	#ifdef IRCD_OPENSSL_API_1_1_X
+	if(unlikely(version(ssl) != TLS1_2_VERSION))
+		throw error
+		{
+			"Key block derivation is only available for TLS 1.2."
+		};
+
+	const auto cipher
+	{
+		current_cipher(ssl)
+	};
+
+	if(unlikely(!cipher))
+		throw error
+		{
+			"No cipher negotiated."
+		};
+
+	const EVP_MD *const md
+	{
+		SSL_CIPHER_get_handshake_digest(cipher)
+	};
+
+	char master_buf[SSL_MAX_MASTER_KEY_LENGTH];
+	const unwind cleanse{[&master_buf]
+	{
+		OPENSSL_cleanse(master_buf, sizeof(master_buf));
+	}};
+
+	const const_buffer master
+	{
+		master_key(master_buf, ssl)
+	};
+
+	char client_buf[SSL3_RANDOM_SIZE], server_buf[SSL3_RANDOM_SIZE];
+	const const_buffer crand
+	{
+		client_random(client_buf, ssl)
+	};
+
+	const const_buffer srand
+	{
+		server_random(server_buf, ssl)
+	};
+
+	static const string_view label
+	{
+		"key expansion"
+	};
+
+	const custom_ptr<EVP_PKEY_CTX> ctx
+	{
+		EVP_PKEY_CTX_new_id(EVP_PKEY_TLS1_PRF, nullptr), EVP_PKEY_CTX_free
+	};
+
+	const auto uc
+	{
+		[](const auto &buf)
+		{
+			return reinterpret_cast<const uint8_t *>(data(buf));
+		}
+	};
+
+	size_t len(size(buf));
+	call(::EVP_PKEY_derive_init, ctx.get());
+	call(::EVP_PKEY_CTX_set_tls1_prf_md, ctx.get(), md);
+	call(::EVP_PKEY_CTX_set1_tls1_prf_secret, ctx.get(), uc(master), size(master));
+	call(::EVP_PKEY_CTX_add1_tls1_prf_seed, ctx.get(), uc(label), size(label));
+	call(::EVP_PKEY_CTX_add1_tls1_prf_seed, ctx.get(), uc(srand), size(srand));
+	call(::EVP_PKEY_CTX_add1_tls1_prf_seed, ctx.get(), uc(crand), size(crand));
+	call(::EVP_PKEY_derive, ctx.get(), reinterpret_cast<uint8_t *>(data(buf)), &len);
+	return const_buffer
+	{
+		data(buf), len
+	};
+	#else
+	throw not_implemented{};
+	#endif
+}
+
 //
 // SNI
 //
@@ -367,7 +367,7 @@ ircd::resource::method::method(struct resource &resource,
 }
 ,stats
 {
-	std::make_unique<struct stats>()
+	std::make_unique<struct stats>(*this)
 }
 ,methods_it{[this, &name]
 {
@@ -392,6 +392,22 @@ ircd::resource::method::method(struct resource &resource,
 {
 }
 
+ircd::resource::method::stats::stats(const method &method)
+:latency
+{
+	json::members
+	{
+		{ "name", fmt::snstringf
+		{
+			ircd::stats::item::NAME_MAX_LEN, "ircd.resource.%s.%s.usec",
+			lstrip(method.resource->path, '/'),
+			method.name,
+		}},
+	}
+}
+{
+}
+
 ircd::resource::method::~method()
 noexcept
 {
@@ -429,6 +445,12 @@ try
 		stats->pending
 	};
 
+	const ircd::timer timer;
+	const unwind record_latency{[this, &timer]
+	{
+		stats->latency(timer.at<microseconds>().count());
+	}};
+
 	// Bail out if the method limited the amount of content and it was exceeded.
 	if(head.content_length > opts->payload_max)
 		throw http::error
@@ -19,6 +19,7 @@ namespace ircd::server
 	template<class F> size_t accumulate_peers(F&&);
 	template<class F> size_t accumulate_links(F&&);
 	template<class F> size_t accumulate_tags(F&&);
+	static uint64_t ewma(const uint64_t &avg, const uint64_t &val) noexcept;
 
 	// Internal control
 	static decltype(ircd::server::peers)::iterator
@@ -31,6 +32,18 @@ ircd::server::log
 	"server", 'S'
 };
 
+/// Moving average with a weight of 1/8 for the new value; the first value
+/// seeds the average.
+uint64_t
+ircd::server::ewma(const uint64_t &avg,
+                   const uint64_t &val)
+noexcept
+{
+	return avg?
+		avg - (avg >> 3) + (val >> 3):
+		val;
+}
+
 ircd::conf::item<ircd::seconds>
 close_all_timeout
 {
@@ -561,6 +574,30 @@ ircd::server::peer::link_max_default
 	{ "default",  4L                          }
 };
 
+decltype(ircd::server::peer::link_adaptive)
+ircd::server::peer::link_adaptive
+{
+	{ "name",     "ircd.server.peer.link.adaptive" },
+	{ "default",  true                             },
+	{
+		"description",
+		"Adjust the number of links to each peer between link_min and"
+		" link_max based on how long requests wait in the link queues."
+	},
+};
+
+decltype(ircd::server::peer::link_queue_target)
+ircd::server::peer::link_queue_target
+{
+	{ "name",     "ircd.server.peer.link.queue_target" },
+	{ "default",  50L                                  },
+	{
+		"description",
+		"Milliseconds a request may wait in a link queue before the peer"
+		" is permitted another link (adaptive mode)."
+	},
+};
+
 decltype(ircd::server::peer::ids)
 ircd::server::peer::ids;
 
@@ -758,13 +795,21 @@ ircd::server::peer::link_get(const request &request)
 		links.size() >= link_max()
 	};
 
-	link *best{nullptr};
+	link *best{nullptr}, *stalled{nullptr};
 	for(auto &cand : links)
 	{
 		// Don't want a link that's shutting down or marked for exclusion
 		if(cand.op_fini || cand.exclude)
 			continue;
 
+		// Don't want to queue behind a response which isn't arriving; this
+		// link is only considered as a last resort.
+		if(cand.stalled())
+		{
+			stalled = stalled?: &cand;
+			continue;
+		}
+
 		if(!best)
 		{
 			best = &cand;
@@ -828,7 +873,7 @@ ircd::server::peer::link_get(const request &request)
 	}
 
 	if(links_maxed)
-		return best;
+		return best?: stalled;
 
 	// best might not be good enough, we could try another connection. If best
 	// has a backlog or is working on a large download or slow request.
@@ -838,6 +883,10 @@ ircd::server::peer::link_get(const request &request)
 		return best;
 	}
 
+	// The adaptive target has grown beyond the links currently open.
+	if(links.size() < link_target())
+		return &link_add();
+
 	if(best->tag_uncommitted() < best->tag_commit_max())
 		return best;
 
@@ -986,6 +1035,36 @@ ircd::server::peer::handle_finished(link &link)
 		handle_finished();
 }
 
+/// This is where we're notified a tag is about to be committed to the wire
+/// after waiting in the link's queue. The adaptive link target grows when
+/// this wait exceeds the target, up to link_max.
+void
+ircd::server::peer::handle_tag_commit(link &link,
+                                      tag &tag,
+                                      const microseconds &queued)
+noexcept
+{
+	if(!link_adaptive)
+		return;
+
+	if(queued <= milliseconds(link_queue_target))
+		return;
+
+	if(link_target() >= link_max())
+		return;
+
+	link_want = std::max(link_target(), links.size()) + 1;
+	log::debug
+	{
+		log, "%s tag:%lu queued %ld us; growing target to %zu of %zu links",
+		loghead(link),
+		tag.state.id,
+		queued.count(),
+		link_target(),
+		link_max(),
+	};
+}
+
 /// This is where we're notified a tag has been completed either to start the
 /// next request when the link has too many requests in flight or perhaps to
 /// reschedule the queues in various links to diffuse the pending requests.
@@ -1045,8 +1124,28 @@ ircd::server::peer::handle_link_done(link &link)
 {
 	assert(link.tag_count() == 0);
 
-	if(link_ready() > link_min())
+	// The link drained without requests waiting long; the adaptive target
+	// decays toward link_min so idle links are shed.
+	const bool decay
 	{
+		link_adaptive
+		&& link_want > link_min()
+		&& link.queue_avg < uint64_t(duration_cast<microseconds>(milliseconds(link_queue_target)).count() / 2)
+	};
+
+	if(decay)
+		--link_want;
+
+	if(link_ready() > link_target())
+	{
+		log::debug
+		{
+			log, "%s idle; closing with %zu ready links over target %zu",
+			loghead(link),
+			link_ready(),
+			link_target(),
+		};
+
 		link.close();
 		return;
 	}
@@ -1628,6 +1727,16 @@ const
 	return link_max_default;
 }
 
+size_t
+ircd::server::peer::link_target()
+const
+{
+	if(!link_adaptive)
+		return link_min();
+
+	return std::min(std::max(link_want, link_min()), link_max());
+}
+
 bool
 ircd::server::peer::finished()
 const
@@ -1694,6 +1803,26 @@ ircd::server::link::tag_commit_max_default
 	{ "default",  3L                                }
 };
 
+decltype(ircd::server::link::stall_default)
+ircd::server::link::stall_default
+{
+	{ "name",     "ircd.server.link.stall" },
+	{ "default",  5L                       },
+	{
+		"description",
+		"Seconds without any response data for a fully written request at"
+		" the head of a link's queue before new requests avoid that link."
+	},
+};
+
+/// Time from a request being completely written until its response is
+/// completely read, in microseconds.
+decltype(ircd::server::link::rtt)
+ircd::server::link::rtt
+{
+	{ "name", "ircd.server.link.rtt.usec" },
+};
+
 decltype(ircd::server::link::ids)
 ircd::server::link::ids;
 
@@ -1765,6 +1894,8 @@ ircd::server::link::submit(request &request)
 		request.tag? queue.emplace(end(queue), std::move(*request.tag)):
 		             queue.emplace(end(queue), request)
 	};
+
+	it->state.queued = now<steady_point>();
 /*
 	log::debug
 	{
@@ -1891,6 +2022,8 @@ ircd::server::link::handle_open(std::exception_ptr eptr)
 	assert(op_init);
 	op_init = false;
 	synack_ts = time<seconds>();
+	if(!eptr)
+		open_point = now<steady_point>();
 
 	if(!eptr && !op_fini)
 		wait_writable();
@@ -2062,6 +2195,28 @@ ircd::server::link::handle_writable_success()
 bool
 ircd::server::link::process_write(tag &tag)
 {
+	// Tags queued before the socket opened waited on the resolve, connect
+	// and handshake rather than on this link's queue; they're left out so
+	// the first sample after the handshake seeds the average.
+	const bool sample
+	{
+		!tag.committed()
+		&& tag.state.queued != steady_point{}
+		&& open_point != steady_point{}
+		&& tag.state.queued >= open_point
+	};
+
+	if(sample)
+	{
+		const auto queued
+		{
+			duration_cast<microseconds>(now<steady_point>() - tag.state.queued)
+		};
+
+		queue_avg = ewma(queue_avg, queued.count());
+		peer->handle_tag_commit(*this, tag, queued);
+	}
+
 	if(!tag.committed())
 	{
 		log::debug
@@ -2265,6 +2420,17 @@ try
 		return done;
 	}
 
+	if(likely(tag.state.wrote != steady_point{}))
+	{
+		const auto elapsed
+		{
+			duration_cast<microseconds>(now<steady_point>() - tag.state.wrote)
+		};
+
+		rtt(elapsed.count());
+		rtt_avg = ewma(rtt_avg, elapsed.count());
+	}
+
 	peer->handle_tag_done(*this, tag);
 	assert(!queue.empty());
 	queue.pop_front();
@@ -2493,6 +2659,38 @@ const
 	return !queue.empty();
 }
 
+/// The request at the head of the queue was completely written but no
+/// response data has arrived for the stall duration; anything queued behind
+/// it is held up.
+bool
+ircd::server::link::stalled()
+const
+{
+	if(queue.empty())
+		return false;
+
+	const auto &tag
+	{
+		queue.front()
+	};
+
+	if(!tag.committed() || tag.state.wrote == steady_point{})
+		return false;
+
+	const seconds stall
+	{
+		stall_default
+	};
+
+	const auto now
+	{
+		ircd::now<steady_point>()
+	};
+
+	return now - tag.state.wrote > stall
+	&& time<seconds>() - read_ts > stall.count();
+}
+
 bool
 ircd::server::link::ready()
 const
@@ -2797,6 +2995,8 @@ ircd::server::tag::wrote_buffer(const const_buffer &buffer)
 	assert(request);
 	const auto &req{*request};
 	state.written += size(buffer);
+	if(state.written == write_size())
+		state.wrote = now<steady_point>();
 
 	if(state.written <= size(req.out.head))
 	{
@@ -12,6 +12,10 @@ decltype(ircd::stats::items)
 ircd::stats::items
 {};
 
+decltype(ircd::stats::histograms)
+ircd::stats::histograms
+{};
+
 std::ostream &
 ircd::stats::operator<<(std::ostream &s, const item &item)
 {
@@ -77,3 +81,115 @@ noexcept
 		items.erase(it);
 	}
 }
+
+//
+// histogram
+//
+
+ircd::stats::histogram::histogram(const json::members &opts,
+                                  const bool &summary)
+:feature_
+{
+	opts
+}
+,feature
+{
+	feature_
+}
+,name
+{
+	unquote(feature.at("name"))
+}
+,summary
+{
+	summary
+}
+{
+	if(name.size() > item::NAME_MAX_LEN)
+		throw error
+		{
+			"Stats histogram '%s' name length:%zu exceeds max:%zu",
+			name,
+			name.size(),
+			item::NAME_MAX_LEN
+		};
+
+	if(!histograms.emplace(name, this).second)
+		throw error
+		{
+			"Stats histogram named '%s' already exists", name
+		};
+}
+
+ircd::stats::histogram::~histogram()
+noexcept
+{
+	if(name)
+	{
+		const auto it{histograms.find(name)};
+		assert(data(it->first) == data(name));
+		histograms.erase(it);
+	}
+}
+
+void
+ircd::stats::histogram::clear()
+{
+	bucket.fill(0);
+	count = 0;
+	sum = 0;
+}
+
+/// Estimate of the q-quantile (0.0 - 1.0); the inclusive upper bound of the
+/// bucket containing it.
+uint64_t
+ircd::stats::histogram::quantile(const double &q)
+const
+{
+	const uint64_t target
+	{
+		uint64_t(std::ceil(std::clamp(q, 0.0, 1.0) * count))
+	};
+
+	uint64_t accum(0);
+	for(size_t i(0); i < bucket.size(); ++i)
+		if((accum += bucket[i]) >= target && accum)
+			return upper(i);
+
+	return 0;
+}
+
+/// Inclusive upper bound of the values counted by the bucket at index.
+uint64_t
+ircd::stats::histogram::upper(const size_t &index)
+noexcept
+{
+	if(index < SUBS)
+		return index;
+
+	const size_t log
+	{
+		index / SUBS + SUB_BITS - 1
+	};
+
+	const uint64_t width
+	{
+		1UL << (log - SUB_BITS)
+	};
+
+	return index < BUCKETS - 1?
+		(1UL << log) + (index % SUBS) * width + width - 1:
+		std::numeric_limits<uint64_t>::max();
+}
+
+//
+// summary
+//
+
+ircd::stats::summary::summary(const json::members &opts)
+:histogram
+{
+	opts, true
+}
+{
+}
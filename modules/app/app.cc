@@ -18,6 +18,17 @@ IRCD_MODULE
 	ircd::m::app::fini
 };
 
+namespace ircd::m::app
+{
+	static void add(matcher &, service &, const json::object &ns);
+	static void add(matcher &, service &, const string_view &namespaces);
+	static void check_url(const string_view &url);
+	static void check_config(const m::event &, vm::eval &);
+	static void handle_config(const m::event &, vm::eval &);
+	extern hookfn<vm::eval &> check_config_hook;
+	extern hookfn<vm::eval &> config_hook;
+}
+
 decltype(ircd::m::app::ns::users)
 ircd::m::app::ns::users;
 
@@ -27,16 +38,47 @@ ircd::m::app::ns::aliases;
 decltype(ircd::m::app::ns::rooms)
 ircd::m::app::ns::rooms;
 
+decltype(ircd::m::app::ns::version)
+ircd::m::app::ns::version;
+
+decltype(ircd::m::app::services)
+ircd::m::app::services;
+
 decltype(ircd::m::app::app_room_id)
 ircd::m::app::app_room_id
 {
 	"app", my_host()
 };
 
+decltype(ircd::m::app::check_config_hook)
+ircd::m::app::check_config_hook
+{
+	check_config,
+	{
+		{ "_site",  "vm.eval"    },
+		{ "type",   "ircd.app"   },
+	}
+};
+
+decltype(ircd::m::app::config_hook)
+ircd::m::app::config_hook
+{
+	handle_config,
+	{
+		{ "_site",  "vm.effect"  },
+		{ "type",   "ircd.app"   },
+	}
+};
+
 void
 ircd::m::app::fini()
 {
-
+	ns::users.clear();
+	ns::aliases.clear();
+	ns::rooms.clear();
+	room_cache.clear();
+	++ns::version;
+	services.clear();
 }
 
 void
@@ -48,6 +90,94 @@ ircd::m::app::init()
 	init_apps();
 }
 
+/// Registrations this server can't deliver to are refused here rather than
+/// accepted into a queue which would never drain.
+void
+ircd::m::app::check_config(const m::event &event,
+                           vm::eval &eval)
+{
+	if(json::get<"room_id"_>(event) != app_room_id)
+		return;
+
+	const json::object &content
+	{
+		json::get<"content"_>(event)
+	};
+
+	check_url(json::string(content.get("url")));
+}
+
+/// Transactions are sent through ircd::server, which only connects with TLS
+/// and won't connect to a loopback address. A null url is valid; the
+/// appservice wants no traffic.
+void
+ircd::m::app::check_url(const string_view &url)
+{
+	if(empty(url) || url == "null")
+		return;
+
+	const rfc3986::uri uri
+	{
+		url
+	};
+
+	if(uri.scheme != "https")
+		throw m::UNSUPPORTED
+		{
+			"Appservice url '%s' must be https.",
+			url,
+		};
+
+	const string_view host
+	{
+		rfc3986::host(uri.remote)
+	};
+
+	const bool loopback
+	{
+		host == "localhost" ||
+		host == "::1" ||
+		host == "[::1]" ||
+		startswith(host, "127.")
+	};
+
+	if(loopback)
+		throw m::UNSUPPORTED
+		{
+			"Appservice url '%s' must not be a loopback address.",
+			url,
+		};
+}
+
+void
+ircd::m::app::handle_config(const m::event &event,
+                            vm::eval &eval)
+try
+{
+	if(json::get<"room_id"_>(event) != app_room_id)
+		return;
+
+	const auto &id
+	{
+		json::get<"state_key"_>(event)
+	};
+
+	init_app(id, json::get<"content"_>(event));
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		log, "Failed to update appservice '%s' :%s",
+		json::get<"state_key"_>(event),
+		e.what(),
+	};
+}
+
 void
 ircd::m::app::init_apps()
 {
@@ -74,16 +204,305 @@ ircd::m::app::init_app(const string_view &id,
                        const json::object &config)
 try
 {
+	const json::string url
+	{
+		config.get("url")
+	};
+
+	auto it
+	{
+		services.find(id)
+	};
+
+	if(it != end(services) && it->second->config == string_view{config})
+		return;
+
+	// A null url means the appservice does not want any traffic. A url which
+	// can't be delivered to may have been stored before it was refused at eval.
+	const bool disabled
+	{
+		empty(url) || url == "null"
+	};
 
+	if(!disabled)
+		check_url(url);
+
+	if(disabled)
+	{
+		if(it == end(services))
+			return;
+
+		// Nothing may match the service once it's gone; its worker is
+		// stopped (which yields) only after the matchers are rebuilt.
+		const std::unique_ptr<service> old
+		{
+			std::move(it->second)
+		};
+
+		services.erase(it);
+		rebuild();
+		return;
+	}
+
+	auto svc
+	{
+		std::make_unique<service>(id, config)
+	};
+
+	if(it != end(services))
+	{
+		// Stop the old worker before taking over whatever it had not yet
+		// delivered; the pending transaction keeps its txnId so the
+		// appservice can still deduplicate it. The old service still
+		// matches while this yields; whatever it queues meanwhile is
+		// carried over with the rest.
+		auto &old(*it->second);
+		old.worker.terminate();
+		old.worker.join();
+		svc->queue = std::move(old.queue);
+		svc->pending = std::move(old.pending);
+		svc->txnid = std::move(old.txnid);
+		it->second = std::move(svc);
+	}
+	else it = services.emplace(std::string{id}, std::move(svc)).first;
+
+	rebuild();
+	it->second->dock.notify_all();
+
+	log::info
+	{
+		log, "Appservice '%s' registered for transactions to %s",
+		id,
+		string_view{url},
+	};
 }
 catch(const std::exception &e)
 {
 	log::error
 	{
-		m::log, "Failed to init appservice '%s' :%s", id, e.what()
+		log, "Failed to init appservice '%s' :%s", id, e.what()
+	};
+}
+
+/// The matchers are built aside and swapped in whole, so matching continues
+/// against the previous set until the new one is complete; the version lets
+/// a match which yielded notice it must start over.
+void
+ircd::m::app::rebuild()
+{
+	matcher users, aliases, rooms;
+	for(const auto &[id, svc] : services)
+	{
+		const json::object config
+		{
+			svc->config
+		};
+
+		const json::object namespaces
+		{
+			config.get("namespaces")
+		};
+
+		add(users, *svc, namespaces.get("users"));
+		add(aliases, *svc, namespaces.get("aliases"));
+		add(rooms, *svc, namespaces.get("rooms"));
+	}
+
+	std::swap(ns::users, users);
+	std::swap(ns::aliases, aliases);
+	std::swap(ns::rooms, rooms);
+	room_cache.clear();
+	++ns::version;
+
+	log::debug
+	{
+		log, "Namespaces for %zu appservices users:%zu aliases:%zu rooms:%zu",
+		services.size(),
+		ns::users.size(),
+		ns::aliases.size(),
+		ns::rooms.size(),
+	};
+}
+
+/// Namespaces are specified as an array of objects; a lone object is also
+/// accepted for registrations made against the older single-namespace form.
+void
+ircd::m::app::add(matcher &matcher,
+                  service &svc,
+                  const string_view &namespaces)
+{
+	if(json::type(namespaces, std::nothrow) == json::OBJECT)
+		return add(matcher, svc, json::object{namespaces});
+
+	if(json::type(namespaces, std::nothrow) != json::ARRAY)
+		return;
+
+	for(const json::object ns : json::array{namespaces})
+		add(matcher, svc, ns);
+}
+
+void
+ircd::m::app::add(matcher &matcher,
+                  service &svc,
+                  const json::object &ns)
+try
+{
+	const json::string regex
+	{
+		ns.get("regex")
+	};
+
+	if(!empty(regex))
+		matcher.add(svc, regex);
+}
+catch(const std::regex_error &e)
+{
+	log::error
+	{
+		log, "Appservice '%s' namespace regex %s :%s",
+		svc.id,
+		ns.get("regex"),
+		e.what(),
+	};
+}
+
+//
+// matcher
+//
+
+void
+ircd::m::app::matcher::clear()
+{
+	patterns.clear();
+	lengths.clear();
+}
+
+void
+ircd::m::app::matcher::add(service &svc,
+                           const string_view &regex)
+{
+	std::string key
+	{
+		prefix(regex)
 	};
+
+	pattern pattern
+	{
+		std::regex
+		{
+			begin(regex), end(regex),
+			std::regex::ECMAScript | std::regex::optimize
+		},
+		&svc,
+	};
+
+	lengths.emplace(key.size());
+	patterns.emplace(std::move(key), std::move(pattern));
 }
 
+/// Values are tested only against expressions whose literal prefix they
+/// begin with. Expressions are anchored at the start of the value as other
+/// homeserver implementations do.
+void
+ircd::m::app::matcher::match(const string_view &value,
+                             const closure &closure)
+const
+{
+	for(const auto &length : lengths)
+	{
+		if(length > ircd::size(value))
+			break;
+
+		const string_view key
+		{
+			data(value), length
+		};
+
+		const auto range
+		{
+			patterns.equal_range(key)
+		};
+
+		for(auto it(range.first); it != range.second; ++it)
+			if(std::regex_search(begin(value), end(value), it->second.regex, std::regex_constants::match_continuous))
+				closure(*it->second.svc);
+	}
+}
+
+size_t
+ircd::m::app::matcher::size()
+const
+{
+	return patterns.size();
+}
+
+/// The run of literal characters an expression must begin with. An empty
+/// prefix is always safe; it places the expression in the set tested against
+/// every value.
+std::string
+ircd::m::app::matcher::prefix(const string_view &regex)
+{
+	static const string_view meta
+	{
+		".[]()*+?{}|$^\\"
+	};
+
+	// Any top-level alternation means the expression has no common prefix.
+	for(size_t i(0), depth(0), klass(0); i < regex.size(); ++i)
+		switch(regex[i])
+		{
+			case '\\':  ++i;                         continue;
+			case '[':   klass = 1;                   continue;
+			case ']':   klass = 0;                   continue;
+			case '(':   depth += !klass;             continue;
+			case ')':   depth -= !klass && depth;    continue;
+			case '|':
+				if(!depth && !klass)
+					return {};
+
+				continue;
+		}
+
+	std::string ret;
+	ret.reserve(regex.size());
+	for(size_t i(startswith(regex, '^')); i < regex.size(); ++i)
+	{
+		char c(regex[i]);
+		size_t len(1);
+		if(c == '\\')
+		{
+			if(i + 1 >= regex.size() || !ispunct(regex[i + 1]))
+				break;
+
+			c = regex[i + 1];
+			len = 2;
+		}
+		else if(has(meta, c))
+			break;
+
+		const char next
+		{
+			i + len < regex.size()? regex[i + len] : '\0'
+		};
+
+		// The character may not appear at all.
+		if(next == '*' || next == '?' || next == '{')
+			break;
+
+		ret.push_back(c);
+		if(next == '+')
+			break;
+
+		i += len - 1;
+	}
+
+	return ret;
+}
+
+//
+// config
+//
+
 std::string
 IRCD_MODULE_EXPORT
 ircd::m::app::config::get(const string_view &id)
@@ -143,7 +562,7 @@ IRCD_MODULE_EXPORT
 ircd::m::app::config::idx(const string_view &id)
 {
 	const m::room::state state{app_room_id};
-	return state.get(std::nothrow, "ircd.app", id);
+	return state.get("ircd.app", id);
 }
 
 ircd::m::event::idx
@@ -152,7 +571,7 @@ ircd::m::app::config::idx(std::nothrow_t,
                           const string_view &id)
 {
 	const m::room::state state{app_room_id};
-	return state.get("ircd.app", id);
+	return state.get(std::nothrow, "ircd.app", id);
 }
 
 bool
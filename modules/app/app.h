@@ -8,16 +8,89 @@
 // copyright notice and this permission notice is present in all copies. The
 // full license for this software is available in the LICENSE file.
 
+#include <RB_INC_REGEX
+
+namespace ircd::m::app
+{
+	struct service;
+	struct matcher;
+}
+
+/// A single compiled matcher for one kind of namespace (users, aliases or
+/// rooms) across every registered appservice. Each pattern is indexed by the
+/// literal prefix which leads its expression; a value is only tested against
+/// the expressions whose prefix it begins with, so the cost of a match does
+/// not grow with the number of appservices sharing no prefix with the value.
+struct ircd::m::app::matcher
+{
+	struct pattern;
+	using closure = std::function<void (service &)>;
+
+	std::multimap<std::string, pattern, std::less<>> patterns;
+	std::set<size_t> lengths;
+
+	static std::string prefix(const string_view &regex);
+
+  public:
+	size_t size() const;
+	void match(const string_view &value, const closure &) const;
+	void add(service &, const string_view &regex);
+	void clear();
+};
+
+struct ircd::m::app::matcher::pattern
+{
+	std::regex regex;
+	service *svc {nullptr};
+};
+
+/// Push state for one registered appservice. Events matched by the hook are
+/// queued here in client format; the worker drains the queue into batched
+/// transactions and retries the same transaction with backoff until the
+/// appservice accepts it.
+struct ircd::m::app::service
+{
+	std::string id;
+	std::string config;
+	std::string url;
+	std::string hs_token;
+	std::deque<std::string> queue;
+	std::vector<std::string> pending;
+	std::string txnid;
+	ctx::dock dock;
+	size_t queued {0};
+	size_t dropped {0};
+	size_t sent {0};
+	size_t txns {0};
+	size_t failures {0};
+	size_t attempt {0};
+	ctx::context worker;
+
+	bool transmit();
+	void main();
+
+  public:
+	void push(std::string event);
+
+	service(const string_view &id, const json::object &config);
+	service(service &&) = delete;
+	service(const service &) = delete;
+};
+
 namespace ircd::m::app::ns
 {
-	extern std::set<std::string> users;
-	extern std::set<std::string> aliases;
-	extern std::set<std::string> rooms;
+	extern matcher users;
+	extern matcher aliases;
+	extern matcher rooms;
+	extern uint64_t version;
 }
 
 // app.cc
 namespace ircd::m::app
 {
+	extern std::map<std::string, std::unique_ptr<service>, std::less<>> services;
+
+	void rebuild();
 	void init_app(const string_view &id, const json::object &config);
 	void init_apps();
 	void init();
@@ -25,3 +98,15 @@ namespace ircd::m::app
 
 	extern const m::room::id::buf app_room_id;
 }
+
+// transactions.cc
+namespace ircd::m::app
+{
+	extern conf::item<size_t> txn_events_max;
+	extern conf::item<size_t> queue_max;
+	extern conf::item<seconds> txn_timeout;
+	extern conf::item<milliseconds> backoff_min;
+	extern conf::item<milliseconds> backoff_max;
+	extern conf::item<size_t> room_cache_max;
+	extern std::map<std::string, std::vector<service *>, std::less<>> room_cache;
+}
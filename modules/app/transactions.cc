@@ -9,3 +9,539 @@
 // full license for this software is available in the LICENSE file.
 
 #include "app.h"
+
+namespace ircd::m::app
+{
+	static milliseconds backoff(const size_t &attempt);
+	static std::vector<service *> interest(const room::id &);
+	static std::vector<service *> targets(const m::event &);
+	static void handle_event(const m::event &, vm::eval &);
+	extern hookfn<vm::eval &> notify_hook;
+}
+
+decltype(ircd::m::app::txn_events_max)
+ircd::m::app::txn_events_max
+{
+	{ "name",     "ircd.app.txn.events.max" },
+	{ "default",  512L                      },
+	{
+		"description",
+		"Maximum number of events sent to an appservice in one transaction."
+	},
+};
+
+decltype(ircd::m::app::queue_max)
+ircd::m::app::queue_max
+{
+	{ "name",     "ircd.app.queue.max" },
+	{ "default",  65536L               },
+	{
+		"description",
+		"Maximum number of events held for an appservice which is not keeping"
+		" up; the oldest events are dropped beyond this."
+	},
+};
+
+decltype(ircd::m::app::txn_timeout)
+ircd::m::app::txn_timeout
+{
+	{ "name",     "ircd.app.txn.timeout" },
+	{ "default",  30L                    },
+};
+
+decltype(ircd::m::app::backoff_min)
+ircd::m::app::backoff_min
+{
+	{ "name",     "ircd.app.backoff.min" },
+	{ "default",  250L                   },
+};
+
+decltype(ircd::m::app::backoff_max)
+ircd::m::app::backoff_max
+{
+	{ "name",     "ircd.app.backoff.max" },
+	{ "default",  300000L                },
+};
+
+decltype(ircd::m::app::room_cache_max)
+ircd::m::app::room_cache_max
+{
+	{ "name",     "ircd.app.room_cache.max" },
+	{ "default",  16384L                    },
+	{
+		"description",
+		"Number of rooms for which the appservices interested by their room_id,"
+		" aliases or members are remembered."
+	},
+};
+
+decltype(ircd::m::app::room_cache)
+ircd::m::app::room_cache;
+
+decltype(ircd::m::app::notify_hook)
+ircd::m::app::notify_hook
+{
+	handle_event,
+	{
+		{ "_site",  "vm.effect" },
+	}
+};
+
+void
+ircd::m::app::handle_event(const m::event &event,
+                           vm::eval &eval)
+try
+{
+	if(services.empty())
+		return;
+
+	if(!json::get<"room_id"_>(event) || m::internal(at<"room_id"_>(event)))
+		return;
+
+	std::string serial;
+	std::vector<service *> svcs;
+	for(uint64_t version(ns::version);; version = ns::version)
+	{
+		svcs = targets(event);
+		if(version != ns::version)
+			continue;
+
+		if(svcs.empty())
+			return;
+
+		if(serial.empty())
+		{
+			const unique_buffer<mutable_buffer> buf
+			{
+				event::MAX_SIZE * 2
+			};
+
+			json::stack out{buf};
+			{
+				json::stack::object top{out};
+				m::event::append::opts opts;
+				opts.event_idx = eval.sequence? &eval.sequence : nullptr;
+				opts.query_txnid = false;
+				m::event::append
+				{
+					top, event, opts
+				};
+			}
+
+			serial = out.completed();
+		}
+
+		// Serializing may have yielded to a reconfiguration.
+		if(version == ns::version)
+			break;
+	}
+
+	for(auto it(begin(svcs)); it != end(svcs); ++it)
+		(*it)->push(std::next(it) != end(svcs)? serial : std::move(serial));
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::error
+	{
+		log, "Failed to queue %s for appservices :%s",
+		string_view{event.event_id},
+		e.what(),
+	};
+}
+
+/// Collect the appservices interested in an event. This may yield; callers
+/// must not use the result if ns::version changed in the meantime.
+std::vector<ircd::m::app::service *>
+ircd::m::app::targets(const m::event &event)
+{
+	const m::room::id &room_id
+	{
+		at<"room_id"_>(event)
+	};
+
+	const auto &type
+	{
+		json::get<"type"_>(event)
+	};
+
+	const bool invalidates
+	{
+		defined(json::get<"state_key"_>(event)) &&
+		(type == "m.room.member" || type == "m.room.aliases" || type == "m.room.canonical_alias")
+	};
+
+	if(invalidates)
+		room_cache.erase(room_id);
+
+	auto ret
+	{
+		interest(room_id)
+	};
+
+	const auto add{[&ret](service &svc)
+	{
+		if(!std::count(begin(ret), end(ret), &svc))
+			ret.emplace_back(&svc);
+	}};
+
+	ns::users.match(at<"sender"_>(event), add);
+	if(type == "m.room.member")
+		ns::users.match(json::get<"state_key"_>(event), add);
+
+	return ret;
+}
+
+/// Appservices interested in everything in a room by its room_id, one of its
+/// aliases, or a joined member in a users namespace. This is remembered per
+/// room until membership or aliases change.
+std::vector<ircd::m::app::service *>
+ircd::m::app::interest(const room::id &room_id)
+{
+	const auto it
+	{
+		room_cache.find(room_id)
+	};
+
+	if(it != end(room_cache))
+		return it->second;
+
+	const auto version
+	{
+		ns::version
+	};
+
+	std::vector<service *> ret;
+	const auto add{[&ret](service &svc)
+	{
+		if(!std::count(begin(ret), end(ret), &svc))
+			ret.emplace_back(&svc);
+	}};
+
+	ns::rooms.match(room_id, add);
+
+	const m::room room
+	{
+		room_id
+	};
+
+	if(ns::aliases.size())
+	{
+		const m::room::aliases aliases
+		{
+			room
+		};
+
+		aliases.for_each([&add]
+		(const m::room::alias &alias)
+		{
+			ns::aliases.match(alias, add);
+			return true;
+		});
+
+		const m::room::state state
+		{
+			room
+		};
+
+		const auto event_idx
+		{
+			state.get(std::nothrow, "m.room.canonical_alias", "")
+		};
+
+		m::get(std::nothrow, event_idx, "content", [&add]
+		(const json::object &content)
+		{
+			const json::string alias
+			{
+				content.get("alias")
+			};
+
+			if(!empty(alias))
+				ns::aliases.match(alias, add);
+		});
+	}
+
+	if(ns::users.size())
+	{
+		const m::room::members members
+		{
+			room
+		};
+
+		members.for_each("join", my_host(), [&add]
+		(const m::user::id &user_id)
+		{
+			ns::users.match(user_id, add);
+			return true;
+		});
+	}
+
+	// Pointers collected before a reconfiguration must not be remembered.
+	if(version != ns::version)
+		return {};
+
+	if(room_cache.size() >= size_t(room_cache_max))
+		room_cache.clear();
+
+	room_cache.emplace(std::string{room_id}, ret);
+	return ret;
+}
+
+//
+// service
+//
+
+ircd::m::app::service::service(const string_view &id,
+                               const json::object &config)
+:id
+{
+	id
+}
+,config
+{
+	config
+}
+,url
+{
+	json::string(config.get("url"))
+}
+,hs_token
+{
+	json::string(config.get("hs_token"))
+}
+,worker
+{
+	"m.app", 512_KiB, context::POST, [this]
+	{
+		main();
+	}
+}
+{
+}
+
+void
+ircd::m::app::service::push(std::string event)
+{
+	if(queue.size() >= size_t(queue_max))
+	{
+		queue.pop_front();
+		++dropped;
+	}
+
+	queue.emplace_back(std::move(event));
+	++queued;
+	dock.notify_one();
+}
+
+void
+ircd::m::app::service::main()
+try
+{
+	while(1)
+	{
+		dock.wait([this]
+		{
+			return !queue.empty() || !pending.empty();
+		});
+
+		// A failed transaction is retried as-is with the same txnId; new
+		// events wait in the queue until it is accepted.
+		if(pending.empty())
+		{
+			static uint64_t txn_ctr;
+			const size_t count
+			{
+				std::min(queue.size(), size_t(txn_events_max))
+			};
+
+			pending.reserve(count);
+			for(size_t i(0); i < count; ++i)
+			{
+				pending.emplace_back(std::move(queue.front()));
+				queue.pop_front();
+			}
+
+			txnid = fmt::snstringf
+			{
+				32, "%ld.%lu", ircd::time<milliseconds>(), ++txn_ctr
+			};
+		}
+
+		if(transmit())
+		{
+			sent += pending.size();
+			++txns;
+			attempt = 0;
+			pending.clear();
+			continue;
+		}
+
+		++failures;
+		ctx::sleep(backoff(attempt++));
+	}
+}
+catch(const std::exception &e)
+{
+	log::critical
+	{
+		log, "Appservice '%s' transaction worker :%s",
+		id,
+		e.what(),
+	};
+}
+
+bool
+ircd::m::app::service::transmit()
+try
+{
+	const rfc3986::uri uri
+	{
+		url
+	};
+
+	const auto port
+	{
+		rfc3986::port(uri.remote)
+	};
+
+	const net::hostport remote
+	{
+		rfc3986::host(uri.remote), port? port : uint16_t(443)
+	};
+
+	size_t content_max(64);
+	for(const auto &event : pending)
+		content_max += size(event) + 1;
+
+	const unique_buffer<mutable_buffer> buf
+	{
+		content_max + 16_KiB
+	};
+
+	json::stack out
+	{
+		mutable_buffer{data(buf), content_max}
+	};
+
+	{
+		json::stack::object top{out};
+		json::stack::array events{top, "events"};
+		for(const auto &event : pending)
+			events.append(json::object{event});
+	}
+
+	const string_view content
+	{
+		out.completed()
+	};
+
+	char txnid_buf[128], token_buf[512];
+	const fmt::bsprintf<1024> path
+	{
+		"%s/_matrix/app/v1/transactions/%s?access_token=%s",
+		rstrip(uri.path, '/'),
+		rfc3986::encode(txnid_buf, txnid),
+		rfc3986::encode(token_buf, hs_token),
+	};
+
+	const fmt::bsprintf<640> authorization
+	{
+		"Bearer %s", hs_token
+	};
+
+	window_buffer wb
+	{
+		mutable_buffer{data(buf) + content_max, 8_KiB}
+	};
+
+	http::request
+	{
+		wb, host(remote), "PUT", path, size(content), "application/json",
+		{
+			{ "Authorization",  authorization     },
+			{ "User-Agent",     info::user_agent  },
+		}
+	};
+
+	const mutable_buffer in_head
+	{
+		data(buf) + content_max + 8_KiB, 8_KiB
+	};
+
+	// Requests to the same remote share the peer's persistent links.
+	server::request::opts sopts;
+	sopts.http_exceptions = false;
+	server::request request
+	{
+		remote,
+		{ wb.completed(), content },
+		{ in_head, mutable_buffer{} },
+		&sopts
+	};
+
+	if(!request.wait(seconds(txn_timeout), std::nothrow))
+	{
+		log::derror
+		{
+			log, "Appservice '%s' txn %s of %zu events timed out",
+			id,
+			txnid,
+			pending.size(),
+		};
+
+		return false;
+	}
+
+	const auto code
+	{
+		request.get()
+	};
+
+	if(code >= 200 && code < 300)
+		return true;
+
+	log::derror
+	{
+		log, "Appservice '%s' txn %s of %zu events :%u %s",
+		id,
+		txnid,
+		pending.size(),
+		uint(code),
+		http::status(code),
+	};
+
+	return false;
+}
+catch(const ctx::interrupted &)
+{
+	throw;
+}
+catch(const std::exception &e)
+{
+	log::derror
+	{
+		log, "Appservice '%s' txn %s of %zu events :%s",
+		id,
+		txnid,
+		pending.size(),
+		e.what(),
+	};
+
+	return false;
+}
+
+ircd::milliseconds
+ircd::m::app::backoff(const size_t &attempt)
+{
+	const milliseconds min(backoff_min), max(backoff_max);
+	const auto shift
+	{
+		std::min(attempt, size_t(24))
+	};
+
+	return std::min(milliseconds(min.count() << shift), max);
+}
@@ -39,18 +39,6 @@ post__search(client &client,
 		request.get<ushort>("limit", 16)
 	};
 
-	// Search term in this endpoint comes in as-is from Riot. Our query
-	// is a lower_bound of a user_id, so we have to prefix the '@'.
-	char qbuf[256] {"@"};
-	const string_view &query
-	{
-		startswith(search_term, ':')?
-			string_view{search_term}:
-		!startswith(search_term, '@')?
-			string_view{ircd::strlcat{qbuf, search_term}}:
-			string_view{search_term}
-	};
-
 	const unique_buffer<mutable_buffer> buf
 	{
 		16_KiB
@@ -66,8 +54,7 @@ post__search(client &client,
 		top, "results"
 	};
 
-	const m::users::opts opts{query};
-	m::users::for_each(opts, [&results, &limit, &limited, &count]
+	const auto append{[&results, &limit, &limited, &count]
 	(const m::user::id &user_id)
 	{
 		json::stack::object result
@@ -106,7 +93,46 @@ post__search(client &client,
 
 		limited = ++count >= limit;
 		return !limited;
-	});
+	}};
+
+	// The directory matches display names as well as localparts; results
+	// are restricted to users sharing a room with the requester or in a
+	// public room. It has no words to seek for a hostpart alone, which is
+	// still listed from the senders of events.
+	if(m::users::directory::enable && !startswith(search_term, ':'))
+	{
+		const m::users::directory directory
+		{
+			request.user_id
+		};
+
+		directory.for_each(search_term, [&append]
+		(const m::user::id &user_id, const m::event::idx &event_idx)
+		{
+			return append(user_id);
+		});
+	}
+	else
+	{
+		// Search term in this endpoint comes in as-is from Riot. Our query
+		// is a lower_bound of a user_id, so we have to prefix the '@'.
+		char qbuf[256] {"@"};
+		const string_view &query
+		{
+			startswith(search_term, ':')?
+				string_view{search_term}:
+			!startswith(search_term, '@')?
+				string_view{ircd::strlcat{qbuf, search_term}}:
+				string_view{search_term}
+		};
+
+		const m::users::opts opts{query};
+		m::users::for_each(opts, [&append]
+		(const m::user::id &user_id)
+		{
+			return append(user_id);
+		});
+	}
 
 	results.~array();
 	json::stack::member
@@ -22,6 +22,27 @@ namespace
 static host_users_map
 parse_user_request(const json::object &device_keys);
 
+static bool
+device_wanted(const json::array &device_ids,
+              const string_view &device_id);
+
+static void
+handle_cached(const m::user::id &,
+              const json::array &device_ids,
+              json::stack::object &);
+
+static host_users_map
+split_cached(const host_users_map &,
+             std::vector<m::user::id> &cached,
+             std::vector<m::user::id> &waiting,
+             std::vector<std::string> &fetching);
+
+static void
+recv_waiting(const std::vector<m::user::id> &,
+             const host_users_map &,
+             json::stack::object &,
+             const milliseconds &);
+
 static bool
 send_request(const string_view &,
              const user_devices_map &,
@@ -37,11 +58,13 @@ send_requests(const host_users_map &,
 static void
 recv_response(const string_view &,
               m::v1::user::keys::query &,
+              const user_devices_map &,
               failure_map &,
               json::stack::object &);
 
 static void
 recv_responses(query_map &,
+               const host_users_map &,
                failure_map &,
                json::stack::object &,
                const milliseconds &);
@@ -117,6 +140,15 @@ query_timeout_max
 	{ "default",  20000L                               },
 };
 
+/// Remote users with a keys query in flight by some request; concurrent
+/// requests for them wait for that result in the device_list cache rather
+/// than querying the remote again.
+std::set<std::string, std::less<>>
+fetching;
+
+ctx::dock
+fetching_dock;
+
 resource::response
 post__keys_query(client &client,
                  const resource::request &request)
@@ -145,11 +177,29 @@ post__keys_query(client &client,
 		parse_user_request(request_keys)
 	};
 
+	// Users answered from the cache, users whose query is in flight by
+	// another request, and the users this request is now querying.
+	std::vector<m::user::id> cached, waiting;
+	std::vector<std::string> fetched;
+	const unwind fetched_done{[&fetched]
+	{
+		for(const auto &user_id : fetched)
+			fetching.erase(user_id);
+
+		if(!fetched.empty())
+			fetching_dock.notify_all();
+	}};
+
+	const host_users_map fetch
+	{
+		split_cached(map, cached, waiting, fetched)
+	};
+
 	buffer_list buffers;
 	failure_map failures;
 	query_map queries
 	{
-		send_requests(map, buffers, failures)
+		send_requests(fetch, buffers, failures)
 	};
 
 	resource::response::chunked response
@@ -167,11 +217,67 @@ post__keys_query(client &client,
 		out
 	};
 
-	recv_responses(queries, failures, top, timeout);
+	{
+		json::stack::object response_keys
+		{
+			top, "device_keys"
+		};
+
+		for(const auto &user_id : cached)
+			handle_cached(user_id, map.at(user_id.host()).at(user_id), response_keys);
+
+		recv_responses(queries, map, failures, response_keys, timeout);
+		recv_waiting(waiting, map, response_keys, timeout);
+	}
+
 	handle_failures(failures, top);
 	return {};
 }
 
+/// Divide the request between the cache and the remotes. The returned map
+/// holds the queries to be sent; remote users in it are queried for all of
+/// their devices so the result can be cached as a snapshot.
+host_users_map
+split_cached(const host_users_map &map,
+             std::vector<m::user::id> &cached,
+             std::vector<m::user::id> &waiting,
+             std::vector<std::string> &fetched)
+{
+	if(!m::device_list::enable)
+		return map;
+
+	host_users_map ret;
+	for(const auto &[host, users] : map)
+	{
+		if(my_host(host))
+		{
+			ret.emplace(host, users);
+			continue;
+		}
+
+		for(const auto &[user_id, device_ids] : users)
+		{
+			if(m::device_list::fresh(user_id))
+			{
+				cached.emplace_back(user_id);
+				continue;
+			}
+
+			if(fetching.count(user_id))
+			{
+				waiting.emplace_back(user_id);
+				continue;
+			}
+
+			fetching.emplace(user_id);
+			fetched.emplace_back(user_id);
+			ret[host].emplace(user_id, json::array{});
+		}
+	}
+
+	return ret;
+}
+
 void
 handle_failures(const failure_map &failures,
                 json::stack::object &out)
@@ -192,10 +298,73 @@ handle_failures(const failure_map &failures,
 	}
 }
 
+/// Users whose query was in flight by another request are answered from
+/// the cache once it completes; they're omitted if it failed.
+void
+recv_waiting(const std::vector<m::user::id> &waiting,
+             const host_users_map &map,
+             json::stack::object &out,
+             const milliseconds &timeout)
+{
+	const system_point timedout
+	{
+		ircd::now<system_point>() + timeout
+	};
+
+	for(const auto &user_id : waiting)
+	{
+		fetching_dock.wait_until(timedout, [&user_id]
+		{
+			return !fetching.count(user_id);
+		});
+
+		handle_cached(user_id, map.at(user_id.host()).at(user_id), out);
+	}
+}
+
+void
+handle_cached(const m::user::id &user_id,
+              const json::array &device_ids,
+              json::stack::object &out)
+{
+	if(!m::device_list::fresh(user_id))
+		return;
+
+	json::stack::object user_object
+	{
+		out, user_id
+	};
+
+	m::device_list::get(user_id, [&device_ids, &user_object]
+	(const string_view &device_id, const json::object &keys)
+	{
+		if(device_wanted(device_ids, device_id))
+			json::stack::member
+			{
+				user_object, device_id, keys
+			};
+	});
+}
+
+bool
+device_wanted(const json::array &device_ids,
+              const string_view &device_id)
+{
+	if(empty(device_ids))
+		return true;
+
+	for(const json::string &wanted : device_ids)
+		if(wanted == device_id)
+			return true;
+
+	return false;
+}
+
 void
 recv_responses(query_map &queries,
+               const host_users_map &map,
                failure_map &failures,
-               json::stack::object &out,
+               json::stack::object &response_keys,
                const milliseconds &timeout)
 try
 {
@@ -204,11 +373,6 @@ try
 		ircd::now<system_point>() + timeout
 	};
 
-	json::stack::object response_keys
-	{
-		out, "device_keys"
-	};
-
 	while(!queries.empty())
 	{
 		static const auto dereferencer{[]
@@ -236,7 +400,7 @@ try
 		if(failures.count(remote))
 			continue;
 
-		recv_response(remote, request, failures, response_keys);
+		recv_response(remote, request, map.at(remote), failures, response_keys);
 	}
 }
 catch(const std::exception &)
@@ -248,6 +412,7 @@ catch(const std::exception &)
 void
 recv_response(const string_view &remote,
               m::v1::user::keys::query &request,
+              const user_devices_map &users,
               failure_map &failures,
               json::stack::object &object)
 try
@@ -274,16 +439,30 @@ try
 			_user_id
 		};
 
+		// The remote may answer for users we didn't ask about; those are
+		// neither cached nor passed on.
+		const auto it
+		{
+			users.find(user_id)
+		};
+
+		if(it == end(users) || user_id.host() != remote)
+			continue;
+
+		if(!my_host(remote))
+			m::device_list::set(user_id, device_keys);
+
 		json::stack::object user_object
 		{
 			object, user_id
 		};
 
 		for(const auto &[device_id, keys] : json::object(device_keys))
-			json::stack::member
-			{
-				user_object, device_id, keys
-			};
+			if(device_wanted(it->second, device_id))
+				json::stack::member
+				{
+					user_object, device_id, keys
+				};
 	}
 }
 catch(const std::exception &e)
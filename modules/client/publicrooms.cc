@@ -32,6 +32,12 @@ flush_hiwat
 	{ "default",  16384L                                },
 };
 
+static void
+get__publicrooms_directory(json::stack &,
+                           const string_view &server,
+                           const string_view &since,
+                           const size_t &limit);
+
 static resource::response
 get__publicrooms(client &,
                  const resource::request &);
@@ -52,15 +58,20 @@ resource::response
 get__publicrooms(client &client,
                  const resource::request &request)
 {
-	char since_buf[m::room::id::buf::SIZE];
+	const json::object::index content
+	{
+		request
+	};
+
+	char since_buf[m::room::id::buf::SIZE + 24];
 	const string_view &since
 	{
-		request.has("since")?
-			unquote(request["since"]):
+		content.has("since")?
+			unquote(content["since"]):
 			url::decode(since_buf, request.query["since"])
 	};
 
-	if(since && !valid(m::id::ROOM, since))
+	if(since && !valid(m::id::ROOM, since) && !m::rooms::summary::directory::valid(since))
 		throw m::BAD_REQUEST
 		{
 			"Invalid since token for this server."
@@ -74,19 +85,19 @@ get__publicrooms(client &client,
 
 	const uint8_t limit
 	{
-		request.has("limit")?
-			uint8_t(request.at<ushort>("limit")):
+		content.has("limit")?
+			uint8_t(content.at<ushort>("limit")):
 			uint8_t(request.query.get<ushort>("limit", 16U))
 	};
 
 	const bool include_all_networks
 	{
-		request.get<bool>("include_all_networks", false)
+		content.get<bool>("include_all_networks", false)
 	};
 
 	const json::object &filter
 	{
-		request["filter"]
+		content["filter"]
 	};
 
 	const json::string &search_term
@@ -129,7 +140,6 @@ get__publicrooms(client &client,
 	opts.summary = true;
 	opts.search_term = search_term;
 	opts.lower_bound = true;
-	opts.room_id = since;
 
 	if(m::valid(m::id::USER, search_term))
 		opts.user_id = search_term;
@@ -159,6 +169,21 @@ get__publicrooms(client &client,
 		since,
 	};
 
+	// Unfiltered listings are served in order of joined members from the
+	// materialized directory, where the since token is a position.
+	const bool use_directory
+	{
+		m::rooms::summary::directory::enable &&
+		!opts.search_term && !opts.room_alias && !opts.user_id && opts.server
+	};
+
+	if(use_directory)
+	{
+		get__publicrooms_directory(out, opts.server, since, limit);
+		return std::move(response);
+	}
+
+	opts.room_id = valid(m::id::ROOM, since)? since : string_view{};
 	size_t count{0};
 	m::room::id::buf prev_batch_buf;
 	m::room::id::buf next_batch_buf;
@@ -203,3 +228,49 @@ get__publicrooms(client &client,
 
 	return std::move(response);
 }
+
+void
+get__publicrooms_directory(json::stack &out,
+                           const string_view &server,
+                           const string_view &since,
+                           const size_t &limit)
+{
+	const m::rooms::summary::directory directory
+	{
+		server
+	};
+
+	size_t count{0}, last_joined{0};
+	m::room::id::buf last_room_id;
+	json::stack::object top{out};
+	{
+		json::stack::array chunk
+		{
+			top, "chunk"
+		};
+
+		directory.for_each(since, [&](const m::room::id &room_id, const size_t &joined)
+		{
+			json::stack::object obj{chunk};
+			m::rooms::summary::get(obj, room_id);
+			last_joined = joined;
+			last_room_id = room_id;
+			return ++count < limit;
+		});
+	}
+
+	json::stack::member
+	{
+		top, "total_room_count_estimate", json::value
+		{
+			ssize_t(directory.count())
+		}
+	};
+
+	char next_batch_buf[m::room::id::buf::SIZE + 24];
+	if(count >= limit)
+		json::stack::member
+		{
+			top, "next_batch", directory.since(next_batch_buf, {last_joined, last_room_id})
+		};
+}
@@ -80,6 +80,12 @@ get__context(client &client,
 			"You are not permitted to view the room at this event"
 		};
 
+	// Shared by the events before, after and the state below.
+	m::visibility visible
+	{
+		room_id, request.user_id
+	};
+
 	// Non-spec param to allow preventing any state from being returned.
 	const bool include_state
 	{
@@ -173,7 +179,7 @@ get__context(client &client,
 		{
 			const m::event &event{*before};
 			start = event.event_id;
-			if(!visible(event, request.user_id))
+			if(!visible(event))
 				continue;
 
 			counts.before += _append(array, event, before.event_idx(), user_room, room_depth);
@@ -213,7 +219,7 @@ get__context(client &client,
 		{
 			const m::event &event{*after};
 			end = event.event_id;
-			if(!visible(event, request.user_id))
+			if(!visible(event))
 				continue;
 
 			counts.after += _append(array, event, after.event_idx(), user_room, room_depth);
@@ -271,7 +277,7 @@ get__context(client &client,
 			if(!seek(event, event_idx, std::nothrow))
 				return true;
 
-			if(!visible(event, request.user_id))
+			if(!visible(event))
 				return true;
 
 			counts.state += _append(array, event, event_idx, user_room, room_depth, false);
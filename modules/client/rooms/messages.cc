@@ -29,6 +29,24 @@ _append(json::stack::array &chunk,
         const m::user::room &user_room,
         const int64_t &room_depth);
 
+static bool
+_type_match(const m::room_event_filter &,
+            const m::event::idx &);
+
+static bool
+_type_indexed(const m::room_event_filter &);
+
+static bool
+_for_each_type(const m::room &,
+               const pagination_tokens &,
+               const m::room_event_filter &,
+               const m::event::closure_idx_bool &);
+
+static bool
+_for_each(const m::room &,
+          const pagination_tokens &,
+          const m::event::closure_idx_bool &);
+
 conf::item<size_t>
 max_filter_miss
 {
@@ -125,44 +143,57 @@ get__messages(client &client,
 		top, "chunk"
 	};
 
-	size_t hit{0}, miss{0};
-	m::room::events it
+	m::visibility visible
 	{
-		room
+		room_id, request.user_id
 	};
 
-	for(; it; page.dir == 'b'? --it : ++it)
+	size_t hit{0}, miss{0};
+	m::event::idx end_idx{0};
+	m::event::fetch event;
+	const auto append{[&]
+	(const m::event::idx &event_idx)
 	{
-		const m::event &event
-		{
-			*it
-		};
-
-		end = event.event_id;
+		end_idx = event_idx;
 		if(hit > page.limit || miss >= size_t(max_filter_miss))
-			break;
+			return false;
 
 		const bool ok
 		{
-			(empty(filter_json) || match(filter, event))
+			_type_match(filter, event_idx)
+
+			&& seek(event, event_idx, std::nothrow)
+
+			&& (empty(filter_json) || match(filter, event))
 
-			&& visible(event, request.user_id)
+			&& visible(event)
 
-			&& _append(chunk, event, it.event_idx(), user_room, room_depth)
+			&& _append(chunk, event, event_idx, user_room, room_depth)
 		};
 
 		hit += ok;
 		miss += !ok;
-	}
+		return true;
+	}};
+
+	const bool more
+	{
+		_type_indexed(filter)?
+			!_for_each_type(room, page, filter, append):
+			!_for_each(room, page, append)
+	};
+
 	chunk.~array();
+	if(end_idx)
+		m::event_id(end_idx, end, std::nothrow);
 
-	if(it || page.dir == 'b')
+	if(more || page.dir == 'b')
 		json::stack::member
 		{
 			top, "start", json::value{start}
 		};
 
-	if(it || page.dir != 'b')
+	if(more || page.dir != 'b')
 		json::stack::member
 		{
 			top, "end", json::value{end}
@@ -186,6 +217,213 @@ get__messages(client &client,
 	return {};
 }
 
+bool
+_for_each(const m::room &room,
+          const pagination_tokens &page,
+          const m::event::closure_idx_bool &closure)
+{
+	m::room::events it
+	{
+		room
+	};
+
+	for(; it; page.dir == 'b'? --it : ++it)
+		if(!closure(it.event_idx()))
+			return false;
+
+	return true;
+}
+
+namespace
+{
+	/// Position of one of the filter's types in the room_type index with a
+	/// queue of the next entries read from it in the direction of the page.
+	struct type_cursor
+	{
+		string_view type;
+		uint64_t depth;
+		m::event::idx event_idx;
+		std::deque<std::pair<uint64_t, m::event::idx>> queue;
+		bool started {false};
+		bool done {false};
+	};
+}
+
+static void
+_refill(type_cursor &c,
+        const m::room &room,
+        const char &dir,
+        const size_t &batch)
+{
+	const m::room::type events
+	{
+		room, c.type, c.depth, c.event_idx
+	};
+
+	size_t i(0);
+	const auto closure{[&c, &i, &batch]
+	(const auto &type, const auto &depth, const auto &event_idx)
+	{
+		// The position itself was already queued by the last refill.
+		if(c.started && depth == c.depth && event_idx == c.event_idx)
+			return true;
+
+		c.queue.emplace_back(depth, event_idx);
+		c.depth = depth;
+		c.event_idx = event_idx;
+		return ++i < batch;
+	}};
+
+	c.done = dir == 'b'?
+		events.for_each(closure):
+		events.rfor_each(closure);
+
+	c.started = true;
+}
+
+/// Iterates only the events of the filter's types by merging the partitions
+/// of the room_type index in timeline order. Each partition is read in small
+/// batches so a sparse type does not cause a scan of the whole timeline.
+bool
+_for_each_type(const m::room &room,
+               const pagination_tokens &page,
+               const m::room_event_filter &filter,
+               const m::event::closure_idx_bool &closure)
+{
+	uint64_t depth(-1);
+	m::event::idx event_idx(-1);
+	if(room.event_id)
+	{
+		event_idx = m::index(room.event_id, std::nothrow);
+		if(!event_idx || !m::get(event_idx, "depth", depth))
+			return true;
+	}
+
+	std::vector<type_cursor> cursor;
+	for(const json::string type : json::get<"types"_>(filter))
+		if(!std::any_of(begin(cursor), end(cursor), [&type]
+		(const auto &c)
+		{
+			return c.type == type;
+		}))
+			cursor.emplace_back(type_cursor{type, depth, event_idx});
+
+	const size_t batch
+	{
+		page.limit + 2UL
+	};
+
+	const auto ahead{[&page]
+	(const type_cursor &a, const type_cursor &b)
+	{
+		return page.dir == 'b'?
+			a.queue.front() > b.queue.front():
+			a.queue.front() < b.queue.front();
+	}};
+
+	while(1)
+	{
+		type_cursor *next(nullptr);
+		for(auto &c : cursor)
+		{
+			if(c.queue.empty() && !c.done)
+				_refill(c, room, page.dir, batch);
+
+			if(c.queue.empty())
+				continue;
+
+			if(!next || ahead(c, *next))
+				next = &c;
+		}
+
+		if(!next)
+			return true;
+
+		const m::event::idx event_idx
+		{
+			next->queue.front().second
+		};
+
+		next->queue.pop_front();
+		if(!closure(event_idx))
+			return false;
+	}
+}
+
+/// The index can answer for the filter only when its result would be the
+/// same as testing the type of every event in the timeline: the index must
+/// be complete and match() must consider the types (it does not when there
+/// are also senders).
+bool
+_type_indexed(const m::room_event_filter &filter)
+{
+	if(!bool(m::room::type::enable))
+		return false;
+
+	if(empty(json::get<"types"_>(filter)))
+		return false;
+
+	if(!empty(json::get<"senders"_>(filter)))
+		return false;
+
+	for(const json::string type : json::get<"types"_>(filter))
+		if(empty(type) || has(type, '*'))
+			return false;
+
+	return true;
+}
+
+/// Tests the type of an event against the filter reading only the type
+/// property, so events of excluded types are never fetched. This only
+/// rejects events which match() would also reject.
+bool
+_type_match(const m::room_event_filter &filter,
+            const m::event::idx &event_idx)
+{
+	const json::array &types
+	{
+		json::get<"types"_>(filter)
+	};
+
+	const json::array &not_types
+	{
+		json::get<"not_types"_>(filter)
+	};
+
+	const bool check_types
+	{
+		!empty(types) && empty(json::get<"senders"_>(filter))
+	};
+
+	if(!check_types && empty(not_types))
+		return true;
+
+	bool ret{true};
+	m::get(std::nothrow, event_idx, "type", [&]
+	(const string_view &type)
+	{
+		for(const json::string not_type : not_types)
+			if(type == not_type)
+			{
+				ret = false;
+				return;
+			}
+
+		if(!check_types)
+			return;
+
+		ret = false;
+		for(const json::string _type : types)
+			if(type == _type)
+			{
+				ret = true;
+				return;
+			}
+	});
+
+	return ret;
+}
+
 bool
 _append(json::stack::array &chunk,
         const m::event &event,
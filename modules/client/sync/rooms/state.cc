@@ -347,7 +347,7 @@ ircd::m::sync::room_state_phased_events(data &data)
 
 	const room::state state
 	{
-		*data.room
+		*data.room, &prefetch_opts
 	};
 
 	// Prefetch the state cells
@@ -371,7 +371,7 @@ ircd::m::sync::room_state_phased_events(data &data)
 				room::state::prev(idx)
 			};
 
-			prev_content_prefetched += m::prefetch(prev_idx, "content");
+			prev_content_prefetched += m::prefetch(prev_idx, "content", prefetch_opts.gopts);
 		}
 	}
 
@@ -435,7 +435,7 @@ ircd::m::sync::room_state_phased_member_events(data &data,
 	for(; it && i < count; --it, ++i)
 	{
 		event_idx[i] = it.event_idx();
-		prefetched += m::prefetch(event_idx[i], "sender");
+		prefetched += m::prefetch(event_idx[i], "sender", prefetch_opts.gopts);
 	}
 
 	// Transform the senders into member event::idx's and prefetch events
@@ -451,7 +451,7 @@ ircd::m::sync::room_state_phased_member_events(data &data,
 			})
 		};
 
-		m::prefetch(member_idx);
+		m::prefetch(member_idx, prefetch_opts);
 		return member_idx;
 	});
 
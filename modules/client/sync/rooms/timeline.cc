@@ -267,7 +267,7 @@ ircd::m::sync::_room_timeline_polylog_events(data &data,
 			break;
 
 		if(limit > 1)
-			prefetched += m::prefetch(event_idx);
+			prefetched += m::prefetch(event_idx, prefetch_opts);
 
 		++i;
 	}
@@ -453,6 +453,189 @@ console_cmd__stringify(opt &out, const string_view &line)
 	return true;
 }
 
+//
+// json
+//
+
+/// Compares the perfect hash translating a property name to its index in a
+/// json::tuple against the reference linear scan, over all m::event keys and
+/// a non-member key. Results in cycles per lookup.
+bool
+console_cmd__json__tuple__indexof(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"iterations"
+	}};
+
+	const size_t iterations
+	{
+		param.at<size_t>("iterations", 100000UL)
+	};
+
+	std::array<string_view, json::size<m::event>() + 1> keys;
+	for(size_t i(0); i < json::size<m::event>(); ++i)
+		keys[i] = json::key<m::event>(i);
+
+	keys.back() = "not_a_property";
+
+	size_t sum[2] {0};
+	uint64_t cycles[2] {0};
+	for(size_t i(0); i < iterations; ++i)
+		for(const auto &key : keys)
+		{
+			const auto started(prof::cycles());
+			sum[0] += json::indexof<m::event>(key);
+			cycles[0] += prof::cycles() - started;
+		}
+
+	for(size_t i(0); i < iterations; ++i)
+		for(const auto &key : keys)
+		{
+			const auto started(prof::cycles());
+			sum[1] += json::indexof_scan<m::event>(key);
+			cycles[1] += prof::cycles() - started;
+		}
+
+	assert(sum[0] == sum[1]);
+	const auto lookups
+	{
+		double(iterations * keys.size())
+	};
+
+	out
+	<< "keys:         " << keys.size() << std::endl
+	<< "lookups:      " << size_t(lookups) << std::endl
+	<< "hash cyc:     " << (cycles[0] / lookups) << std::endl
+	<< "scan cyc:     " << (cycles[1] / lookups) << std::endl
+	<< "agreement:    " << (sum[0] == sum[1]) << std::endl
+	;
+
+	return true;
+}
+
+/// Compares the bulk string scanner against a per-character scan over a
+/// synthetic string body, then reports the throughput of validating and
+/// escaping the same content. Results in cycles per byte.
+bool
+console_cmd__json__string__scan(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"size", "iterations", "escapes"
+	}};
+
+	const size_t len
+	{
+		std::max(param.at<size_t>("size", 60_KiB), 1UL)
+	};
+
+	const size_t iterations
+	{
+		std::max(param.at<size_t>("iterations", 64UL), 1UL)
+	};
+
+	// One escaped character per this many bytes; zero for none.
+	const size_t escapes
+	{
+		param.at<size_t>("escapes", 512UL)
+	};
+
+	const unique_buffer<mutable_buffer> body
+	{
+		len
+	};
+
+	for(size_t i(0); i < len; ++i)
+		data(body)[i] = escapes && i % escapes == escapes - 1?
+			'\n':
+			'a' + (i % 26);
+
+	const unique_buffer<mutable_buffer> escaped_buf
+	{
+		2 + len * 2
+	};
+
+	const unique_buffer<mutable_buffer> quoted_buf
+	{
+		2 + len * 2
+	};
+
+	const auto per_char{[]
+	(const char *it, const char *const stop)
+	{
+		return std::find_if(it, stop, [](const char &c)
+		{
+			return c == '"' || c == '\\' || uint8_t(c) < 0x20;
+		});
+	}};
+
+	size_t stops[2] {0};
+	uint64_t cycles[4] {0};
+	const char *const start(data(body)), *const stop(start + len);
+	for(size_t i(0); i < iterations; ++i)
+	{
+		const auto started(prof::cycles());
+		for(auto it(json::string_scan(start, stop)); it != stop; it = json::string_scan(it + 1, stop))
+			++stops[0];
+
+		cycles[0] += prof::cycles() - started;
+	}
+
+	for(size_t i(0); i < iterations; ++i)
+	{
+		const auto started(prof::cycles());
+		for(auto it(per_char(start, stop)); it != stop; it = per_char(it + 1, stop))
+			++stops[1];
+
+		cycles[1] += prof::cycles() - started;
+	}
+
+	json::string escaped;
+	for(size_t i(0); i < iterations; ++i)
+	{
+		const auto started(prof::cycles());
+		escaped = json::escape(escaped_buf, string_view{start, stop});
+		cycles[2] += prof::cycles() - started;
+	}
+
+	mutable_buffer quoted{quoted_buf};
+	consume(quoted, copy(quoted, "\""_sv));
+	consume(quoted, copy(quoted, escaped));
+	consume(quoted, copy(quoted, "\""_sv));
+	const string_view input
+	{
+		data(quoted_buf), data(quoted)
+	};
+
+	bool valid(true);
+	for(size_t i(0); i < iterations; ++i)
+	{
+		const auto started(prof::cycles());
+		valid &= json::valid(input, std::nothrow);
+		cycles[3] += prof::cycles() - started;
+	}
+
+	const double bytes
+	{
+		double(iterations * len)
+	};
+
+	out
+	<< "bytes:        " << len << std::endl
+	<< "escapes:      " << (stops[0] / iterations) << std::endl
+	<< "bulk cyc/B:   " << (cycles[0] / bytes) << std::endl
+	<< "char cyc/B:   " << (cycles[1] / bytes) << std::endl
+	<< "escape cyc/B: " << (cycles[2] / bytes) << std::endl
+	<< "valid cyc/B:  " << (cycles[3] / bytes) << std::endl
+	<< "agreement:    " << (stops[0] == stops[1]) << std::endl
+	<< "sized:        " << (json::escaped_size(string_view{start, stop}) == size(escaped)) << std::endl
+	<< "valid:        " << valid << std::endl
+	;
+
+	return true;
+}
+
 bool
 console_cmd__credits(opt &out, const string_view &line)
 {
@@ -526,6 +709,138 @@ console_cmd__bt(opt &out, const string_view &line)
 	return true;
 }
 
+//
+// fmt
+//
+
+/// Compares formatting with the parsed format program cache against the
+/// parser for each specifier, over patterns common to log lines, keys and
+/// URLs. Results in cycles per format.
+bool
+console_cmd__fmt__bench(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"iterations"
+	}};
+
+	const size_t iterations
+	{
+		std::max(param.at<size_t>("iterations", 100000UL), 1UL)
+	};
+
+	const string_view event_id
+	{
+		"$Qh5q8pYCP3Ozjrc9Bsbmxt7FOw2BCZCKrtLjIcP8sZc"
+	};
+
+	const string_view room_id
+	{
+		"!room:example.org"
+	};
+
+	const std::function<string_view (const mutable_buffer &)> patterns[]
+	{
+		[&event_id, &room_id](const mutable_buffer &buf)
+		{
+			return fmt::sprintf
+			{
+				buf, "%s %s %zu:%lu %s",
+				"vm",
+				room_id,
+				1024UL,
+				4096UL,
+				event_id,
+			};
+		},
+		[&event_id](const mutable_buffer &buf)
+		{
+			return fmt::sprintf
+			{
+				buf, "'%s' %lu '%s' %s %s",
+				"events",
+				123456789UL,
+				"_event_idx",
+				"SET",
+				event_id,
+			};
+		},
+		[&room_id](const mutable_buffer &buf)
+		{
+			return fmt::sprintf
+			{
+				buf, "/_matrix/client/r0/rooms/%s/messages?from=%s&limit=%u",
+				room_id,
+				"s123_456",
+				32U,
+			};
+		},
+		[](const mutable_buffer &buf)
+		{
+			return fmt::sprintf
+			{
+				buf, "%08lx %5.2lf%% %-16s %c",
+				0xdeadbeefUL,
+				99.5,
+				"padded",
+				'x',
+			};
+		},
+	};
+
+	const bool enable
+	{
+		fmt::cache::enable
+	};
+
+	const unwind restore{[&enable]
+	{
+		fmt::cache::enable.set(enable? "true" : "false");
+	}};
+
+	char buf[2][512];
+	uint64_t cycles[2] {0};
+	for(const bool cached : {false, true})
+	{
+		fmt::cache::enable.set(cached? "true" : "false");
+		for(size_t i(0); i < iterations; ++i)
+			for(const auto &pattern : patterns)
+			{
+				const auto started(prof::cycles());
+				pattern(buf[cached]);
+				cycles[cached] += prof::cycles() - started;
+			}
+	}
+
+	size_t mismatch(0);
+	for(const auto &pattern : patterns)
+	{
+		fmt::cache::enable.set("false");
+		const string_view a(pattern(buf[0]));
+
+		fmt::cache::enable.set("true");
+		const string_view b(pattern(buf[1]));
+
+		mismatch += a != b;
+	}
+
+	const auto formats
+	{
+		double(iterations * std::size(patterns))
+	};
+
+	out
+	<< "patterns:     " << std::size(patterns) << std::endl
+	<< "formats:      " << size_t(formats) << std::endl
+	<< "parse cyc:    " << (cycles[0] / formats) << std::endl
+	<< "cached cyc:   " << (cycles[1] / formats) << std::endl
+	<< "programs:     " << fmt::cache::count() << std::endl
+	<< "mismatches:   " << mismatch << std::endl
+	;
+
+	return true;
+}
+
 //
 // main
 //
@@ -1625,6 +1940,220 @@ console_cmd__aio(opt &out, const string_view &line)
 	return true;
 }
 
+//
+// iou
+//
+
+bool
+console_cmd__iou(opt &out, const string_view &line)
+{
+	if(!fs::iou::system)
+		throw error
+		{
+			"io_uring is not available."
+		};
+
+	const auto &s
+	{
+		fs::iou::stats
+	};
+
+	out << std::setw(18) << std::left << "requests"
+	    << std::setw(9) << std::right << s.requests
+	    << "   " << pretty(iec(s.bytes_requests))
+	    << std::endl;
+
+	out << std::setw(18) << std::left << "requests que"
+	    << std::setw(9) << std::right << s.cur_queued
+	    << std::endl;
+
+	out << std::setw(18) << std::left << "requests out"
+	    << std::setw(9) << std::right << s.cur_submits
+	    << std::endl;
+
+	out << std::setw(18) << std::left << "requests out max"
+	    << std::setw(9) << std::right << s.max_submits
+	    << std::endl;
+
+	out << std::setw(18) << std::left << "reads"
+	    << std::setw(9) << std::right << s.reads
+	    << "   " << pretty(iec(s.bytes_read))
+	    << std::endl;
+
+	out << std::setw(18) << std::left << "reads fixed"
+	    << std::setw(9) << std::right << s.fixed_reads
+	    << std::endl;
+
+	out << std::setw(18) << std::left << "reads fixed miss"
+	    << std::setw(9) << std::right << s.fixed_misses
+	    << std::endl;
+
+	out << std::setw(18) << std::left << "writes"
+	    << std::setw(9) << std::right << s.writes
+	    << "   " << pretty(iec(s.bytes_write))
+	    << std::endl;
+
+	out << std::setw(18) << std::left << "files fixed"
+	    << std::setw(9) << std::right << s.fixed_files
+	    << std::endl;
+
+	out << std::setw(18) << std::left << "files registered"
+	    << std::setw(9) << std::right << (s.file_registers - s.file_unregisters)
+	    << std::endl;
+
+	out << std::setw(18) << std::left << "submits"
+	    << std::setw(9) << std::right << s.submits
+	    << std::endl;
+
+	out << std::setw(18) << std::left << "chases"
+	    << std::setw(9) << std::right << s.chases
+	    << std::endl;
+
+	out << std::setw(18) << std::left << "enters"
+	    << std::setw(9) << std::right << s.enters
+	    << std::endl;
+
+	out << std::setw(18) << std::left << "wakeups"
+	    << std::setw(9) << std::right << s.wakeups
+	    << std::endl;
+
+	out << std::setw(18) << std::left << "handles"
+	    << std::setw(9) << std::right << s.handles
+	    << std::endl;
+
+	out << std::setw(18) << std::left << "events"
+	    << std::setw(9) << std::right << s.events
+	    << std::endl;
+
+	out << std::setw(18) << std::left << "errors"
+	    << std::setw(9) << std::right << s.errors
+	    << "   " << pretty(iec(s.bytes_errors))
+	    << std::endl;
+
+	out << std::setw(18) << std::left << "cancel"
+	    << std::setw(9) << std::right << s.cancel
+	    << "   " << pretty(iec(s.bytes_cancel))
+	    << std::endl;
+
+	return true;
+}
+
+bool
+console_cmd__iou__bench(opt &out, const string_view &line)
+{
+	if(!fs::iou::system)
+		throw error
+		{
+			"io_uring is not available."
+		};
+
+	const params param{line, " ",
+	{
+		"path", "size", "count", "parallel"
+	}};
+
+	const auto path
+	{
+		param.at("path")
+	};
+
+	const size_t bufsz
+	{
+		param.at<size_t>("size", 4_KiB)
+	};
+
+	const size_t count
+	{
+		param.at<size_t>("count", 4096UL)
+	};
+
+	const size_t parallel
+	{
+		std::max(param.at<size_t>("parallel", 16UL), 1UL)
+	};
+
+	const fs::fd fd
+	{
+		path, std::ios::in
+	};
+
+	const size_t blocks
+	{
+		fs::size(fd) / bufsz
+	};
+
+	if(!blocks)
+		throw error
+		{
+			"File is smaller than the read size."
+		};
+
+	const bool buffers_enable(fs::iou::buffers_enable);
+	const bool files_enable(fs::iou::files_enable);
+	const unwind restore{[&buffers_enable, &files_enable]
+	{
+		fs::iou::buffers_enable.set(lex_cast(buffers_enable));
+		fs::iou::files_enable.set(lex_cast(files_enable));
+	}};
+
+	// Each pass issues the same number of random block-aligned reads from
+	// `parallel` contexts so the rings see a realistic queue depth.
+	const auto pass{[&](const bool &buffers, const bool &files)
+	{
+		fs::iou::buffers_enable.set(lex_cast(buffers));
+		fs::iou::files_enable.set(lex_cast(files));
+
+		const auto stats_before(fs::iou::stats);
+		size_t remain(count), bytes(0);
+		std::vector<context> workers(parallel);
+		const ircd::timer timer;
+		for(auto &worker : workers)
+			worker = context
+			{
+				"iou.bench", 256_KiB, [&]
+				{
+					const unique_buffer<mutable_buffer> buf
+					{
+						bufsz, info::page_size
+					};
+
+					fs::read_opts opts;
+					while(remain && remain--)
+					{
+						opts.offset = rand::integer(0, blocks - 1) * bufsz;
+						bytes += size(fs::read(fd, buf, opts));
+					}
+				}
+			};
+
+		for(auto &worker : workers)
+			worker.join();
+
+		const auto elapsed
+		{
+			timer.at<microseconds>().count()
+		};
+
+		const auto &s(fs::iou::stats);
+		out << "buffers:" << std::setw(5) << std::left << (buffers? "on" : "off")
+		    << " files:" << std::setw(5) << std::left << (files? "on" : "off")
+		    << " " << std::setw(8) << std::right << count << " reads"
+		    << " " << std::setw(10) << std::right << size_t(count * 1000000.0 / std::max(elapsed, 1L)) << " ops/s"
+		    << " " << std::setw(8) << std::right << (elapsed / std::max(count, 1UL)) * parallel << " us/op"
+		    << " " << std::setw(10) << std::right << pretty(iec(bytes))
+		    << " enters:" << (s.enters - stats_before.enters)
+		    << " submits:" << (s.submits - stats_before.submits)
+		    << " fixed:" << (s.fixed_reads - stats_before.fixed_reads)
+		    << std::endl;
+	}};
+
+	pass(false, false);
+	pass(true, false);
+	pass(false, true);
+	pass(true, true);
+	return true;
+}
+
 //
 // conf
 //
@@ -2974,6 +3503,48 @@ catch(const std::out_of_range &e)
 	return true;
 }
 
+bool
+console_cmd__db__prefetcher(opt &out, const string_view &line)
+{
+	if(!db::prefetcher)
+	{
+		out << "The prefetcher has not been started." << std::endl;
+		return true;
+	}
+
+	const auto &p(*db::prefetcher);
+	const auto &t(*p.ticker);
+	out << std::left
+	    << std::setw(12) << "queued" << " " << p.queued()
+	    << " (high " << p.queue.at(0).size()
+	    << " normal " << p.queue.at(1).size()
+	    << " low " << p.queue.at(2).size()
+	    << ")" << std::endl
+	    << std::setw(12) << "pending" << " " << p.pending.size() << std::endl
+	    << std::setw(12) << "workers" << " " << p.request_workers << std::endl
+	    << std::setw(12) << "queries" << " " << t.queries << std::endl
+	    << std::setw(12) << "rejects" << " " << t.rejects << std::endl
+	    << std::setw(12) << "request" << " " << t.request << std::endl
+	    << std::setw(12) << "prio_high" << " " << t.prio_high << std::endl
+	    << std::setw(12) << "prio_low" << " " << t.prio_low << std::endl
+	    << std::setw(12) << "coalesced" << " " << t.coalesced << std::endl
+	    << std::setw(12) << "promoted" << " " << t.promoted << std::endl
+	    << std::setw(12) << "expires" << " " << t.expires << std::endl
+	    << std::setw(12) << "cancels" << " " << t.cancels << std::endl
+	    << std::setw(12) << "directs" << " " << t.directs << std::endl
+	    << std::setw(12) << "handles" << " " << t.handles << std::endl
+	    << std::setw(12) << "fetches" << " " << t.fetches << std::endl
+	    << std::setw(12) << "fetched" << " " << t.fetched << std::endl
+	    << std::setw(12) << "bytes_key" << " " << pretty(iec(t.fetched_bytes_key)) << std::endl
+	    << std::setw(12) << "bytes_val" << " " << pretty(iec(t.fetched_bytes_val)) << std::endl
+	    << std::setw(12) << "snd_req" << " " << t.last_snd_req.count() << "us last "
+	    << (t.fetches? t.accum_snd_req.count() / t.fetches : 0) << "us avg" << std::endl
+	    << std::setw(12) << "req_fin" << " " << t.last_req_fin.count() << "us last "
+	    << (t.fetched? t.accum_req_fin.count() / t.fetched : 0) << "us avg" << std::endl;
+
+	return true;
+}
+
 bool
 console_cmd__db__io(opt &out, const string_view &line)
 {
@@ -4763,6 +5334,7 @@ console_cmd__peer(opt &out, const string_view &line)
 		    out << ' ';
 
 		out << " " << setw(2) << right << peer.link_count()     << " L"
+		    << " " << setw(2) << right << peer.link_target()    << " LT"
 		    << " " << setw(3) << right << peer.tag_count()      << " T"
 		    << " " << setw(3) << right << peer.tag_committed()  << " TC"
 		    << " " << setw(9) << right << peer.write_size()     << " UP Q"
@@ -4834,6 +5406,66 @@ console_cmd__peer(opt &out, const string_view &line)
 	return true;
 }
 
+bool
+console_cmd__peer__link(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"[hostport]"
+	}};
+
+	const auto &hostport
+	{
+		param["[hostport]"]
+	};
+
+	out
+	<< std::left   << std::setw(8)  << "PEER" << "  "
+	<< std::left   << std::setw(8)  << "LINK" << "  "
+	<< std::right  << std::setw(32) << "PEER NAME" << "  "
+	<< std::right  << std::setw(6)  << "TARGET" << "  "
+	<< std::right  << std::setw(5)  << "TAGS" << "  "
+	<< std::right  << std::setw(5)  << "PIPE" << "  "
+	<< std::right  << std::setw(10) << "RTT US" << "  "
+	<< std::right  << std::setw(10) << "QUEUE US" << "  "
+	<< std::left   << std::setw(5)  << "FLAGS" << "  "
+	<< std::endl
+	;
+
+	const auto print{[&out]
+	(const server::peer &peer, const server::link &link)
+	{
+		out
+		<< std::left   << std::setw(8)  << peer.id << "  "
+		<< std::left   << std::setw(8)  << link.id << "  "
+		<< std::right  << std::setw(32) << trunc(peer.hostcanon, 32) << "  "
+		<< std::right  << std::setw(6)  << peer.link_target() << "  "
+		<< std::right  << std::setw(5)  << link.tag_count() << "  "
+		<< std::right  << std::setw(5)  << link.tag_committed() << "  "
+		<< std::right  << std::setw(10) << link.rtt_avg << "  "
+		<< std::right  << std::setw(10) << link.queue_avg << "  "
+		<< std::left
+		<< (link.ready()? 'R' : '-')
+		<< (link.busy()? 'B' : '-')
+		<< (link.stalled()? 'S' : '-')
+		<< (link.exclude? 'X' : '-')
+		<< (link.op_fini? 'F' : '-')
+		<< std::endl
+		;
+	}};
+
+	for(const auto &[name, peer] : server::peers)
+	{
+		if(hostport && name != hostport)
+			continue;
+
+		for(const auto &link : peer->links)
+			print(*peer, link);
+	}
+
+	return true;
+}
+
 bool
 console_cmd__peer__count(opt &out, const string_view &line)
 {
@@ -6814,6 +7446,35 @@ console_cmd__events__dump(opt &out, const string_view &line)
 	return true;
 }
 
+bool
+console_cmd__events__import(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"path", "dir", "norooms"
+	}};
+
+	m::events::import::opts opts;
+	opts.path = param.at("path");
+	opts.dir = param["dir"] != "-"? param["dir"] : string_view{};
+	opts.rooms = param["norooms"] != "norooms";
+	const m::events::import import
+	{
+		opts
+	};
+
+	out << "imported " << import.events
+	    << " events @" << import.start << "-" << import.last
+	    << " batches:" << import.batches
+	    << " errors:" << import.errors
+	    << " files:" << import.files
+	    << " bytes:" << pretty(iec(import.bytes))
+	    << " rooms:" << import.room_ids.size()
+	    << std::endl;
+
+	return true;
+}
+
 bool
 console_cmd__events__rebuild(opt &out, const string_view &line)
 {
@@ -6821,6 +7482,99 @@ console_cmd__events__rebuild(opt &out, const string_view &line)
 	return true;
 }
 
+bool
+console_cmd__events__reindex(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"name", "appendix", "start", "stop"
+	}};
+
+	static const std::pair<string_view, m::dbs::appendix::index> appendices[]
+	{
+		{ "event_cols",         m::dbs::appendix::EVENT_COLS        },
+		{ "event_refs",         m::dbs::appendix::EVENT_REFS        },
+		{ "event_horizon",      m::dbs::appendix::EVENT_HORIZON     },
+		{ "event_sender",       m::dbs::appendix::EVENT_SENDER      },
+		{ "event_type",         m::dbs::appendix::EVENT_TYPE        },
+		{ "room_events",        m::dbs::appendix::ROOM_EVENTS       },
+		{ "room_type",          m::dbs::appendix::ROOM_TYPE         },
+	};
+
+	const string_view &name
+	{
+		param.at("name")
+	};
+
+	// Without an appendix list just report the checkpoint for the name.
+	if(!param["appendix"])
+	{
+		bool complete {false};
+		const auto event_idx
+		{
+			m::events::reindex::checkpoint(name, &complete)
+		};
+
+		out << name
+		    << " @" << event_idx
+		    << " of " << m::vm::sequence::retired
+		    << (complete? " complete" : "")
+		    << std::endl;
+
+		return true;
+	}
+
+	m::events::reindex::opts opts;
+	opts.name = name;
+	opts.range.first = param.at<uint64_t>("start", 0UL);
+	opts.range.second = param.at<uint64_t>("stop", -1UL);
+	opts.resume = !param["start"];
+	opts.wopts.appendix.reset();
+	tokens(param["appendix"], ',', [&opts]
+	(const string_view &appendix)
+	{
+		const auto it
+		{
+			std::find_if(begin(appendices), end(appendices), [&appendix]
+			(const auto &pair)
+			{
+				return pair.first == appendix;
+			})
+		};
+
+		if(it == end(appendices) && appendix == "user_dir")
+			throw error
+			{
+				"Appendix '%s' cannot be reindexed; use 'users directory rebuild'.",
+				appendix
+			};
+
+		if(it == end(appendices))
+			throw error
+			{
+				"Appendix '%s' cannot be reindexed.", appendix
+			};
+
+		opts.wopts.appendix.set(it->second);
+	});
+
+	const m::events::reindex reindex
+	{
+		opts
+	};
+
+	out << name
+	    << " @" << reindex.last
+	    << " events:" << reindex.events
+	    << " batches:" << reindex.batches
+	    << " errors:" << reindex.errors
+	    << " bytes:" << pretty(iec(reindex.bytes))
+	    << (reindex.complete? " complete" : " interrupted")
+	    << std::endl;
+
+	return true;
+}
+
 //
 // event
 //
@@ -7893,6 +8647,52 @@ console_cmd__rooms__public(opt &out, const string_view &line)
 	return true;
 }
 
+bool
+console_cmd__rooms__directory(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"server", "since", "limit"
+	}};
+
+	const string_view &server
+	{
+		param.at("server", my_host())
+	};
+
+	const string_view &since
+	{
+		param["since"] != "*"?
+			param["since"]:
+			string_view{}
+	};
+
+	auto limit
+	{
+		param.at("limit", 32L)
+	};
+
+	const m::rooms::summary::directory directory
+	{
+		server
+	};
+
+	char buf[m::room::id::buf::SIZE + 24];
+	directory.for_each(since, [&limit, &out, &buf]
+	(const m::room::id &room_id, const size_t &joined) -> bool
+	{
+		out << std::left << std::setw(8) << joined << " "
+		    << std::left << std::setw(48) << room_id << " "
+		    << m::rooms::summary::directory::since(buf, {joined, room_id})
+		    << std::endl;
+
+		return --limit > 0;
+	});
+
+	out << directory.count() << " rooms listed by " << server << std::endl;
+	return true;
+}
+
 bool
 console_cmd__rooms__fetch(opt &out, const string_view &line)
 {
@@ -8502,28 +9302,112 @@ console_cmd__room__visible(opt &out, const string_view &line)
 			param[1]
 	};
 
-	const auto &event_id
-	{
-		param[2]
-	};
+	const auto &event_id
+	{
+		param[2]
+	};
+
+	const m::room room
+	{
+		room_id, event_id
+	};
+
+	const bool visible
+	{
+		m::visible(room, mxid)
+	};
+
+	out << room_id << " is "
+	    << (visible? "VISIBLE" : "NOT VISIBLE")
+	    << (mxid? " to " : "")
+	    << mxid
+	    << (event_id? " at " : "")
+	    << event_id
+	    << std::endl;
+
+	return true;
+}
+
+bool
+console_cmd__room__visible__events(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"room_id", "user_id|node_id", "limit"
+	}};
+
+	const auto &room_id
+	{
+		m::room_id(param.at(0))
+	};
+
+	const string_view &mxid
+	{
+		param.at(1) != "*"?
+			param.at(1):
+			string_view{}
+	};
+
+	const auto limit
+	{
+		param.at(2, 64L)
+	};
+
+	m::visibility visibility
+	{
+		room_id, mxid
+	};
+
+	size_t visible(0), mismatch(0), count(0);
+	m::room::events it
+	{
+		room_id
+	};
+
+	for(; it && count < size_t(limit); --it, ++count)
+	{
+		const m::event &event{*it};
+		const bool ret
+		{
+			visibility(event)
+		};
+
+		visible += ret;
+		if(ret == m::visible(event, mxid))
+			continue;
+
+		++mismatch;
+		out << "MISMATCH " << it.event_idx()
+		    << " " << event.event_id
+		    << " evaluator: " << ret
+		    << std::endl;
+	}
+
+	out << "events:     " << count << std::endl
+	    << "visible:    " << visible << std::endl
+	    << "mismatch:   " << mismatch << std::endl
+	    << "evaluated:  " << visibility.evaluated << std::endl
+	    << "reused:     " << visibility.reused << std::endl;
 
-	const m::room room
-	{
-		room_id, event_id
-	};
+	return true;
+}
 
-	const bool visible
+bool
+console_cmd__room__visible__cache(opt &out, const string_view &line)
+{
+	const params param{line, " ",
 	{
-		m::visible(room, mxid)
-	};
+		"[clear]"
+	}};
 
-	out << room_id << " is "
-	    << (visible? "VISIBLE" : "NOT VISIBLE")
-	    << (mxid? " to " : "")
-	    << mxid
-	    << (event_id? " at " : "")
-	    << event_id
-	    << std::endl;
+	if(param["[clear]"] == "clear")
+		m::visibility::cache::clear();
+
+	out << "rooms:          " << m::visibility::cache::size() << std::endl
+	    << "generation:     " << m::visibility::cache::generation() << std::endl
+	    << "hits:           " << m::visibility::cache::hits << std::endl
+	    << "misses:         " << m::visibility::cache::misses << std::endl
+	    << "invalidations:  " << m::visibility::cache::invalidations << std::endl;
 
 	return true;
 }
@@ -9817,6 +10701,109 @@ console_cmd__room__count(opt &out, const string_view &line)
 	return true;
 }
 
+bool
+console_cmd__room__type(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"room_id", "type", "depth", "order", "limit"
+	}};
+
+	const auto &room_id
+	{
+		m::room_id(param.at("room_id"))
+	};
+
+	const string_view &type
+	{
+		param.at("type")
+	};
+
+	const int64_t depth
+	{
+		param.at<int64_t>("depth", -1L)
+	};
+
+	const char order
+	{
+		param.at("order", "b"_sv).at(0)
+	};
+
+	ssize_t limit
+	{
+		param.at("limit", ssize_t(32))
+	};
+
+	const m::room::type events
+	{
+		room_id, type, uint64_t(depth >= 0? depth : -1)
+	};
+
+	const auto closure{[&out, &limit]
+	(const auto &type, const auto &depth, const auto &event_idx)
+	{
+		const m::event::fetch event
+		{
+			event_idx, std::nothrow
+		};
+
+		if(!event.valid)
+			return true;
+
+		out << std::left << std::setw(10) << event_idx << " "
+		    << pretty_oneline(event)
+		    << std::endl;
+
+		return --limit > 0;
+	}};
+
+	if(order == 'b')
+		events.for_each(closure);
+	else
+		events.rfor_each(closure);
+
+	return true;
+}
+
+bool
+console_cmd__room__type__rebuild(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"room_id",
+	}};
+
+	const string_view &room_id
+	{
+		param["room_id"]
+	};
+
+	if(room_id == "*" || room_id == "remote_joined_only")
+	{
+		m::rooms::opts opts;
+		opts.remote_joined_only = room_id == "remote_joined_only";
+		m::rooms::for_each(opts, []
+		(const m::room::id &room_id)
+		{
+			m::room::type::rebuild
+			{
+				room_id
+			};
+
+			return true;
+		});
+
+		return true;
+	}
+
+	m::room::type::rebuild
+	{
+		m::room_id(room_id)
+	};
+
+	return true;
+}
+
 bool
 console_cmd__room__events(opt &out, const string_view &line)
 {
@@ -11716,6 +12703,92 @@ console_cmd__users(opt &out, const string_view &line)
 	return true;
 }
 
+bool
+console_cmd__users__directory(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"term", "searcher", "limit"
+	}};
+
+	const string_view &term
+	{
+		param.at("term")
+	};
+
+	const m::user::id &searcher
+	{
+		param["searcher"] && param["searcher"] != "*"?
+			m::user::id{param["searcher"]}:
+			m::user::id{}
+	};
+
+	ssize_t limit
+	{
+		param.at("limit", ssize_t(32))
+	};
+
+	const m::users::directory directory
+	{
+		searcher
+	};
+
+	directory.for_each(term, [&out, &limit]
+	(const m::user::id &user_id, const m::event::idx &event_idx)
+	{
+		out << std::left << std::setw(10) << event_idx << " "
+		    << std::left << std::setw(40) << user_id << " ";
+
+		m::get(std::nothrow, event_idx, "content", [&out]
+		(const json::object &content)
+		{
+			out << json::string(content.get("displayname"));
+		});
+
+		out << std::endl;
+
+		return --limit > 0;
+	});
+
+	return true;
+}
+
+bool
+console_cmd__users__directory__rebuild(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"room_id",
+	}};
+
+	const string_view &room_id
+	{
+		param["room_id"]
+	};
+
+	if(room_id == "*")
+	{
+		m::rooms::for_each([](const m::room::id &room_id)
+		{
+			m::users::directory::rebuild
+			{
+				room_id
+			};
+
+			return true;
+		});
+
+		return true;
+	}
+
+	m::users::directory::rebuild
+	{
+		m::room_id(room_id)
+	};
+
+	return true;
+}
+
 bool
 console_cmd__user__typing(opt &out, const string_view &line)
 {
@@ -13982,6 +15055,107 @@ console_cmd__vm(opt &out, const string_view &line)
 	return true;
 }
 
+bool
+console_cmd__vm__stages(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"[clear]"
+	}};
+
+	if(param["[clear]"] == "clear")
+	{
+		for(auto &counter : m::vm::timing::counters)
+		{
+			counter->total = 0;
+			counter->histogram.clear();
+		}
+
+		return true;
+	}
+
+	out
+	<< std::left << std::setw(16) << "STAGE" << " "
+	<< std::right << std::setw(10) << "COUNT" << " "
+	<< std::right << std::setw(16) << "TOTAL" << " "
+	<< std::right << std::setw(7) << "PCT" << " "
+	<< std::right << std::setw(12) << "AVG" << " "
+	<< std::right << std::setw(12) << "P50" << " "
+	<< std::right << std::setw(12) << "P99" << " "
+	<< std::right << std::setw(12) << "P999" << " "
+	<< std::endl;
+
+	long double total(0);
+	for(const auto &counter : m::vm::timing::counters)
+		total += static_cast<long double>(counter->total.val);
+
+	for(size_t i(0); i < m::vm::timing::counters.size(); ++i)
+	{
+		const auto &counter(*m::vm::timing::counters[i]);
+		const auto &hist(counter.histogram);
+		const auto cycles(static_cast<uint64_t>(counter.total.val));
+		out
+		<< std::left << std::setw(16) << reflect(m::vm::stage(i)) << " "
+		<< std::right << std::setw(10) << hist.count << " "
+		<< std::right << std::setw(16) << cycles << " "
+		<< std::right << std::setw(6) << std::fixed << std::setprecision(2)
+		<< (total > 0? 100.0L * cycles / total : 0.0L) << "% "
+		<< std::right << std::setw(12) << (hist.count? cycles / hist.count : 0UL) << " "
+		<< std::right << std::setw(12) << hist.quantile(0.50) << " "
+		<< std::right << std::setw(12) << hist.quantile(0.99) << " "
+		<< std::right << std::setw(12) << hist.quantile(0.999) << " "
+		<< std::endl;
+	}
+
+	return true;
+}
+
+bool
+console_cmd__vm__slow(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"[limit]"
+	}};
+
+	const size_t limit
+	{
+		param.at<size_t>("[limit]", 16UL)
+	};
+
+	size_t i(0);
+	const auto &slow(m::vm::timing::slow);
+	for(auto it(rbegin(slow)); it != rend(slow) && i < limit; ++it, ++i)
+	{
+		const auto &timing(*it);
+		const auto total(timing.total());
+
+		char pbuf[48], smbuf[32];
+		out
+		<< std::left << std::setw(60) << trunc(timing.event_id, 60) << " "
+		<< std::left << std::setw(24) << trunc(timing.type, 24) << " "
+		<< std::right << std::setw(10) << pretty(pbuf, timing.elapsed) << " "
+		<< std::right << std::setw(18) << smalldate(smbuf, timing.ts / 1000L) << " "
+		<< std::endl;
+
+		for(size_t j(0); j < timing.cycles.size(); ++j)
+		{
+			if(!timing.cycles[j])
+				continue;
+
+			out
+			<< "    "
+			<< std::left << std::setw(16) << reflect(m::vm::stage(j)) << " "
+			<< std::right << std::setw(16) << timing.cycles[j] << " "
+			<< std::right << std::setw(6) << std::fixed << std::setprecision(2)
+			<< (100.0 * timing.cycles[j] / std::max(total, 1UL)) << "%"
+			<< std::endl;
+		}
+	}
+
+	return true;
+}
+
 //
 // mc
 //
@@ -14168,6 +15342,56 @@ console_cmd__fetch(opt &out, const string_view &line)
 	return true;
 }
 
+bool
+console_cmd__fetch__health(opt &out, const string_view &line)
+{
+	const params param{line, " ",
+	{
+		"origin"
+	}};
+
+	const string_view &origin
+	{
+		param["origin"]
+	};
+
+	out
+	<< std::left << std::setw(40) << "ORIGIN" << " "
+	<< std::right << std::setw(10) << "RTT MS" << " "
+	<< std::right << std::setw(6) << "ERR" << " "
+	<< std::right << std::setw(8) << "ATTEMPT" << " "
+	<< std::right << std::setw(8) << "SUCCESS" << " "
+	<< std::right << std::setw(6) << "HEDGE" << " "
+	<< std::right << std::setw(6) << "ROOMS" << " "
+	<< std::left << "LAST"
+	<< std::endl
+	;
+
+	m::fetch::for_each([&out, &origin]
+	(const string_view &remote, const m::fetch::health &health)
+	{
+		if(origin && !startswith(remote, origin))
+			return true;
+
+		char pbuf[32];
+		out
+		<< std::left << std::setw(40) << trunc(remote, 40) << " "
+		<< std::right << std::setw(10) << uint64_t(health.rtt) << " "
+		<< std::right << std::setw(6) << std::fixed << std::setprecision(2) << health.errors << " "
+		<< std::right << std::setw(8) << health.attempts << " "
+		<< std::right << std::setw(8) << health.successes << " "
+		<< std::right << std::setw(6) << health.hedges << " "
+		<< std::right << std::setw(6) << health.rooms.size() << " "
+		<< std::left << pretty(pbuf, now<system_point>() - health.last, true) << " ago"
+		<< std::endl
+		;
+
+		return true;
+	});
+
+	return true;
+}
+
 bool
 console_cmd__fetch__event(opt &out, const string_view &line)
 {
@@ -63,6 +63,28 @@ backfill_flush_hiwat
 	{ "default",  16384L                                 },
 };
 
+conf::item<size_t>
+backfill_prefetch
+{
+	{ "name",     "ircd.federation.backfill.prefetch" },
+	{ "default",  32L                                 },
+};
+
+/// Backfill is bulk work for another server; its prefetches yield to those
+/// made for local clients.
+static const m::event::fetch::opts
+backfill_prefetch_opts
+{[]
+{
+	m::event::fetch::opts ret
+	{
+		m::event::fetch::pdu_opts
+	};
+
+	ret.gopts = db::gopts{db::get::PRIO_LOW};
+	return ret;
+}()};
+
 resource::response
 get__backfill(client &client,
               const resource::request &request)
@@ -101,6 +123,11 @@ get__backfill(client &client,
 		room_id, event_id
 	};
 
+	m::room::events ahead
+	{
+		room_id, event_id
+	};
+
 	resource::response::chunked response
 	{
 		client, http::OK
@@ -117,14 +144,29 @@ get__backfill(client &client,
 		top, "pdus"
 	};
 
-	size_t count{0};
+	m::event::fetch event
+	{
+		m::event::fetch::pdu_opts
+	};
+
+	m::visibility visible
+	{
+		room_id, request.node_id
+	};
+
+	size_t count{0}, prefetched{0};
 	for(; it && count < limit; ++count, --it)
 	{
-		const m::event &event(*it);
-		if(!visible(event, request.node_id))
+		for(; ahead && prefetched < std::min(count + backfill_prefetch, limit); --ahead, ++prefetched)
+			m::prefetch(ahead.event_idx(), backfill_prefetch_opts);
+
+		if(!seek(event, it.event_idx(), std::nothrow))
+			continue;
+
+		if(!visible(event))
 			continue;
 
-		pdus.append(event);
+		m::append_pdu(pdus, event);
 	}
 
 	return response;
@@ -46,7 +46,7 @@ handle_get(client &client,
 
 	const m::event::fetch event
 	{
-		event_id
+		event_id, m::event::fetch::pdu_opts
 	};
 
 	if(!visible(event, request.node_id))
@@ -71,7 +71,7 @@ handle_get(client &client,
 		top, "pdus"
 	};
 
-	pdus.append(event);
+	m::append_pdu(pdus, event);
 	return std::move(response);
 }
 
@@ -118,12 +118,16 @@ get__event_auth(client &client,
 		m::index(event_id)
 	};
 
-	m::event::fetch event;
+	m::event::fetch event
+	{
+		m::event::fetch::pdu_opts
+	};
+
 	chain.for_each([&auth_chain, &event]
 	(const m::event::idx &event_idx)
 	{
 		if(seek(event, event_idx, std::nothrow))
-			auth_chain.append(event);
+			m::append_pdu(auth_chain, event);
 
 		return true;
 	});
@@ -81,28 +81,33 @@ get__missing_events(client &client,
 			"You are not permitted by the room's server access control list."
 		};
 
+	const json::object::index content
+	{
+		request
+	};
+
 	ssize_t limit
 	{
-		request["limit"]?
-			std::min(lex_cast<ssize_t>(request["limit"]), ssize_t(max_limit)):
+		content["limit"]?
+			std::min(lex_cast<ssize_t>(content["limit"]), ssize_t(max_limit)):
 			ssize_t(10) // default limit (protocol spec)
 	};
 
 	const auto min_depth
 	{
-		request["min_depth"]?
-			lex_cast<uint64_t>(request["min_depth"]):
+		content["min_depth"]?
+			lex_cast<uint64_t>(content["min_depth"]):
 			0
 	};
 
 	const json::array &earliest
 	{
-		request["earliest_events"]
+		content["earliest_events"]
 	};
 
 	const json::array &latest
 	{
-		request["latest_events"]
+		content["latest_events"]
 	};
 
 	const auto in_earliest{[&earliest](const auto &event_id)
@@ -150,7 +155,16 @@ get__missing_events(client &client,
 	for(const auto &event_id : latest)
 		add_queue(unquote(event_id));
 
-	m::event::fetch event;
+	m::event::fetch event
+	{
+		m::event::fetch::pdu_opts
+	};
+
+	m::visibility visible
+	{
+		room_id, request.node_id
+	};
+
 	while(!queue.empty())
 	{
 		const auto &event_id{queue.front()};
@@ -162,10 +176,10 @@ get__missing_events(client &client,
 		if(!seek(event, event_id, std::nothrow))
 			continue;
 
-		if(!visible(event, request.node_id))
+		if(!visible(event))
 			continue;
 
-		events.append(event);
+		m::append_pdu(events, event);
 		const m::event::prev prev(event);
 		for(size_t i(0); i < prev.prev_events_count(); ++i)
 			if(!add_queue(prev.prev_event(i)))
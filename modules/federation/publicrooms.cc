@@ -34,6 +34,11 @@ flush_hiwat
 	{ "default",  16384L                                    },
 };
 
+static void
+handle_get_directory(json::stack &,
+                     const string_view &since,
+                     const size_t &limit);
+
 static resource::response
 handle_get(client &,
            const resource::request &);
@@ -51,19 +56,29 @@ resource::response
 handle_get(client &client,
            const resource::request &request)
 {
-	char sincebuf[m::room::id::buf::SIZE];
+	char sincebuf[m::room::id::buf::SIZE + 24];
 	const string_view &since
 	{
 		url::decode(sincebuf, request.query["since"])
 	};
 
-	if(since && !valid(m::id::ROOM, since))
+	const bool use_directory
+	{
+		m::rooms::summary::directory::enable
+	};
+
+	const bool since_position
+	{
+		use_directory && m::rooms::summary::directory::valid(since)
+	};
+
+	if(since && !since_position && !valid(m::id::ROOM, since))
 		throw m::BAD_REQUEST
 		{
 			"Invalid since token for this server."
 		};
 
-	if(since && m::room::id(since).host() != my_host())
+	if(since && !since_position && m::room::id(since).host() != my_host())
 		throw m::BAD_REQUEST
 		{
 			"Invalid since token for this server."
@@ -91,6 +106,14 @@ handle_get(client &client,
 		response.buf, response.flusher(), size_t(flush_hiwat)
 	};
 
+	// The listing is served in order of joined members from the materialized
+	// directory, where the since token is a position.
+	if(use_directory)
+	{
+		handle_get_directory(out, since, limit);
+		return std::move(response);
+	}
+
 	m::rooms::opts opts;
 	opts.summary = true;
 	opts.join_rule = "public";
@@ -144,3 +167,52 @@ handle_get(client &client,
 
 	return std::move(response);
 }
+
+void
+handle_get_directory(json::stack &out,
+                     const string_view &since,
+                     const size_t &limit)
+{
+	const m::rooms::summary::directory directory
+	{
+		my_host()
+	};
+
+	size_t count{0}, last_joined{0};
+	m::room::id::buf last_room_id;
+	json::stack::object top{out};
+	{
+		json::stack::array chunk
+		{
+			top, "chunk"
+		};
+
+		directory.for_each(since, [&](const m::room::id &room_id, const size_t &joined)
+		{
+			json::stack::object obj
+			{
+				chunk
+			};
+
+			m::rooms::summary::get(obj, room_id);
+			last_joined = joined;
+			last_room_id = room_id;
+			return ++count < limit;
+		});
+	}
+
+	json::stack::member
+	{
+		top, "total_room_count_estimate", json::value
+		{
+			ssize_t(directory.count())
+		}
+	};
+
+	char next_batch_buf[m::room::id::buf::SIZE + 24];
+	if(count >= limit)
+		json::stack::member
+		{
+			top, "next_batch", directory.since(next_batch_buf, {last_joined, last_room_id})
+		};
+}
@@ -163,11 +163,11 @@ put__send_join(client &client,
 		{
 			const m::event::fetch event
 			{
-				event_idx, std::nothrow
+				event_idx, std::nothrow, m::event::fetch::pdu_opts
 			};
 
 			if(event.valid)
-				auth_chain_a.append(event);
+				m::append_pdu(auth_chain_a, event);
 
 			return true;
 		}});
@@ -204,11 +204,17 @@ put__send_join(client &client,
 			data, "state"
 		};
 
-		state.for_each([&state_a]
-		(const m::event &event)
+		m::event::fetch event
 		{
-			state_a.append(event);
-		});
+			m::event::fetch::pdu_opts
+		};
+
+		state.for_each(m::event::closure_idx{[&state_a, &event]
+		(const m::event::idx &event_idx)
+		{
+			if(seek(event, event_idx, std::nothrow))
+				m::append_pdu(state_a, event);
+		}});
 	}
 
 	// state_ids (non-spec)
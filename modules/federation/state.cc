@@ -101,11 +101,17 @@ get__state(client &client,
 			top, "pdus"
 		};
 
-		state.for_each([&pdus]
-		(const m::event &event)
+		m::event::fetch event
 		{
-			pdus.append(event);
-		});
+			m::event::fetch::pdu_opts
+		};
+
+		state.for_each(m::event::closure_idx{[&pdus, &event]
+		(const m::event::idx &event_idx)
+		{
+			if(seek(event, event_idx, std::nothrow))
+				m::append_pdu(pdus, event);
+		}});
 	}
 
 	// auth_chain
@@ -116,12 +122,16 @@ get__state(client &client,
 			top, "auth_chain"
 		};
 
-		m::event::fetch event;
+		m::event::fetch event
+		{
+			m::event::fetch::pdu_opts
+		};
+
 		ac.for_each([&auth_chain, &event]
 		(const m::event::idx &event_idx)
 		{
 			if(seek(event, event_idx, std::nothrow))
-				auth_chain.append(event);
+				m::append_pdu(auth_chain, event);
 
 			return true;
 		});
@@ -10,12 +10,64 @@
 
 using namespace ircd;
 
+namespace ircd::m::device_list
+{
+	struct entry;
+
+	static void expire();
+
+	extern std::map<std::string, entry, std::less<>> cache;
+}
+
+/// Tracked devices of a remote user; device_id => the keys object.
+struct ircd::m::device_list::entry
+{
+	std::map<std::string, std::string, std::less<>> devices;
+	system_point updated;
+	long stream_id {0};
+	bool stale {false};
+};
+
 mapi::header
 IRCD_MODULE
 {
 	"Matrix Device List Update"
 };
 
+decltype(ircd::m::device_list::enable)
+IRCD_MODULE_EXPORT_DATA
+ircd::m::device_list::enable
+{
+	{ "name",     "ircd.m.device_list.cache.enable" },
+	{ "default",  true                              },
+};
+
+decltype(ircd::m::device_list::ttl)
+IRCD_MODULE_EXPORT_DATA
+ircd::m::device_list::ttl
+{
+	{ "name",     "ircd.m.device_list.cache.ttl" },
+	{ "default",  long(60 * 60 * 24)             },
+	{ "description",
+
+	R"(
+	Seconds a snapshot of a remote user's devices is trusted without being
+	queried again. Updates are normally received by EDU well within this
+	time; it bounds the damage when the remote stops sending them to us.
+	)"}
+};
+
+decltype(ircd::m::device_list::max)
+IRCD_MODULE_EXPORT_DATA
+ircd::m::device_list::max
+{
+	{ "name",     "ircd.m.device_list.cache.max" },
+	{ "default",  65536L                         },
+};
+
+decltype(ircd::m::device_list::cache)
+ircd::m::device_list::cache;
+
 static void
 handle_edu_m_device_list_update(const m::event &,
                                 m::vm::eval &);
@@ -48,16 +100,29 @@ try
 		content
 	};
 
+	if(m::user::id(json::get<"user_id"_>(update)).host() != at<"origin"_>(event))
+		return;
+
+	const bool applied
+	{
+		m::device_list::update(update)
+	};
+
 	log::info
 	{
-		m::log, "Device list update from :%s by %s for '%s' sid:%lu %s",
+		m::log, "Device list update from :%s by %s for '%s' sid:%lu %s%s",
 		json::get<"origin"_>(event),
 		json::get<"user_id"_>(update),
 		json::get<"device_id"_>(update),
 		json::get<"stream_id"_>(update),
 		json::get<"deleted"_>(update)?
-			"[deleted]"_sv:
-			string_view{}
+			"[deleted] "_sv:
+			string_view{},
+		!m::device_list::tracked(json::get<"user_id"_>(update))?
+			string_view{}:
+		applied?
+			"[applied]"_sv:
+			"[stale]"_sv,
 	};
 }
 catch(const std::exception &e)
@@ -69,3 +134,208 @@ catch(const std::exception &e)
 		e.what(),
 	};
 }
+
+//
+// device_list
+//
+
+bool
+IRCD_MODULE_EXPORT
+ircd::m::device_list::tracked(const id::user &user_id)
+{
+	return cache.count(user_id);
+}
+
+bool
+IRCD_MODULE_EXPORT
+ircd::m::device_list::fresh(const id::user &user_id)
+{
+	const auto it
+	{
+		cache.find(user_id)
+	};
+
+	if(it == end(cache))
+		return false;
+
+	const auto &entry(it->second);
+	return !entry.stale && entry.updated + seconds(ttl) > now<system_point>();
+}
+
+bool
+IRCD_MODULE_EXPORT
+ircd::m::device_list::get(const id::user &user_id,
+                          const closure &closure)
+{
+	if(!enable || !fresh(user_id))
+		return false;
+
+	// Copy out; the closure may yield and the entry can change meanwhile.
+	const auto devices
+	{
+		cache.at(user_id).devices
+	};
+
+	for(const auto &[device_id, keys] : devices)
+		closure(device_id, json::object{keys});
+
+	return true;
+}
+
+/// Replace the tracked devices of the user with the snapshot from a keys
+/// query. The last stream_id applied is kept: the snapshot was taken after
+/// it, so the next EDU in that stream still follows.
+void
+IRCD_MODULE_EXPORT
+ircd::m::device_list::set(const id::user &user_id,
+                          const json::object &device_keys)
+{
+	if(!enable || my(user_id))
+		return;
+
+	auto it
+	{
+		cache.lower_bound(user_id)
+	};
+
+	if(it == end(cache) || it->first != user_id)
+	{
+		if(cache.size() >= size_t(max))
+			expire();
+
+		it = cache.emplace_hint(it, std::string(user_id), entry{});
+	}
+
+	auto &entry(it->second);
+	entry.devices.clear();
+	for(const auto &[device_id, keys] : device_keys)
+		entry.devices.emplace(std::string(device_id), std::string(keys));
+
+	entry.updated = now<system_point>();
+	entry.stale = false;
+}
+
+/// Apply an EDU to a tracked user. The update is applied when the entry is
+/// fresh and the EDU follows the last stream_id we applied (or we have none
+/// yet); otherwise the entry is left stale. Returns true if applied.
+bool
+IRCD_MODULE_EXPORT
+ircd::m::device_list::update(const device_list_update &update)
+{
+	const auto it
+	{
+		cache.find(json::get<"user_id"_>(update))
+	};
+
+	if(it == end(cache))
+		return false;
+
+	auto &entry(it->second);
+	const long &stream_id
+	{
+		json::get<"stream_id"_>(update)
+	};
+
+	const json::array &prev_id
+	{
+		json::get<"prev_id"_>(update)
+	};
+
+	const bool follows
+	{
+		!entry.stream_id ||
+		std::any_of(begin(prev_id), end(prev_id), [&entry]
+		(const string_view &prev)
+		{
+			return try_lex_cast<long>(prev) && lex_cast<long>(prev) == entry.stream_id;
+		})
+	};
+
+	const string_view &device_id
+	{
+		json::get<"device_id"_>(update)
+	};
+
+	const json::object &keys
+	{
+		json::get<"keys"_>(update)
+	};
+
+	// A change to the display name alone doesn't carry the keys to patch
+	// the device's unsigned section with; it is queried again.
+	const bool patchable
+	{
+		json::get<"deleted"_>(update) || !empty(keys)
+	};
+
+	entry.stream_id = std::max(entry.stream_id, stream_id);
+	entry.stale |= !follows || !patchable;
+	if(entry.stale)
+		return false;
+
+	if(json::get<"deleted"_>(update))
+	{
+		const auto dit(entry.devices.find(device_id));
+		if(dit != end(entry.devices))
+			entry.devices.erase(dit);
+
+		return true;
+	}
+
+	auto dit
+	{
+		entry.devices.lower_bound(device_id)
+	};
+
+	if(dit == end(entry.devices) || dit->first != device_id)
+		dit = entry.devices.emplace_hint(dit, std::string(device_id), std::string{});
+
+	dit->second = std::string(keys);
+	return true;
+}
+
+bool
+IRCD_MODULE_EXPORT
+ircd::m::device_list::invalidate(const id::user &user_id)
+{
+	const auto it
+	{
+		cache.find(user_id)
+	};
+
+	if(it == end(cache))
+		return false;
+
+	cache.erase(it);
+	return true;
+}
+
+/// Make room in the cache by dropping stale entries, or the least recently
+/// updated entry when there are none.
+void
+ircd::m::device_list::expire()
+{
+	const auto now
+	{
+		ircd::now<system_point>()
+	};
+
+	auto oldest(end(cache));
+	for(auto it(begin(cache)); it != end(cache); )
+	{
+		const auto &entry(it->second);
+		if(entry.stale || entry.updated + seconds(ttl) <= now)
+		{
+			it = cache.erase(it);
+			continue;
+		}
+
+		if(oldest == end(cache) || entry.updated < oldest->second.updated)
+			oldest = it;
+
+		++it;
+	}
+
+	if(cache.size() >= size_t(max) && oldest != end(cache))
+		cache.erase(oldest);
+}
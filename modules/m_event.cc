@@ -160,47 +160,57 @@ namespace ircd::m::dbs
 }
 
 size_t
+IRCD_MODULE_EXPORT
 ircd::m::event::horizon::rebuild()
 {
-	m::dbs::write_opts opts;
-	opts.appendix.reset();
-	opts.appendix.set(dbs::appendix::EVENT_HORIZON);
-	db::txn txn
-	{
-		*dbs::events
-	};
-
 	size_t ret(0);
-	m::events::for_each({0UL, -1UL}, [&ret, &txn, &opts]
-	(const m::event::idx &event_idx, const m::event &event)
+	m::events::reindex::opts opts;
+	opts.name = "event_horizon";
+	opts.wopts.appendix.reset();
+	opts.wopts.appendix.set(dbs::appendix::EVENT_HORIZON);
+	opts.write = [&ret]
+	(db::txn &txn, const m::event &event, const dbs::write_opts &wopts)
 	{
 		const m::event::prev prev
 		{
 			event
 		};
 
-		m::for_each(prev, [&ret, &txn, &opts, &event_idx, &event]
+		m::for_each(prev, [&ret, &txn, &wopts, &event]
 		(const m::event::id &event_id)
 		{
 			if(m::exists(event_id))
 				return true;
 
-			opts.event_idx = event_idx;
-			m::dbs::_index_event_horizon(txn, event, opts, event_id);
-			if(++ret % 1024 == 0)
-				log::info
-				{
-					m::log, "event::horizon rebuild @ %lu/%lu",
-					event_idx,
-					m::vm::sequence::retired,
-				};
-
+			m::dbs::_index_event_horizon(txn, event, wopts, event_id);
+			++ret;
 			return true;
 		});
+	};
 
-		return true;
-	});
+	const m::events::reindex result
+	{
+		opts
+	};
 
-	txn();
 	return ret;
 }
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// event/refs.h
+//
+
+void
+IRCD_MODULE_EXPORT
+ircd::m::event::refs::rebuild()
+{
+	m::events::reindex::opts opts;
+	opts.name = "event_refs";
+	opts.wopts.appendix.reset();
+	opts.wopts.appendix.set(dbs::appendix::EVENT_REFS);
+	const m::events::reindex result
+	{
+		opts
+	};
+}
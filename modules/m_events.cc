@@ -26,69 +26,678 @@ ircd::m::events::dump_buffer_size
 	{ "default",  int64_t(4_MiB)                   },
 };
 
-void
+decltype(ircd::m::events::reindex::batch_size)
+ircd::m::events::reindex::batch_size
+{
+	{ "name",     "ircd.m.events.reindex.batch_size" },
+	{ "default",  int64_t(64_MiB)                    },
+	{ "description",
+
+	R"(
+	Size of the transaction at which a reindex commits and checkpoints its
+	progress. This bounds the memory used by a reindex of the whole database.
+	)"}
+};
+
+decltype(ircd::m::events::reindex::pool_size)
+ircd::m::events::reindex::pool_size
+{
+	{ "name",     "ircd.m.events.reindex.pool_size" },
+	{ "default",  64L                               },
+};
+
+decltype(ircd::m::events::reindex::log_interval)
+ircd::m::events::reindex::log_interval
+{
+	{ "name",     "ircd.m.events.reindex.log_interval" },
+	{ "default",  10L                                  },
+};
+
 IRCD_MODULE_EXPORT
-ircd::m::events::rebuild()
+ircd::m::events::reindex::reindex(const struct opts &opts)
+:start
 {
-	static const event::fetch::opts fopts
+	opts.range.first
+}
+{
+	const size_t batch_max
+	{
+		opts.batch_size?: size_t(batch_size)
+	};
+
+	const size_t pool_max
 	{
-		event::keys::include {"type", "sender"}
+		opts.pool_size?: size_t(pool_size)
 	};
 
-	static const m::events::range range
+	// Events written after we start were indexed by the vm anyway; this
+	// also excludes the checkpoint events we're about to generate.
+	const event::idx stop
 	{
-		0, -1UL, &fopts
+		std::min(opts.range.second, vm::sequence::retired + 1)
 	};
 
+	if(opts.name && opts.resume)
+	{
+		bool checkpoint_complete {false};
+		const event::idx checkpoint_idx
+		{
+			checkpoint(opts.name, &checkpoint_complete)
+		};
+
+		if(!checkpoint_complete && checkpoint_idx >= start && checkpoint_idx < stop)
+			start = checkpoint_idx + 1;
+	}
+
 	db::txn txn
 	{
-		*m::dbs::events
+		*dbs::events
 	};
 
-	dbs::write_opts wopts;
-	wopts.appendix.reset();
-	wopts.appendix.set(dbs::appendix::EVENT_TYPE);
-	wopts.appendix.set(dbs::appendix::EVENT_SENDER);
+	const auto save{[&opts, this]
+	{
+		if(!opts.name)
+			return;
 
-	size_t ret(0);
-	for_each(range, [&txn, &wopts, &ret]
-	(const event::idx &event_idx, const m::event &event)
+		m::send(m::my_room, m::me, "ircd.events.reindex", opts.name, json::members
+		{
+			{ "event_idx",  long(last)     },
+			{ "complete",   complete       },
+			{ "events",     long(events)   },
+		});
+	}};
+
+	ctx::dock dock;
+	size_t dispatched(0), finished(0);
+	const auto drain{[&dock, &dispatched, &finished]
 	{
-		wopts.event_idx = event_idx;
-		dbs::write(txn, event, wopts);
-		++ret;
+		dock.wait([&dispatched, &finished]
+		{
+			return finished >= dispatched;
+		});
+	}};
 
-		if(ret % 8192UL == 0UL)
-			log::info
+	const auto commit{[this, &txn, &drain, &save]
+	{
+		drain();
+		if(txn.size())
+		{
+			bytes += txn.bytes();
+			txn();
+			txn.clear();
+			++batches;
+		}
+
+		save();
+	}};
+
+	const ircd::timer timer;
+	auto log_last(timer.at<seconds>());
+	const auto report{[this, &timer, &opts, &stop, &txn]
+	(const string_view &what)
+	{
+		const auto elapsed
+		{
+			std::max(timer.at<milliseconds>().count(), 1L)
+		};
+
+		char pbuf[2][48];
+		log::info
+		{
+			log, "Reindex %s %s @%lu of %lu; %zu events in %zu batches; %zu errors; %s written; %zu events/s; %s/s; txn:%zu %s",
+			opts.name?: "*"_sv,
+			what,
+			last,
+			stop,
+			events,
+			batches,
+			errors,
+			pretty(pbuf[0], iec(bytes)),
+			events * 1000UL / elapsed,
+			pretty(pbuf[1], iec(bytes * 1000UL / elapsed)),
+			txn.size(),
+			pretty(iec(txn.bytes())),
+		};
+	}};
+
+	ctx::pool pool;
+	pool.min(pool_max);
+
+	auto it
+	{
+		dbs::event_json.lower_bound(byte_view<string_view>(start))
+	};
+
+	bool interrupted {false};
+	const ctx::uninterruptible::nothrow ui;
+	for(; bool(it); ++it)
+	{
+		if((interrupted = ctx::interruption_requested()))
+			break;
+
+		const event::idx event_idx
+		{
+			byte_view<event::idx>(it->first)
+		};
+
+		if(event_idx >= stop)
+			break;
+
+		if(txn.bytes() >= batch_max)
+			commit();
+
+		// The source must be copied out of the iterator for the worker; the
+		// pool's flow control limits how many of these are in flight.
+		std::string source
+		{
+			it->second
+		};
+
+		++dispatched;
+		pool([this, &opts, &txn, &dock, &finished, event_idx, source(std::move(source))]
+		{
+			const unwind notify{[&dock, &finished]
 			{
-				log, "Events type/sender table rebuild events %zu of %zu num:%zu txn:%zu %s",
-				event_idx,
-				vm::sequence::retired,
-				ret,
-				txn.size(),
-				pretty(iec(txn.bytes())),
-			};
+				++finished;
+				dock.notify_all();
+			}};
 
-		return true;
+			dbs::write_opts wopts(opts.wopts);
+			wopts.event_idx = event_idx;
+			try
+			{
+				const m::event event
+				{
+					json::object{source}
+				};
+
+				if(opts.write)
+					opts.write(txn, event, wopts);
+				else
+					dbs::write(txn, event, wopts);
+			}
+			catch(const std::exception &e)
+			{
+				++errors;
+				log::error
+				{
+					log, "Reindex %s event_idx:%lu :%s",
+					opts.name?: "*"_sv,
+					event_idx,
+					e.what(),
+				};
+			}
+		});
+
+		last = event_idx;
+		++events;
+		if(timer.at<seconds>() - log_last >= seconds(size_t(log_interval)))
+		{
+			log_last = timer.at<seconds>();
+			report("progress");
+		}
+	}
+
+	complete = !interrupted;
+	commit();
+	report(complete? "complete" : "interrupted");
+}
+
+ircd::m::event::idx
+IRCD_MODULE_EXPORT
+ircd::m::events::reindex::checkpoint(const string_view &name,
+                                     bool *const &complete)
+{
+	const m::room::state state
+	{
+		m::my_room
+	};
+
+	const m::event::idx &event_idx
+	{
+		state.get(std::nothrow, "ircd.events.reindex", name)
+	};
+
+	event::idx ret{0};
+	m::get(std::nothrow, event_idx, "content", [&ret, &complete]
+	(const json::object &content)
+	{
+		ret = content.get<event::idx>("event_idx", 0UL);
+		if(complete)
+			*complete = content.get<bool>("complete", false);
+	});
+
+	return ret;
+}
+
+//
+// events::import
+//
+
+decltype(ircd::m::events::import::batch_size)
+ircd::m::events::import::batch_size
+{
+	{ "name",     "ircd.m.events.import.batch_size" },
+	{ "default",  int64_t(64_MiB)                   },
+	{ "description",
+
+	R"(
+	Bytes of the input stream read and imported as one batch. Each batch is
+	ingested as a set of SST files, one for each column it touches.
+	)"}
+};
+
+decltype(ircd::m::events::import::pool_size)
+ircd::m::events::import::pool_size
+{
+	{ "name",     "ircd.m.events.import.pool_size" },
+	{ "default",  64L                              },
+};
+
+decltype(ircd::m::events::import::appendix_default)
+ircd::m::events::import::appendix_default{[]
+{
+	std::bitset<64> ret;
+	ret.set(dbs::appendix::EVENT_JSON);
+	ret.set(dbs::appendix::EVENT_COLS);
+	ret.set(dbs::appendix::EVENT_REFS);
+	ret.set(dbs::appendix::EVENT_SENDER);
+	ret.set(dbs::appendix::EVENT_TYPE);
+	ret.set(dbs::appendix::ROOM_EVENTS);
+	ret.set(dbs::appendix::ROOM_TYPE);
+	ret.set(dbs::appendix::ROOM_STATE_SPACE);
+	return ret;
+}()};
+
+IRCD_MODULE_EXPORT
+ircd::m::events::import::import(const struct opts &opts)
+{
+	// Hold the vm for the whole run: evals which begin meanwhile wait for
+	// vm::ready, so nothing else takes an event_idx from the range assigned
+	// here. The notify is declared first so it runs after ready is restored.
+	const scope_notify resume_vm
+	{
+		vm::dock, scope_notify::all
+	};
+
+	const scope_restore hold_vm
+	{
+		vm::ready, false
+	};
+
+	vm::dock.wait([]
+	{
+		return !vm::eval::executing && !vm::eval::injecting;
 	});
 
-    log::info
-    {
-        log, "Events type/sender table rebuild events:%zu txn:%zu %s commit...",
-        ret,
-        txn.size(),
-        pretty(iec(txn.bytes())),
-    };
-
-	txn();
-
-    log::notice
-    {
-        log, "Events type/sender table rebuild complete.",
-        ret,
-        txn.size(),
-        pretty(iec(txn.bytes())),
-    };
+	assert(vm::sequence::committed == vm::sequence::retired);
+	start = vm::sequence::retired + 1;
+
+	const size_t batch_max
+	{
+		opts.batch_size?: size_t(batch_size)
+	};
+
+	const size_t pool_max
+	{
+		opts.pool_size?: size_t(pool_size)
+	};
+
+	const fs::fd file
+	{
+		opts.path
+	};
+
+	const unique_buffer<mutable_buffer> buf
+	{
+		batch_max
+	};
+
+	// Room versions of the create events in the stream, for computing the
+	// event_id of events which don't carry one.
+	std::map<std::string, std::string, std::less<>> versions;
+	const auto version{[&versions]
+	(const mutable_buffer &buf, const m::room::id &room_id)
+	-> string_view
+	{
+		const auto it(versions.find(room_id));
+		if(it != end(versions))
+			return it->second;
+
+		return m::version(buf, m::room{room_id}, std::nothrow)?: "1"_sv;
+	}};
+
+	ctx::dock dock;
+	size_t dispatched(0), finished(0);
+	ctx::pool pool;
+	pool.min(pool_max);
+
+	const ircd::timer timer;
+	size_t foff(0);
+	event::idx next(start);
+	while(!ctx::interruption_requested())
+	{
+		const string_view read
+		{
+			fs::read(file, buf, foff)
+		};
+
+		if(empty(read))
+			break;
+
+		// Take the complete objects at the front of the buffer; the object
+		// truncated by the end of the buffer starts the next read.
+		size_t boff(0);
+		std::string parse_error;
+		std::vector<json::object> objects;
+		for(json::vector vector{read}; boff < size(read); ) try
+		{
+			const json::object object
+			{
+				*begin(vector)
+			};
+
+			boff = std::distance(data(read), end(string_view{object}));
+			vector = json::vector
+			{
+				data(read) + boff, size(read) - boff
+			};
+
+			objects.emplace_back(object);
+		}
+		catch(const json::parse_error &e)
+		{
+			parse_error = e.what();
+			break;
+		}
+
+		const bool eof
+		{
+			size(read) < size(buf)
+		};
+
+		const string_view remain
+		{
+			lstrip(string_view{data(read) + boff, size(read) - boff}, " \t\r\n"_sv)
+		};
+
+		// What remains at the end of the file can't be the front of an object
+		// continued by the next read.
+		if(eof && !empty(remain) && !empty(parse_error))
+			throw m::BAD_JSON
+			{
+				"Malformed event at offset %zu :%s",
+				foff + boff,
+				parse_error,
+			};
+
+		if(objects.empty() && eof)
+			break;
+
+		if(objects.empty())
+			throw m::BAD_JSON
+			{
+				"Malformed event or event exceeding the batch size of %zu bytes at offset %zu :%s",
+				size(buf),
+				foff,
+				parse_error,
+			};
+
+		const size_t batch_foff(foff);
+		foff += boff;
+		std::vector<m::event> batch(objects.size());
+		std::vector<event::id::buf> ids(objects.size());
+		std::vector<event::idx> idxs(objects.size(), 0UL);
+		std::set<string_view, std::less<>> batch_ids;
+
+		// Assign indexes and ingest the event_id => event_idx mapping first
+		// so that references to these events resolve for the writers below.
+		db::txn txn
+		{
+			*dbs::events
+		};
+
+		dbs::write_opts wopts;
+		wopts.appendix.reset();
+		wopts.appendix.set(dbs::appendix::EVENT_ID);
+		for(size_t i(0); i < objects.size(); ++i) try
+		{
+			auto &event(batch[i]);
+			event = m::event{objects[i]};
+
+			const m::room::id &room_id
+			{
+				json::get<"room_id"_>(event)
+			};
+
+			if(json::get<"type"_>(event) == "m.room.create")
+				versions.emplace(room_id, json::get<"content"_>(event).get("room_version", "1"));
+
+			if(!event.event_id)
+			{
+				char vbuf[32];
+				event.event_id = make_id(event, version(vbuf, room_id), ids[i]);
+			}
+
+			// The mapping for an earlier event in this batch is only in the
+			// txn; the database can't answer for it yet.
+			if(!batch_ids.emplace(event.event_id).second)
+				continue;
+
+			if(m::exists(event.event_id))
+				continue;
+
+			idxs[i] = next++;
+			wopts.event_idx = idxs[i];
+			dbs::write(txn, event, wopts);
+			room_ids.emplace(room_id);
+		}
+		catch(const std::exception &e)
+		{
+			++errors;
+			log::error
+			{
+				log, "Import %s at offset %zu :%s",
+				opts.path,
+				batch_foff,
+				e.what(),
+			};
+		}
+
+		// Reserve the assigned range before anything is written so it is
+		// never assigned again, even if this batch fails.
+		vm::sequence::retired = std::max(vm::sequence::retired, next - 1);
+		vm::sequence::committed = vm::sequence::retired;
+		vm::sequence::uncommitted = vm::sequence::retired;
+
+		const db::database::sst::ingest ingested_ids
+		{
+			txn, opts.dir
+		};
+
+		// Removes the mappings ingested above for the events given, so
+		// nothing refers to an event_idx which has no event_json.
+		const auto rollback{[&batch, &idxs]
+		(const std::vector<size_t> &which)
+		{
+			db::txn txn
+			{
+				*dbs::events
+			};
+
+			dbs::write_opts wopts;
+			wopts.op = db::op::DELETE;
+			wopts.appendix.reset();
+			wopts.appendix.set(dbs::appendix::EVENT_ID);
+			for(const auto &i : which)
+			{
+				wopts.event_idx = idxs[i];
+				dbs::write(txn, batch[i], wopts);
+			}
+
+			txn();
+		}};
+
+		txn.clear();
+		std::vector<size_t> failed;
+		auto _wopts(wopts);
+		_wopts.appendix = opts.appendix;
+		_wopts.appendix.reset(dbs::appendix::EVENT_ID);
+		size_t ingested_files(0), ingested_bytes(0); try
+		{
+			for(size_t i(0); i < batch.size(); ++i)
+			{
+				if(!idxs[i])
+					continue;
+
+				++dispatched;
+				pool([this, &opts, &txn, &dock, &finished, &failed, &_wopts, &batch, &idxs, i]
+				{
+					const unwind notify{[&dock, &finished]
+					{
+						++finished;
+						dock.notify_all();
+					}};
+
+					const auto &event(batch[i]);
+					auto wopts(_wopts);
+					wopts.event_idx = idxs[i];
+					try
+					{
+						// Each event is written on its own first; writers
+						// yield and interleave in the shared txn, which then
+						// only receives complete events.
+						db::txn etxn
+						{
+							*dbs::events
+						};
+
+						dbs::write(etxn, event, wopts);
+						db::for_each(etxn, db::delta_closure{[&txn]
+						(const db::delta &delta)
+						{
+							db::txn::append
+							{
+								txn, delta
+							};
+						}});
+					}
+					catch(const std::exception &e)
+					{
+						++errors;
+						failed.emplace_back(i);
+						log::error
+						{
+							log, "Import %s event_idx:%lu %s :%s",
+							opts.path,
+							idxs[i],
+							string_view{event.event_id},
+							e.what(),
+						};
+					}
+				});
+			}
+
+			dock.wait([&dispatched, &finished]
+			{
+				return finished >= dispatched;
+			});
+
+			const db::database::sst::ingest ingested
+			{
+				txn, opts.dir
+			};
+
+			ingested_files = ingested.files;
+			ingested_bytes = ingested.bytes;
+		}
+		catch(const std::exception &)
+		{
+			dock.wait([&dispatched, &finished]
+			{
+				return finished >= dispatched;
+			});
+
+			std::vector<size_t> all;
+			for(size_t i(0); i < batch.size(); ++i)
+				if(idxs[i])
+					all.emplace_back(i);
+
+			rollback(all);
+			throw;
+		}
+
+		if(!failed.empty())
+			rollback(failed);
+
+		for(size_t i(0); i < batch.size(); ++i)
+			if(idxs[i])
+			{
+				last = idxs[i];
+				++events;
+			}
+
+		events -= failed.size();
+		++batches;
+		files += ingested_ids.files + ingested_files;
+		bytes += ingested_ids.bytes + ingested_bytes;
+
+		const auto elapsed
+		{
+			std::max(timer.at<milliseconds>().count(), 1L)
+		};
+
+		char pbuf[3][48];
+		log::info
+		{
+			log, "Import %s @%zu %s read; %zu events in %zu batches; %zu errors; %zu files %s; %zu events/s; %s/s",
+			opts.path,
+			last,
+			pretty(pbuf[0], iec(foff)),
+			events,
+			batches,
+			errors,
+			files,
+			pretty(pbuf[1], iec(bytes)),
+			events * 1000UL / elapsed,
+			pretty(pbuf[2], iec(foff * 1000UL / elapsed)),
+		};
+	}
+
+	if(!opts.rooms)
+		return;
+
+	for(const auto &room_id : room_ids)
+	{
+		if(ctx::interruption_requested())
+			break;
+
+		const m::room room
+		{
+			room_id
+		};
+
+		m::room::head::rebuild(m::room::head{room});
+		m::room::state::rebuild
+		{
+			room.room_id
+		};
+	}
+}
+
+void
+IRCD_MODULE_EXPORT
+ircd::m::events::rebuild()
+{
+	reindex::opts opts;
+	opts.name = "type_sender";
+	opts.wopts.appendix.reset();
+	opts.wopts.appendix.set(dbs::appendix::EVENT_TYPE);
+	opts.wopts.appendix.set(dbs::appendix::EVENT_SENDER);
+	const reindex result
+	{
+		opts
+	};
 }
 
 void
@@ -22,20 +22,39 @@ namespace ircd::m::fetch
 	extern ctx::dock dock;
 	extern ctx::mutex requests_mutex;
 	extern std::set<request, std::less<>> requests;
+	extern std::map<std::string, health, std::less<>> healths;
 	extern ctx::context request_context;
 	extern conf::item<size_t> backfill_limit_default;
 	extern conf::item<size_t> requests_max;
 	extern conf::item<seconds> timeout;
 	extern conf::item<bool> enable;
+	extern conf::item<bool> select_weighted;
+	extern conf::item<bool> hedge_enable;
+	extern conf::item<double> hedge_quantile;
+	extern conf::item<milliseconds> hedge_min;
+	extern conf::item<size_t> health_max;
+	extern stats::histogram latency;
 	extern log::log log;
 
 	static bool timedout(const request &, const system_point &now);
+	static milliseconds hedge_delay();
+	static bool hedge_due(const request &, const system_point &now);
 	static void _check_event(const request &, const m::event &);
 	static void check_response(const request &, const json::object &);
+	static void record(const request &, const string_view &origin, const system_point &started, const bool &ok);
+	static double weight(const request &, const string_view &origin);
 	static string_view select_origin(request &, const string_view &);
+	static string_view select_weighted_origin(request &);
 	static string_view select_random_origin(request &);
+	static string_view select_origin(request &);
 	static void finish(request &);
 	static void retry(request &);
+	static bool handle_hedge(request &);
+	static void promote_hedge(request &);
+	static void swap_hedge(request &);
+	static void cancel_hedge(request &);
+	static bool start_hedge(request &);
+	static std::unique_ptr<server::request> submit(request &, const string_view &remote, const mutable_buffer &);
 	static bool start(request &, const string_view &remote);
 	static bool start(request &);
 	static void handle_result(request &);
@@ -90,6 +109,60 @@ ircd::m::fetch::backfill_limit_default
 	{ "default",  96L                                   },
 };
 
+decltype(ircd::m::fetch::select_weighted)
+ircd::m::fetch::select_weighted
+{
+	{ "name",     "ircd.m.fetch.select.weighted" },
+	{ "default",  true                           },
+	{
+		"description",
+		"Weight the selection of a server for each attempt by its observed"
+		" response time, error rate, open connections and whether it has"
+		" answered for the room before; otherwise select uniformly."
+	},
+};
+
+decltype(ircd::m::fetch::hedge_enable)
+ircd::m::fetch::hedge_enable
+{
+	{ "name",     "ircd.m.fetch.hedge.enable" },
+	{ "default",  false                       },
+	{
+		"description",
+		"Make a concurrent attempt to another server when the first attempt"
+		" has not responded within the hedge quantile of response times."
+	},
+};
+
+decltype(ircd::m::fetch::hedge_quantile)
+ircd::m::fetch::hedge_quantile
+{
+	{ "name",     "ircd.m.fetch.hedge.quantile" },
+	{ "default",  0.90                          },
+};
+
+decltype(ircd::m::fetch::hedge_min)
+ircd::m::fetch::hedge_min
+{
+	{ "name",     "ircd.m.fetch.hedge.min" },
+	{ "default",  500L                     },
+};
+
+decltype(ircd::m::fetch::health_max)
+ircd::m::fetch::health_max
+{
+	{ "name",     "ircd.m.fetch.health.max" },
+	{ "default",  4096L                     },
+};
+
+/// Time for a successful attempt in microseconds; the hedge delay is
+/// derived from this distribution.
+decltype(ircd::m::fetch::latency)
+ircd::m::fetch::latency
+{
+	{ "name", "ircd.m.fetch.latency.usec" },
+};
+
 decltype(ircd::m::fetch::request_context)
 ircd::m::fetch::request_context
 {
@@ -105,6 +178,9 @@ ircd::m::fetch::requests_mutex;
 decltype(ircd::m::fetch::dock)
 ircd::m::fetch::dock;
 
+decltype(ircd::m::fetch::healths)
+ircd::m::fetch::healths;
+
 //
 // init
 //
@@ -120,6 +196,7 @@ ircd::m::fetch::fini()
 	request_context.terminate();
 	request_context.join();
 	requests.clear();
+	healths.clear();
 
 	assert(requests.empty());
 }
@@ -230,6 +307,17 @@ ircd::m::fetch::for_each(const std::function<bool (request &)> &closure)
 	return true;
 }
 
+bool
+IRCD_MODULE_EXPORT
+ircd::m::fetch::for_each(const std::function<bool (const string_view &, const health &)> &closure)
+{
+	for(const auto &[origin, health] : healths)
+		if(!closure(origin, health))
+			return false;
+
+	return true;
+}
+
 ircd::string_view
 IRCD_MODULE_EXPORT
 ircd::m::fetch::reflect(const op &op)
@@ -295,24 +383,49 @@ ircd::m::fetch::request_handle()
 		fetch::dock
 	};
 
+	// Each request may have a hedge attempt in flight in addition to its
+	// primary attempt; all of them are waited on together. Requests without
+	// any attempt in flight during this pass are not included.
+	using slot = std::pair<decltype(requests)::iterator, server::request *>;
+	std::vector<slot> slots;
+	slots.reserve(requests.size() * 2);
+	for(auto it(begin(requests)); it != end(requests); ++it)
+	{
+		auto &request(mutable_cast(*it));
+		if(request.future)
+			slots.emplace_back(it, request.future.get());
+
+		if(request.hedge)
+			slots.emplace_back(it, request.hedge.get());
+	}
+
 	static const auto dereferencer{[]
 	(auto &it) -> server::request &
 	{
-		// If the request doesn't have a server::request future attached
-		// during this pass we reference this default constructed static
-		// instance which when_any() will treat as a no-op.
-		static server::request request_skip;
-		auto &request(mutable_cast(*it));
-		return request.future?
-			*request.future:
-			request_skip;
+		return *it->second;
 	}};
 
 	auto next
 	{
-		ctx::when_any(requests.begin(), requests.end(), dereferencer)
+		ctx::when_any(begin(slots), end(slots), dereferencer)
 	};
 
+	// Wake up no later than the next hedge is due, if any.
+	const auto now
+	{
+		ircd::now<system_point>()
+	};
+
+	milliseconds wait
+	{
+		duration_cast<milliseconds>(seconds(timeout))
+	};
+
+	if(hedge_enable)
+		for(const auto &request : requests)
+			if(request.future && !request.hedge && !request.finished)
+				wait = std::min(wait, std::max(duration_cast<milliseconds>(request.last + hedge_delay() - now), milliseconds(1)));
+
 	bool timedout{true};
 	{
 		const unlock_guard unlock
@@ -320,7 +433,7 @@ ircd::m::fetch::request_handle()
 			lock
 		};
 
-		timedout = !next.wait(seconds(timeout), std::nothrow);
+		timedout = !next.wait(wait, std::nothrow);
 	};
 
 	if(likely(!timedout))
@@ -330,9 +443,22 @@ ircd::m::fetch::request_handle()
 			next.get()
 		};
 
-		if(it != end(requests))
-			if(!request_handle(it))
+		if(it != end(slots))
+		{
+			auto &request
+			{
+				mutable_cast(*it->first)
+			};
+
+			// The hedge responded first; it only replaces the primary attempt
+			// if its result is good.
+			if(it->second == request.hedge.get())
+				if(!handle_hedge(request))
+					return;
+
+			if(!request_handle(it->first))
 				return;
+		}
 	}
 
 	request_cleanup();
@@ -371,7 +497,16 @@ try
 			start(request);
 
 		else if(!request.finished && timedout(request, now))
-			retry(request);
+		{
+			record(request, request.origin, request.last, false);
+			if(request.hedge)
+				promote_hedge(request);
+			else
+				retry(request);
+		}
+
+		else if(!request.finished && hedge_due(request, now))
+			start_hedge(request);
 	}
 
 	auto it(begin(requests)); while(it != end(requests))
@@ -414,9 +549,9 @@ try
 		request.started = ircd::now<system_point>();
 
 	if(!request.origin)
-		select_random_origin(request);
+		select_origin(request);
 
-	for(; request.origin; select_random_origin(request))
+	for(; request.origin; select_origin(request))
 	{
 		if(start(request, request.origin))
 			return true;
@@ -458,6 +593,63 @@ try
 	if(!request.started)
 		request.started = request.last;
 
+	request.future = submit(request, remote, request.buf);
+
+	log::debug
+	{
+		log, "Starting %s request for %s in %s from '%s'",
+		reflect(request.opts.op),
+		string_view{request.opts.event_id},
+		string_view{request.opts.room_id},
+		string_view{request.origin},
+	};
+
+	dock.notify_all();
+	return true;
+}
+catch(const m::UNAVAILABLE &e)
+{
+	throw;
+}
+catch(const http::error &e)
+{
+	record(request, remote, request.last, false);
+	log::logf
+	{
+		log, run::level == run::level::QUIT? log::DERROR: log::ERROR,
+		"Starting %s request for %s in %s to '%s' :%s %s",
+		reflect(request.opts.op),
+		string_view{request.opts.event_id},
+		string_view{request.opts.room_id},
+		string_view{request.origin},
+		e.what(),
+		e.content,
+	};
+
+	return false;
+}
+catch(const std::exception &e)
+{
+	record(request, remote, request.last, false);
+	log::logf
+	{
+		log, run::level == run::level::QUIT? log::DERROR: log::ERROR,
+		"Starting %s request for %s in %s to '%s' :%s",
+		reflect(request.opts.op),
+		string_view{request.opts.event_id},
+		string_view{request.opts.room_id},
+		string_view{request.origin},
+		e.what()
+	};
+
+	return false;
+}
+
+std::unique_ptr<ircd::server::request>
+ircd::m::fetch::submit(request &request,
+                       const string_view &remote,
+                       const mutable_buffer &buf)
+{
 	switch(request.opts.op)
 	{
 		case op::noop:
@@ -468,15 +660,13 @@ try
 			v1::event_auth::opts opts;
 			opts.remote = remote;
 			opts.dynamic = true;
-			request.future = std::make_unique<v1::event_auth>
+			return std::make_unique<v1::event_auth>
 			(
 				request.opts.room_id,
 				request.opts.event_id,
-				request.buf,
+				buf,
 				std::move(opts)
 			);
-
-			break;
 		}
 
 		case op::event:
@@ -484,14 +674,12 @@ try
 			v1::event::opts opts;
 			opts.remote = remote;
 			opts.dynamic = true;
-			request.future = std::make_unique<v1::event>
+			return std::make_unique<v1::event>
 			(
 				request.opts.event_id,
-				request.buf,
+				buf,
 				std::move(opts)
 			);
-
-			break;
 		}
 
 		case op::backfill:
@@ -502,65 +690,360 @@ try
 			opts.limit = request.opts.backfill_limit;
 			opts.limit = opts.limit?: size_t(backfill_limit_default);
 			opts.event_id = request.opts.event_id;
-			request.future = std::make_unique<v1::backfill>
+			return std::make_unique<v1::backfill>
 			(
 				request.opts.room_id,
-				request.buf,
+				buf,
 				std::move(opts)
 			);
-
-			break;
 		}
 	}
 
+	return {};
+}
+
+//
+// hedge
+//
+
+bool
+ircd::m::fetch::start_hedge(request &request)
+try
+{
+	assert(!request.finished);
+	assert(request.future && !request.hedge);
+
+	// Selection places the hedge's origin in the attempted set and sets it
+	// as the request's origin; the primary's origin is restored after.
+	const auto primary
+	{
+		request.origin
+	};
+
+	const unwind restore{[&request, &primary]
+	{
+		request.origin = primary;
+	}};
+
+	if(request.opts.attempt_limit && request.attempted.size() >= request.opts.attempt_limit)
+		return false;
+
+	request.hedge_origin = select_origin(request);
+	if(!request.hedge_origin)
+		return false;
+
+	if(!request.hedge_buf)
+		request.hedge_buf = unique_buffer<mutable_buffer>
+		{
+			size(request.buf)
+		};
+
+	request.hedge_last = ircd::now<system_point>();
+	request.hedge = submit(request, request.hedge_origin, request.hedge_buf);
+
+	const auto it(healths.find(request.hedge_origin));
+	if(it != end(healths))
+		++it->second.hedges;
+
 	log::debug
 	{
-		log, "Starting %s request for %s in %s from '%s'",
+		log, "Hedging %s request for %s in %s from '%s' after '%s'",
 		reflect(request.opts.op),
 		string_view{request.opts.event_id},
 		string_view{request.opts.room_id},
-		string_view{request.origin},
+		request.hedge_origin,
+		primary,
 	};
 
 	dock.notify_all();
 	return true;
 }
-catch(const m::UNAVAILABLE &e)
+catch(const ctx::interrupted &)
 {
 	throw;
 }
-catch(const http::error &e)
+catch(const std::exception &e)
 {
-	log::logf
+	record(request, request.hedge_origin, request.hedge_last, false);
+	log::derror
 	{
-		log, run::level == run::level::QUIT? log::DERROR: log::ERROR,
-		"Starting %s request for %s in %s to '%s' :%s %s",
+		log, "Hedging %s request for %s in %s to '%s' :%s",
 		reflect(request.opts.op),
 		string_view{request.opts.event_id},
 		string_view{request.opts.room_id},
-		string_view{request.origin},
+		request.hedge_origin,
 		e.what(),
-		e.content,
 	};
 
+	request.hedge.reset(nullptr);
+	request.hedge_origin = {};
 	return false;
 }
-catch(const std::exception &e)
+
+/// Handle the result of a hedge which completed before the primary attempt.
+/// A good result finishes the request and cancels the primary; otherwise the
+/// failure is recorded against the hedge's origin, the hedge is dropped and
+/// the primary is left to continue. Returns true when the request finished.
+bool
+ircd::m::fetch::handle_hedge(request &request)
 {
-	log::logf
+	assert(request.hedge);
+	swap_hedge(request);
+	handle_result(request);
+	if(!request.eptr)
 	{
-		log, run::level == run::level::QUIT? log::DERROR: log::ERROR,
-		"Starting %s request for %s in %s to '%s' :%s",
-		reflect(request.opts.op),
-		string_view{request.opts.event_id},
-		string_view{request.opts.room_id},
-		string_view{request.origin},
-		e.what()
-	};
+		finish(request);
+		return true;
+	}
 
+	// The primary is still in the hedge position; promoting it back cancels
+	// the failed hedge.
+	request.eptr = std::exception_ptr{};
+	promote_hedge(request);
 	return false;
 }
 
+/// Swap the hedge attempt into the primary position and cancel what was
+/// the primary attempt.
+void
+ircd::m::fetch::promote_hedge(request &request)
+{
+	assert(request.hedge);
+	swap_hedge(request);
+	cancel_hedge(request);
+}
+
+void
+ircd::m::fetch::swap_hedge(request &request)
+{
+	std::swap(request.future, request.hedge);
+	std::swap(request.buf, request.hedge_buf);
+	std::swap(request.origin, request.hedge_origin);
+	std::swap(request.last, request.hedge_last);
+}
+
+void
+ircd::m::fetch::cancel_hedge(request &request)
+{
+	if(!request.hedge)
+		return;
+
+	server::cancel(*request.hedge);
+	request.hedge.reset(nullptr);
+	request.hedge_origin = {};
+}
+
+bool
+ircd::m::fetch::hedge_due(const request &request,
+                          const system_point &now)
+{
+	return hedge_enable
+	&& request.future
+	&& !request.hedge
+	&& request.last + hedge_delay() < now;
+}
+
+ircd::milliseconds
+ircd::m::fetch::hedge_delay()
+{
+	// Until enough results have been observed the quantile is noise.
+	const microseconds observed
+	{
+		latency.count >= 32?
+			latency.quantile(hedge_quantile):
+			0UL
+	};
+
+	return std::clamp
+	(
+		duration_cast<milliseconds>(observed),
+		milliseconds(hedge_min),
+		duration_cast<milliseconds>(seconds(timeout))
+	);
+}
+
+//
+// health
+//
+
+void
+ircd::m::fetch::record(const request &request,
+                       const string_view &origin,
+                       const system_point &started,
+                       const bool &ok)
+{
+	static const float alpha
+	{
+		0.25
+	};
+
+	if(!origin)
+		return;
+
+	auto it
+	{
+		healths.lower_bound(origin)
+	};
+
+	if(it == end(healths) || it->first != origin)
+		it = healths.emplace_hint(it, std::string{origin}, health{});
+
+	const auto now
+	{
+		ircd::now<system_point>()
+	};
+
+	const auto elapsed
+	{
+		duration_cast<microseconds>(now - started)
+	};
+
+	auto &health(it->second);
+	const float ms(elapsed.count() / 1000.0);
+	health.rtt = health.attempts? health.rtt + alpha * (ms - health.rtt): ms;
+	health.errors += alpha * ((ok? 0.0f: 1.0f) - health.errors);
+	health.successes += ok;
+	health.attempts++;
+	health.last = now;
+
+	if(ok)
+	{
+		latency(elapsed.count());
+		if(!health.answered(request.opts.room_id))
+		{
+			health.rooms.emplace_front(request.opts.room_id);
+			if(health.rooms.size() > 16)
+				health.rooms.pop_back();
+		}
+	}
+
+	// Evict the least recently updated entry when the table is full.
+	if(healths.size() > size_t(health_max))
+	{
+		const auto oldest
+		{
+			std::min_element(begin(healths), end(healths), []
+			(const auto &a, const auto &b)
+			{
+				return a.second.last < b.second.last;
+			})
+		};
+
+		healths.erase(oldest);
+	}
+}
+
+double
+ircd::m::fetch::weight(const request &request,
+                       const string_view &origin)
+{
+	// Servers never heard from are assumed to respond in a quarter second
+	// and not to fail; this places them behind known good servers.
+	static const health unknown
+	{
+		250.0, 0.0
+	};
+
+	const auto it
+	{
+		healths.find(origin)
+	};
+
+	const auto &health
+	{
+		it != end(healths)? it->second : unknown
+	};
+
+	double ret
+	{
+		1.0 / (1.0 + health.rtt / 250.0)
+	};
+
+	ret *= std::max(1.0 - health.errors, 0.05);
+
+	if(health.answered(request.opts.room_id))
+		ret *= 4.0;
+
+	// Prefer servers where a connection is already established and ready.
+	const auto pit
+	{
+		server::peers.find(host(net::hostport{origin}))
+	};
+
+	if(pit != end(server::peers) && pit->second && pit->second->link_ready())
+		ret *= 2.0;
+
+	return ret;
+}
+
+bool
+IRCD_MODULE_EXPORT
+ircd::m::fetch::health::answered(const string_view &room_id)
+const
+{
+	return std::find(begin(rooms), end(rooms), room_id) != end(rooms);
+}
+
+//
+// select
+//
+
+ircd::string_view
+ircd::m::fetch::select_origin(request &request)
+{
+	return select_weighted?
+		select_weighted_origin(request):
+		select_random_origin(request);
+}
+
+ircd::string_view
+ircd::m::fetch::select_weighted_origin(request &request)
+{
+	const m::room::origins origins
+	{
+		request.opts.room_id
+	};
+
+	// Weighted random sampling in a single pass: each viable origin draws a
+	// key of u^(1/w) and the greatest key is selected.
+	double best(-1.0);
+	std::string selected;
+	origins.for_each([&request, &best, &selected]
+	(const string_view &origin)
+	{
+		if(my_host(origin))
+			return;
+
+		if(request.attempted.count(origin))
+			return;
+
+		if(ircd::server::errmsg(origin))
+			return;
+
+		const double u
+		{
+			(rand::integer(1, 1UL << 53) / double(1UL << 53))
+		};
+
+		const double key
+		{
+			std::pow(u, 1.0 / weight(request, origin))
+		};
+
+		if(key > best)
+		{
+			best = key;
+			selected = origin;
+		}
+	});
+
+	request.origin = {};
+	if(!selected.empty())
+		select_origin(request, selected);
+
+	return request.origin;
+}
+
 ircd::string_view
 ircd::m::fetch::select_random_origin(request &request)
 {
@@ -619,6 +1102,15 @@ ircd::m::fetch::handle(request &request)
 	if(likely(request.future))
 		handle_result(request);
 
+	// The primary attempt failed while the hedge is still in flight, so the
+	// hedge takes its place rather than starting over.
+	if(request.eptr && request.hedge)
+	{
+		promote_hedge(request);
+		request.eptr = std::exception_ptr{};
+		return false;
+	}
+
 	if(!request.eptr)
 		finish(request);
 	else
@@ -642,6 +1134,7 @@ try
 	};
 
 	check_response(request, content);
+	record(request, request.origin, request.last, true);
 
 	char pbuf[48];
 	log::debug
@@ -659,6 +1152,7 @@ try
 catch(...)
 {
 	request.eptr = std::current_exception();
+	record(request, request.origin, request.last, false);
 
 	log::derror
 	{
@@ -684,6 +1178,7 @@ try
 		request.future.reset(nullptr);
 	}
 
+	cancel_hedge(request);
 	request.eptr = std::exception_ptr{};
 	request.origin = {};
 	start(request);
@@ -698,6 +1193,7 @@ void
 ircd::m::fetch::finish(request &request)
 {
 	request.finished = ircd::now<system_point>();
+	cancel_hedge(request);
 
 	#if 0
 	log::logf
@@ -1055,5 +1551,6 @@ ircd::m::fetch::request::~request()
 noexcept
 {
 	//TODO: bad things unless this first here
+	hedge.reset(nullptr);
 	future.reset(nullptr);
 }
@@ -238,9 +238,21 @@ try
 	m::v1::key::opts opts;
 	opts.remote = net::hostport{query_server};
 	opts.dynamic = true;
+
+	// The request content for a batch of many servers may exceed the
+	// buffer otherwise only needed for the headers.
+	const size_t content_size
+	{
+		std::accumulate(begin(queries), end(queries), size_t(0), []
+		(const size_t &ret, const auto &query)
+		{
+			return ret + ircd::size(query.first) + ircd::size(query.second) + 16;
+		})
+	};
+
 	const unique_buffer<mutable_buffer> buf
 	{
-		16_KiB
+		16_KiB + content_size
 	};
 
 	m::v1::key::query request
@@ -300,12 +312,134 @@ ircd::m::keys_get_timeout
 	{ "default",  20000L                  }
 };
 
+//
+// fetch
+//
+
+namespace ircd::m
+{
+	static void verify_notary(const m::keys &, const string_view &notary);
+
+	extern conf::item<std::string> keys_fetch_notary;
+	extern conf::item<size_t> keys_fetch_batch_max;
+}
+
+decltype(ircd::m::keys_fetch_notary)
+ircd::m::keys_fetch_notary
+{
+	{ "name",     "ircd.keys.fetch.notary" },
+	{ "default",  string_view{}            },
+	{ "description",
+
+	R"(
+	Server trusted to relay the keys of other servers. Keys missing from the
+	cache are queried from it in batches before any remaining keys are
+	requested from each server individually. Every key it relays must carry
+	its signature. When empty there is none.
+	)"}
+};
+
+decltype(ircd::m::keys_fetch_batch_max)
+ircd::m::keys_fetch_batch_max
+{
+	{ "name",     "ircd.keys.fetch.batch_max" },
+	{ "default",  256L                        },
+};
+
+/// Acquires the keys for all of the queries which are not already cached.
+/// The cache is consulted for everything first; what's missing is requested
+/// from the configured notary in batched /key/v2/query requests, and anything
+/// the notary could not provide is then requested from each server in
+/// parallel. Returns the number of queries satisfied, including those already
+/// cached.
 size_t
 IRCD_MODULE_EXPORT
 ircd::m::keys::fetch(const queries &queries)
 {
-	size_t ret(0);
-	get(queries, [&ret](const auto &)
+	const string_view notary
+	{
+		keys_fetch_notary
+	};
+
+	std::vector<m::v1::key::server_key> missing;
+	missing.reserve(queries.size());
+	for(const auto &[server_name, key_id] : queries)
+		if(!my_host(server_name) && !cache::has(server_name, key_id))
+			missing.emplace_back(server_name, key_id);
+
+	// Grouping by server lets the request list each server's keys once.
+	std::sort(begin(missing), end(missing));
+	missing.erase(std::unique(begin(missing), end(missing)), end(missing));
+
+	const size_t cached
+	{
+		queries.size() - std::min(missing.size(), queries.size())
+	};
+
+	const auto is_cached{[](const auto &query)
+	{
+		return cache::has(query.first, query.second);
+	}};
+
+	const size_t batch_max
+	{
+		std::max(size_t(keys_fetch_batch_max), 1UL)
+	};
+
+	const size_t requested(missing.size());
+	if(notary && !my_host(notary))
+		for(size_t i(0); i < missing.size(); i += batch_max) try
+		{
+			const keys::queries batch
+			{
+				missing.data() + i, std::min(missing.size() - i, batch_max)
+			};
+
+			query(notary, batch, [&notary]
+			(const json::object &key)
+			{
+				verify_notary(m::keys{key}, notary);
+				return true;
+			});
+		}
+		catch(const ctx::interrupted &)
+		{
+			throw;
+		}
+		catch(const std::exception &e)
+		{
+			log::derror
+			{
+				m::log, "Failed to query %zu keys from notary '%s' :%s",
+				std::min(missing.size() - i, batch_max),
+				notary,
+				e.what(),
+			};
+		}
+
+	if(notary && !my_host(notary))
+		missing.erase(std::remove_if(begin(missing), end(missing), is_cached), end(missing));
+
+	const size_t remaining
+	{
+		missing.size()
+	};
+
+	log::debug
+	{
+		m::log, "Fetched keys for %zu queries; %zu cached; %zu missing; %zu from notary '%s'",
+		queries.size(),
+		cached,
+		requested,
+		requested - remaining,
+		notary,
+	};
+
+	size_t ret(cached + requested - remaining);
+	if(!remaining)
+		return ret;
+
+	get(missing, [&ret](const auto &)
 	{
 		++ret;
 		return true;
@@ -314,6 +448,72 @@ ircd::m::keys::fetch(const queries &queries)
 	return ret;
 }
 
+/// Keys relayed by a notary are signed by the server they belong to, which
+/// verify() checks, and by the notary itself, which is checked here against
+/// the notary's own keys. Without the latter any server could relay forged
+/// keys self-signed in the name of another.
+void
+ircd::m::verify_notary(const m::keys &keys,
+                       const string_view &notary)
+{
+	const json::object &signatures
+	{
+		at<"signatures"_>(keys).at(notary)
+	};
+
+	m::keys copy{keys};
+	at<"signatures"_>(copy) = string_view{};
+
+	// Not a thread_local buffer because fetching the notary's keys yields.
+	const json::strung preimage
+	{
+		copy
+	};
+
+	bool verified(false);
+	for(const auto &[key_id, signature] : signatures)
+		keys::get(notary, unquote(key_id), [&]
+		(const json::object &notary_keys)
+		{
+			const json::object &verify_keys
+			{
+				notary_keys.at("verify_keys")
+			};
+
+			const json::object &key
+			{
+				verify_keys.at(unquote(key_id))
+			};
+
+			const ed25519::pk pk
+			{
+				[&key](auto &pk)
+				{
+					b64decode(pk, unquote(key.at("key")));
+				}
+			};
+
+			const ed25519::sig sig
+			{
+				[&signature](auto &sig)
+				{
+					b64decode(sig, unquote(signature));
+				}
+			};
+
+			verified |= pk.verify(const_buffer{preimage}, sig);
+		});
+
+	if(!verified)
+		throw m::error
+		{
+			http::UNAUTHORIZED, "M_INVALID_SIGNATURE",
+			"Notary '%s' did not sign the keys it relayed for '%s'",
+			notary,
+			json::get<"server_name"_>(keys),
+		};
+}
+
 void
 IRCD_MODULE_EXPORT
 ircd::m::keys::get(const string_view &server_name,
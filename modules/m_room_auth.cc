@@ -329,15 +329,37 @@ ircd::m::room::auth::check(const event &event,
 {
 	using json::at;
 
+	// The present state of the power events is known without querying.
+	const auto cached
+	{
+		!room.event_id?
+			cache::get(room.room_id):
+			nullptr
+	};
+
+	const bool join_rules
+	{
+		at<"type"_>(event) == "m.room.member" &&
+		(membership(event) == "join" || membership(event) == "invite")
+	};
+
 	m::event::idx idx[5]
 	{
-		room.get(std::nothrow, "m.room.create", ""),
-		room.get(std::nothrow, "m.room.power_levels", ""),
+		cached?
+			cached->create_idx:
+			room.get(std::nothrow, "m.room.create", ""),
+
+		cached?
+			cached->power_idx:
+			room.get(std::nothrow, "m.room.power_levels", ""),
+
 		room.get(std::nothrow, "m.room.member", at<"sender"_>(event)),
 
-		at<"type"_>(event) == "m.room.member" &&
-		(membership(event) == "join" || membership(event) == "invite")?
-			room.get(std::nothrow, "m.room.join_rules", ""): 0UL,
+		join_rules && cached?
+			cached->join_rules_idx:
+		join_rules?
+			room.get(std::nothrow, "m.room.join_rules", ""):
+			0UL,
 
 		at<"type"_>(event) == "m.room.member" &&
 		at<"sender"_>(event) != json::get<"state_key"_>(event) &&
@@ -565,9 +587,20 @@ ircd::m::check_room_auth_rule_8(const m::event &event,
 {
 	using FAIL = room::auth::FAIL;
 
+	// When the auth_events reference the same power_levels as the present
+	// state of the room the decoded levels are used.
+	const auto cached
+	{
+		data.auth_power && data.auth_power->event_id?
+			room::auth::cache::get(at<"room_id"_>(event)):
+			nullptr
+	};
+
 	const m::room::power power
 	{
-		data.auth_power? *data.auth_power : m::event{}, *data.auth_create
+		cached && cached->power_event_id == data.auth_power->event_id?
+			m::room::power{cached}:
+			m::room::power{data.auth_power? *data.auth_power : m::event{}, *data.auth_create}
 	};
 
 	// 8. If the event type's required power level is greater than the
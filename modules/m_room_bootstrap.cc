@@ -16,7 +16,7 @@ namespace ircd::m::bootstrap
 	static event::id::buf make_join(const string_view &host, const room::id &, const user::id &);
 	static send_join1_response send_join(const string_view &host, const room::id &, const event::id &, const json::object &event);
 	static void broadcast_join(const room &, const event &, const string_view &exclude);
-	static void fetch_keys(const json::array &events);
+	static void fetch_keys(const vector_view<const json::array> &);
 	static void eval_auth_chain(const json::array &auth_chain);
 	static void eval_state(const json::array &state);
 	static void backfill(const string_view &host, const room::id &, const event::id &);
@@ -235,10 +235,9 @@ try
 		auth_chain.size(),
 	};
 
-	m::bootstrap::fetch_keys(auth_chain);
+	// The keys for both sets are acquired at once.
+	m::bootstrap::fetch_keys({auth_chain, state});
 	m::bootstrap::eval_auth_chain(auth_chain);
-
-	m::bootstrap::fetch_keys(state);
 	m::bootstrap::eval_state(state);
 
 	m::bootstrap::backfill(host, room_id, event_id);
@@ -456,11 +455,14 @@ try
 		pdus.size(),
 	};
 
+	m::bootstrap::fetch_keys({pdus});
+
 	m::vm::opts vmopts;
 	vmopts.nothrows = -1;
 	vmopts.warnlog &= ~vm::fault::EXISTS;
 	vmopts.fetch_state = false;
 	vmopts.fetch_prev = false;
+	vmopts.fetch_keys = false;
 	vmopts.infolog_accept = false;
 	m::vm::eval
 	{
@@ -499,6 +501,7 @@ try
 	opts.warnlog &= ~vm::fault::EXISTS;
 	opts.fetch_state = false;
 	opts.fetch_prev = false;
+	opts.fetch_keys = false;
 	opts.infolog_accept = true;
 	m::vm::eval
 	{
@@ -532,6 +535,7 @@ try
 	opts.warnlog &= ~vm::fault::EXISTS;
 	opts.infolog_accept = true;
 	opts.fetch = false;
+	opts.fetch_keys = false;
 	m::vm::eval
 	{
 		auth_chain, opts
@@ -550,16 +554,20 @@ catch(const std::exception &e)
 }
 
 void
-ircd::m::bootstrap::fetch_keys(const json::array &events)
+ircd::m::bootstrap::fetch_keys(const vector_view<const json::array> &sets)
 try
 {
+	size_t events(0);
 	std::vector<m::v1::key::server_key> queries;
-	queries.reserve(events.size());
+	for(const auto &set : sets)
+		for(const json::object &event : set)
+		{
+			for(const auto &[server_name, signatures] : json::object(event["signatures"]))
+				for(const auto &[key_id, signature] : json::object(signatures))
+					queries.emplace_back(unquote(server_name), unquote(key_id));
 
-	for(const json::object &event : events)
-		for(const auto &[server_name, signatures] : json::object(event["signatures"]))
-			for(const auto &[key_id, signature] : json::object(signatures))
-				queries.emplace_back(unquote(event.at("origin")), key_id);
+			++events;
+		}
 
 	std::sort(begin(queries), end(queries));
 	queries.erase(std::unique(begin(queries), end(queries)), end(queries));
@@ -568,7 +576,7 @@ try
 	{
 		log, "Fetching %zu keys for %zu events...",
 		queries.size(),
-		events.size(),
+		events,
 	};
 
 	const size_t fetched
@@ -581,15 +589,15 @@ try
 		log, "Fetched %zu of %zu keys for %zu events",
 		fetched,
 		queries.size(),
-		events.size(),
+		events,
 	};
 }
 catch(const std::exception &e)
 {
 	log::error
 	{
-		log, "Error when fetching keys for %zu events :%s",
-		events.size(),
+		log, "Error when fetching keys :%s",
+		e.what(),
 	};
 
 	// All errors for the parallel key fetch are logged and then suppressed
@@ -10,6 +10,7 @@
 
 namespace ircd::m
 {
+	static bool _visible(const event &, const string_view &mxid);
 	static bool visible_to_node(const room &, const string_view &node_id, const event &);
 	static bool visible_to_user(const room &, const string_view &history_visibility, const m::user::id &, const event &);
 
@@ -51,6 +52,39 @@ bool
 IRCD_MODULE_EXPORT
 ircd::m::visible(const m::event &event,
                  const string_view &mxid)
+{
+	// Only a test of the room itself at its present state is cached; the
+	// result for an actual event may depend on the event.
+	const bool cacheable
+	{
+		!event.event_id && !json::get<"type"_>(event)
+	};
+
+	if(!cacheable)
+		return _visible(event, mxid);
+
+	const m::room::id &room_id
+	{
+		at<"room_id"_>(event)
+	};
+
+	bool ret;
+	if(visibility::cache::get(room_id, mxid, ret))
+		return ret;
+
+	const auto generation
+	{
+		visibility::cache::generation()
+	};
+
+	ret = _visible(event, mxid);
+	visibility::cache::set(room_id, mxid, ret, generation);
+	return ret;
+}
+
+bool
+ircd::m::_visible(const m::event &event,
+                  const string_view &mxid)
 {
 	const m::room room
 	{
@@ -181,3 +215,272 @@ ircd::m::visible_to_node(const m::room &room,
 
 	return false;
 }
+
+//
+// visibility
+//
+
+IRCD_MODULE_EXPORT
+ircd::m::visibility::visibility(const m::room::id &room_id,
+                                const string_view &mxid)
+:room_id
+{
+	room_id
+}
+,mxid
+{
+	mxid
+}
+,user
+{
+	m::valid(m::id::USER, mxid)
+}
+,head_id
+{
+	m::head(std::nothrow, room_id)
+}
+{
+	if(!empty(mxid) && !user && !rfc3986::valid_remote(std::nothrow, mxid))
+		throw m::UNSUPPORTED
+		{
+			"Cannot determine visibility of %s for '%s'",
+			string_view{room_id},
+			mxid,
+		};
+
+	const m::room::state::space space
+	{
+		m::room{room_id}
+	};
+
+	space.for_each("m.room.history_visibility", "", [this]
+	(const auto &, const auto &, const auto &depth, const auto &event_idx)
+	{
+		history_visibility.emplace_back(depth, event_idx);
+		return true;
+	});
+
+	if(user)
+		space.for_each("m.room.member", mxid, [this]
+		(const auto &, const auto &, const auto &depth, const auto &event_idx)
+		{
+			membership.emplace_back(depth, event_idx);
+			return true;
+		});
+}
+
+bool
+IRCD_MODULE_EXPORT
+ircd::m::visibility::operator()(const m::event &event)
+{
+	if(unlikely(json::get<"room_id"_>(event) != room_id))
+		return m::visible(event, mxid);
+
+	++evaluated;
+	if(!empty(mxid) && excepted(event))
+		return true;
+
+	const bool is_present
+	{
+		!m::room::state::enable_history
+		|| !event.event_id
+		|| !head_id
+		|| event.event_id == head_id
+	};
+
+	if(is_present)
+	{
+		if(!present)
+		{
+			const m::room::state state
+			{
+				m::room{room_id}
+			};
+
+			present.emplace
+			(
+				state.get(std::nothrow, "m.room.history_visibility", ""),
+				user? state.get(std::nothrow, "m.room.member", mxid): 0UL
+			);
+		}
+
+		return decide({present->first, present->second, true});
+	}
+
+	// Without the depth the state at the event can't be found here; defer to
+	// the full evaluation.
+	const int64_t &bound
+	{
+		json::get<"depth"_>(event)
+	};
+
+	if(unlikely(bound == json::undefined_number))
+		return m::visible(event, mxid);
+
+	// Same as room::state::history: the most recent state strictly below the
+	// depth of the event.
+	const auto at{[&bound](const states &states) -> event::idx
+	{
+		const auto it
+		{
+			std::partition_point(begin(states), end(states), [&bound]
+			(const auto &state)
+			{
+				return state.first >= bound;
+			})
+		};
+
+		return it != end(states)? it->second : 0UL;
+	}};
+
+	return decide({at(history_visibility), at(membership), false});
+}
+
+/// Conditions under which visible() allows an event regardless of the
+/// visibility setting and membership, as they depend on the event itself.
+bool
+ircd::m::visibility::excepted(const m::event &event)
+const
+{
+	const auto &state_key
+	{
+		json::get<"state_key"_>(event)
+	};
+
+	if(user)
+		return json::get<"type"_>(event) == "m.room.member" && state_key == mxid;
+
+	if(m::room::auth::is_power_event(event))
+		return true;
+
+	if(m::valid(m::id::USER, state_key))
+		if(m::user::id(state_key).host() == mxid)
+			return true;
+
+	return false;
+}
+
+bool
+ircd::m::visibility::decide(const decision_key &key)
+{
+	const auto it
+	{
+		decided.lower_bound(key)
+	};
+
+	if(it != end(decided) && it->first == key)
+	{
+		++reused;
+		return it->second;
+	}
+
+	// The present decision is the same as testing the room at its present
+	// state so it can be shared with other requests through the cache.
+	const bool &is_present(std::get<bool>(key));
+	bool ret;
+	if(is_present && cache::get(room_id, mxid, ret))
+		return decided.emplace_hint(it, key, ret)->second;
+
+	const auto generation
+	{
+		cache::generation()
+	};
+
+	ret = _decide(key);
+	if(is_present)
+		cache::set(room_id, mxid, ret, generation);
+
+	return decided.emplace_hint(it, key, ret)->second;
+}
+
+bool
+ircd::m::visibility::_decide(const decision_key &key)
+{
+	const auto &[hv_idx, member_idx, is_present] {key};
+	const string_view history_visibility
+	{
+		get(hv_idx, "history_visibility", "shared")
+	};
+
+	if(history_visibility == "world_readable")
+		return true;
+
+	if(empty(mxid))
+		return false;
+
+	if(!user)
+	{
+		if(present_origin < 0)
+		{
+			const m::room::origins origins
+			{
+				m::room{room_id}
+			};
+
+			present_origin = origins.has(mxid);
+		}
+
+		return present_origin;
+	}
+
+	const string_view membership
+	{
+		get(member_idx, "membership", "")
+	};
+
+	if(membership == "join")
+		return true;
+
+	if(history_visibility == "joined")
+		return false;
+
+	if(membership == "invite")
+		return true;
+
+	if(history_visibility == "invited")
+		return false;
+
+	// At the present state the membership tested above is the present
+	// membership; see visible_to_user().
+	if(is_present)
+		return false;
+
+	if(present_membership < 0)
+	{
+		const m::room present
+		{
+			room_id
+		};
+
+		present_membership = m::membership(present, mxid, m::membership_positive);
+	}
+
+	return present_membership;
+}
+
+ircd::string_view
+ircd::m::visibility::get(const event::idx &event_idx,
+                         const string_view &key,
+                         const string_view &default_)
+{
+	if(!event_idx)
+		return default_;
+
+	auto it
+	{
+		value.lower_bound(event_idx)
+	};
+
+	if(it != end(value) && it->first == event_idx)
+		return it->second;
+
+	std::string val(default_);
+	m::get(std::nothrow, event_idx, "content", [&key, &default_, &val]
+	(const json::object &content)
+	{
+		val = json::string(content.get(key, default_));
+	});
+
+	it = value.emplace_hint(it, event_idx, std::move(val));
+	return it->second;
+}
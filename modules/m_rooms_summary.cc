@@ -334,6 +334,460 @@ ircd::m::rooms::summary::make_state_key(const mutable_buffer &buf,
 	};
 }
 
+//
+// rooms::summary::directory
+//
+
+namespace ircd::m::rooms::summary
+{
+	struct directory_cmp;
+	struct directory_origin;
+	using directory_key = std::pair<size_t, std::string>;
+
+	static size_t directory_joined(const room::id &, const string_view &origin, const event::idx &);
+	static void directory_set(const room::id &, const string_view &origin, const size_t &joined);
+	static void directory_del(const room::id &, const string_view &origin);
+	static void directory_init();
+
+	static void handle_directory_summary(const event &, vm::eval &);
+	static void handle_directory_redaction(const event &, vm::eval &);
+	static void handle_directory_member(const event &, vm::eval &);
+
+	extern std::map<std::string, directory_origin, std::less<>> directories;
+	extern ctx::mutex directories_mutex;
+	extern bool directories_ready;
+	extern hookfn<vm::eval &> directory_summary_hook;
+	extern hookfn<vm::eval &> directory_redaction_hook;
+	extern hookfn<vm::eval &> directory_member_hook;
+}
+
+/// Joined count descending, then room_id ascending.
+struct ircd::m::rooms::summary::directory_cmp
+{
+	bool operator()(const directory_key &a, const directory_key &b) const
+	{
+		return a.first != b.first?
+			a.first > b.first:
+			a.second < b.second;
+	}
+};
+
+/// Rooms listed by one origin; the position of each room in the order is
+/// found through its current count so it can be moved.
+struct ircd::m::rooms::summary::directory_origin
+{
+	std::set<directory_key, directory_cmp> order;
+	std::map<std::string, size_t, std::less<>> joined;
+};
+
+decltype(ircd::m::rooms::summary::directory::enable)
+IRCD_MODULE_EXPORT_DATA
+ircd::m::rooms::summary::directory::enable
+{
+	{ "name",     "ircd.m.rooms.summary.directory.enable" },
+	{ "default",  true                                    },
+	{ "description",
+
+	R"(
+	Serve unfiltered public rooms listings from the materialized directory,
+	ordered by joined member count. When false, listings iterate the public
+	rooms room in room_id order.
+	)"}
+};
+
+decltype(ircd::m::rooms::summary::directories)
+ircd::m::rooms::summary::directories;
+
+decltype(ircd::m::rooms::summary::directories_mutex)
+ircd::m::rooms::summary::directories_mutex;
+
+decltype(ircd::m::rooms::summary::directories_ready)
+ircd::m::rooms::summary::directories_ready;
+
+decltype(ircd::m::rooms::summary::directory_summary_hook)
+ircd::m::rooms::summary::directory_summary_hook
+{
+	handle_directory_summary,
+	{
+		{ "_site",       "vm.effect"           },
+		{ "room_id",     "!public"             },
+		{ "type",        "ircd.rooms.summary"  },
+	}
+};
+
+decltype(ircd::m::rooms::summary::directory_redaction_hook)
+ircd::m::rooms::summary::directory_redaction_hook
+{
+	handle_directory_redaction,
+	{
+		{ "_site",       "vm.effect"           },
+		{ "room_id",     "!public"             },
+		{ "type",        "m.room.redaction"    },
+	}
+};
+
+decltype(ircd::m::rooms::summary::directory_member_hook)
+ircd::m::rooms::summary::directory_member_hook
+{
+	handle_directory_member,
+	{
+		{ "_site",       "vm.effect"           },
+		{ "type",        "m.room.member"       },
+	}
+};
+
+size_t
+IRCD_MODULE_EXPORT
+ircd::m::rooms::summary::directory::count()
+const
+{
+	directory_init();
+	const auto it
+	{
+		directories.find(origin)
+	};
+
+	return it != end(directories)?
+		it->second.order.size():
+		0UL;
+}
+
+bool
+IRCD_MODULE_EXPORT
+ircd::m::rooms::summary::directory::for_each(const closure &closure)
+const
+{
+	return for_each(string_view{}, closure);
+}
+
+bool
+IRCD_MODULE_EXPORT
+ircd::m::rooms::summary::directory::for_each(const string_view &since,
+                                             const closure &closure)
+const
+{
+	directory_init();
+	const auto dit
+	{
+		directories.find(origin)
+	};
+
+	if(dit == end(directories))
+		return true;
+
+	const auto &order
+	{
+		dit->second.order
+	};
+
+	// A bare room_id is a token from before the directory; its position is
+	// wherever that room is now.
+	directory_key last;
+	if(m::valid(id::ROOM, since))
+	{
+		const auto it(dit->second.joined.find(since));
+		if(it != end(dit->second.joined))
+			last = { it->second, std::string(since) };
+	}
+	else if(since)
+	{
+		const auto &[joined, room_id](directory::since(since));
+		last = { joined, std::string(room_id) };
+	}
+
+	auto it
+	{
+		!last.second.empty()?
+			order.upper_bound(last):
+			order.begin()
+	};
+
+	// The closure may yield, during which the directory can change; the
+	// iteration resumes by seeking past the last position each time.
+	for(; it != end(order); it = order.upper_bound(last))
+	{
+		last = *it;
+		if(!closure(room::id{last.second}, last.first))
+			return false;
+	}
+
+	return true;
+}
+
+ircd::string_view
+IRCD_MODULE_EXPORT
+ircd::m::rooms::summary::directory::since(const mutable_buffer &buf,
+                                          const position &pos)
+{
+	return fmt::sprintf
+	{
+		buf, "%zu,%s",
+		pos.first,
+		string_view{pos.second},
+	};
+}
+
+ircd::m::rooms::summary::directory::position
+IRCD_MODULE_EXPORT
+ircd::m::rooms::summary::directory::since(const string_view &token)
+{
+	if(!valid(token))
+		throw m::BAD_REQUEST
+		{
+			"Invalid since token for this server."
+		};
+
+	const auto &[joined, room_id]
+	{
+		split(token, ',')
+	};
+
+	return
+	{
+		lex_cast<size_t>(joined), room::id{room_id}
+	};
+}
+
+bool
+IRCD_MODULE_EXPORT
+ircd::m::rooms::summary::directory::valid(const string_view &token)
+{
+	const auto &[joined, room_id]
+	{
+		split(token, ',')
+	};
+
+	return
+		try_lex_cast<size_t>(joined) &&
+		m::valid(id::ROOM, room_id);
+}
+
+void
+ircd::m::rooms::summary::directory_init()
+{
+	if(likely(directories_ready))
+		return;
+
+	const std::lock_guard lock
+	{
+		directories_mutex
+	};
+
+	if(directories_ready)
+		return;
+
+	const m::room::state state
+	{
+		public_room_id
+	};
+
+	size_t count(0);
+	state.for_each("ircd.rooms.summary", [&count]
+	(const string_view &type, const string_view &state_key, const event::idx &event_idx)
+	{
+		const auto &[room_id, origin]
+		{
+			unmake_state_key(state_key)
+		};
+
+		directory_set(room_id, origin, directory_joined(room_id, origin, event_idx));
+		++count;
+		return true;
+	});
+
+	directories_ready = true;
+	log::info
+	{
+		m::log, "Public rooms directory of %zu summaries from %zu origins.",
+		count,
+		directories.size(),
+	};
+}
+
+void
+ircd::m::rooms::summary::directory_set(const room::id &room_id,
+                                       const string_view &origin,
+                                       const size_t &joined)
+{
+	auto dit
+	{
+		directories.lower_bound(origin)
+	};
+
+	if(dit == end(directories) || dit->first != origin)
+		dit = directories.emplace_hint(dit, std::string(origin), directory_origin{});
+
+	auto &dir(dit->second);
+	auto it
+	{
+		dir.joined.lower_bound(room_id)
+	};
+
+	if(it != end(dir.joined) && it->first == room_id)
+	{
+		if(it->second == joined)
+			return;
+
+		dir.order.erase(directory_key{it->second, it->first});
+		it->second = joined;
+	}
+	else it = dir.joined.emplace_hint(it, std::string(room_id), joined);
+
+	dir.order.emplace(joined, it->first);
+}
+
+void
+ircd::m::rooms::summary::directory_del(const room::id &room_id,
+                                       const string_view &origin)
+{
+	const auto dit
+	{
+		directories.find(origin)
+	};
+
+	if(dit == end(directories))
+		return;
+
+	auto &dir(dit->second);
+	const auto it
+	{
+		dir.joined.find(room_id)
+	};
+
+	if(it == end(dir.joined))
+		return;
+
+	dir.order.erase(directory_key{it->second, it->first});
+	dir.joined.erase(it);
+	if(dir.joined.empty())
+		directories.erase(dit);
+}
+
+/// Our own rooms are counted from the room itself, since the count in our
+/// summary is only as fresh as the last time it was set. Remote rooms are
+/// taken at their word.
+size_t
+ircd::m::rooms::summary::directory_joined(const room::id &room_id,
+                                          const string_view &origin,
+                                          const event::idx &event_idx)
+{
+	if(my_host(origin) && exists(room_id))
+		return room::members(room_id).count("join");
+
+	size_t ret(0);
+	m::get(std::nothrow, event_idx, "content", [&ret]
+	(const json::object &content)
+	{
+		ret = content.get<size_t>("num_joined_members", 0UL);
+	});
+
+	return ret;
+}
+
+void
+ircd::m::rooms::summary::handle_directory_summary(const m::event &event,
+                                                  m::vm::eval &eval)
+{
+	const auto &[room_id, origin]
+	{
+		unmake_state_key(at<"state_key"_>(event))
+	};
+
+	if(!m::valid(id::ROOM, room_id))
+		return;
+
+	const size_t joined
+	{
+		my_host(origin) && exists(room_id)?
+			room::members(room_id).count("join"):
+			json::get<"content"_>(event).get<size_t>("num_joined_members", 0UL)
+	};
+
+	directory_set(room_id, origin, joined);
+}
+
+void
+ircd::m::rooms::summary::handle_directory_redaction(const m::event &event,
+                                                    m::vm::eval &eval)
+{
+	const auto target_idx
+	{
+		m::index(at<"redacts"_>(event), std::nothrow)
+	};
+
+	char buf[event::STATE_KEY_MAX_SIZE];
+	const string_view &state_key
+	{
+		m::get(std::nothrow, target_idx, "state_key", buf)
+	};
+
+	if(!state_key)
+		return;
+
+	const auto &[room_id, origin]
+	{
+		unmake_state_key(state_key)
+	};
+
+	if(!m::valid(id::ROOM, room_id))
+		return;
+
+	directory_del(room_id, origin);
+}
+
+void
+ircd::m::rooms::summary::handle_directory_member(const m::event &event,
+                                                 m::vm::eval &eval)
+{
+	if(!directories.count(my_host()))
+		return;
+
+	// Only a change to the present state moves the count; the event it
+	// replaced tells whether the member was joined before. The full count is
+	// only taken when the directory is built.
+	if(!eval.sequence || !room::state::present(eval.sequence))
+		return;
+
+	const bool joined
+	{
+		m::membership(event) == "join"
+	};
+
+	const bool was_joined
+	{
+		m::membership(room::state::prev(eval.sequence), "join")
+	};
+
+	if(joined == was_joined)
+		return;
+
+	// The directory is looked up again since the queries above may yield.
+	const auto dit
+	{
+		directories.find(my_host())
+	};
+
+	if(dit == end(directories))
+		return;
+
+	const auto it
+	{
+		dit->second.joined.find(at<"room_id"_>(event))
+	};
+
+	if(it == end(dit->second.joined))
+		return;
+
+	const size_t count
+	{
+		joined?
+			it->second + 1:
+			it->second - std::min(it->second, 1UL)
+	};
+
+	directory_set(at<"room_id"_>(event), my_host(), count);
+}
+
 //
 // internal
 //
@@ -184,3 +184,250 @@ ircd::m::users::opts::opts(const string_view &query)
 	localpart = query;
 	localpart_prefix = true;
 }
+
+//
+// users::directory
+//
+
+decltype(ircd::m::users::directory::enable)
+IRCD_MODULE_EXPORT_DATA
+ircd::m::users::directory::enable
+{
+	{ "name",     "ircd.m.users.directory.enable" },
+	{ "default",  false                           },
+	{ "description",
+
+	R"(
+	Search the user directory index for display names and localparts. When
+	false, searches fall back to a prefix walk of the senders of events. The
+	memberships written before this index existed must first be added with
+	the `users directory rebuild *` command before enabling this. Searches
+	for a hostpart alone (i.e :example.org) always use the prefix walk.
+	)"}
+};
+
+decltype(ircd::m::users::directory::scan_max)
+IRCD_MODULE_EXPORT_DATA
+ircd::m::users::directory::scan_max
+{
+	{ "name",     "ircd.m.users.directory.scan.max" },
+	{ "default",  4096L                             },
+	{ "description",
+
+	R"(
+	Maximum number of index entries visited by a single search. This bounds
+	the cost of very short or very common search terms.
+	)"}
+};
+
+bool
+IRCD_MODULE_EXPORT
+ircd::m::users::directory::for_each(const string_view &term,
+                                    const closure &closure)
+const
+{
+	static const size_t terms_max
+	{
+		8
+	};
+
+	// A term given as an mxid matches the hostpart separately; the tokens
+	// are only taken from the localpart.
+	const auto &[text, host]
+	{
+		has(term, ':')?
+			split(lstrip(term, '@'), ':'):
+			std::make_pair(lstrip(term, '@'), string_view{})
+	};
+
+	char term_buf[terms_max][dbs::USER_DIR_TOKEN_MAX_SIZE];
+	string_view terms[terms_max];
+	size_t terms_count(0);
+	dbs::user_dir_tokens(text, [&term_buf, &terms, &terms_count]
+	(const string_view &token)
+	{
+		terms[terms_count] = string_view
+		{
+			term_buf[terms_count], copy(term_buf[terms_count], token)
+		};
+
+		return ++terms_count < terms_max;
+	});
+
+	if(!terms_count)
+		return true;
+
+	// The longest word is the most selective seek.
+	const auto &seek
+	{
+		*std::max_element(terms, terms + terms_count, []
+		(const string_view &a, const string_view &b)
+		{
+			return size(a) < size(b);
+		})
+	};
+
+	// Every word of the term must prefix some word of the candidate.
+	const auto matches{[&terms, &terms_count]
+	(const id::user &user_id, const string_view &displayname)
+	{
+		bool found[terms_max] {false};
+		dbs::user_dir_tokens(user_id, displayname, [&]
+		(const string_view &token)
+		{
+			for(size_t i(0); i < terms_count; ++i)
+				found[i] |= startswith(token, terms[i]);
+
+			return true;
+		});
+
+		return std::all_of(found, found + terms_count, [](const bool &found)
+		{
+			return found;
+		});
+	}};
+
+	// Results of the visibility test for each room; a room is visible when
+	// the searcher is joined to it or when it is public.
+	std::map<std::string, bool, std::less<>> rooms;
+	const auto visible{[this, &rooms]
+	(const id::room &room_id)
+	{
+		if(!searcher)
+			return true;
+
+		auto it(rooms.lower_bound(room_id));
+		if(it != end(rooms) && it->first == room_id)
+			return it->second;
+
+		const m::room room
+		{
+			room_id
+		};
+
+		const bool ret
+		{
+			m::membership(room, searcher, "join") ||
+			m::join_rule(room, "public") ||
+			rooms::summary::has(room_id)
+		};
+
+		rooms.emplace_hint(it, std::string(room_id), ret);
+		return ret;
+	}};
+
+	char buf[dbs::USER_DIR_KEY_MAX_SIZE];
+	const string_view &key
+	{
+		dbs::user_dir_key(buf, seek)
+	};
+
+	std::set<std::string, std::less<>> seen;
+	size_t scanned(0);
+	auto it
+	{
+		dbs::user_dir.lower_bound(key)
+	};
+
+	for(; it && scanned < size_t(scan_max); ++it, ++scanned)
+	{
+		const auto &[token, user_id, room_id]
+		{
+			dbs::user_dir_key(it->first)
+		};
+
+		if(!startswith(token, seek))
+			break;
+
+		if(!user_id || !room_id)
+			continue;
+
+		if(host && !startswith(user_id.host(), host))
+			continue;
+
+		if(seen.count(user_id))
+			continue;
+
+		const event::idx &event_idx
+		{
+			byte_view<event::idx>(it->second)
+		};
+
+		if(terms_count > 1)
+		{
+			bool match(false);
+			m::get(std::nothrow, event_idx, "content", [&matches, &match, &user_id]
+			(const json::object &content)
+			{
+				const json::string &displayname
+				{
+					content.get("displayname")
+				};
+
+				match = matches(user_id, displayname);
+			});
+
+			if(!match)
+				continue;
+		}
+
+		if(!visible(room_id))
+			continue;
+
+		seen.emplace(user_id);
+		if(!closure(user_id, event_idx))
+			return false;
+	}
+
+	return true;
+}
+
+//
+// users::directory::rebuild
+//
+
+IRCD_MODULE_EXPORT
+ircd::m::users::directory::rebuild::rebuild(const room::id &room_id)
+{
+	db::txn txn
+	{
+		*m::dbs::events
+	};
+
+	size_t count(0);
+	const room::members members
+	{
+		room_id
+	};
+
+	members.for_each("join", [&txn, &count]
+	(const id::user &user_id, const event::idx &event_idx)
+	{
+		const m::event::fetch event
+		{
+			event_idx, std::nothrow
+		};
+
+		if(!event.valid)
+			return true;
+
+		dbs::write_opts opts;
+		opts.event_idx = event_idx;
+		opts.appendix.reset();
+		opts.appendix.set(dbs::appendix::USER_DIR);
+		dbs::write(txn, event, opts);
+		++count;
+		return true;
+	});
+
+	log::info
+	{
+		log, "users::directory::rebuild %s complete members:%zu transaction elems:%zu size:%s",
+		string_view{room_id},
+		count,
+		txn.size(),
+		pretty(iec(txn.bytes()))
+	};
+
+	txn();
+}
@@ -37,6 +37,8 @@ namespace ircd::m::vm
 	extern conf::item<bool> log_commit_debug;
 	extern conf::item<bool> log_accept_debug;
 	extern conf::item<bool> log_accept_info;
+	extern conf::item<bool> inject_trusted;
+	extern stats::histogram execute_pdu_latency;
 }
 
 ircd::mapi::header
@@ -46,6 +48,13 @@ IRCD_MODULE
 	ircd::m::vm::init, ircd::m::vm::fini
 };
 
+/// Duration of execute_pdu() in microseconds, including its waits.
+decltype(ircd::m::vm::execute_pdu_latency)
+ircd::m::vm::execute_pdu_latency
+{
+	{ "name", "ircd.m.vm.execute.pdu.usec" },
+};
+
 decltype(ircd::m::vm::log_commit_debug)
 ircd::m::vm::log_commit_debug
 {
@@ -67,6 +76,18 @@ ircd::m::vm::log_accept_info
 	{ "default",  false                       },
 };
 
+decltype(ircd::m::vm::inject_trusted)
+ircd::m::vm::inject_trusted
+{
+	{ "name",     "ircd.m.vm.inject.trusted" },
+	{ "default",  true                       },
+	{
+		"description",
+		"Events composed entirely by this server bypass re-verification of"
+		" the signature, event_id and references it has just generated."
+	},
+};
+
 decltype(ircd::m::vm::issue_hook)
 ircd::m::vm::issue_hook
 {
@@ -468,6 +489,19 @@ ircd::m::vm::inject(eval &eval,
 		}
 	};
 
+	// When this server generates every reference, hash and signature of the
+	// event the later stages can skip re-deriving them. Properties supplied
+	// by the caller (i.e. from a make_join proto) are not trusted this way.
+	const scope_restore eval_trusted
+	{
+		eval.trusted,
+		bool(inject_trusted)
+		&& (is_room_create || (add_prev_events && add_auth_events))
+		&& opts.prop_mask.has("event_id") && !event.has("event_id")
+		&& opts.prop_mask.has("hashes") && !event.has("hashes")
+		&& opts.prop_mask.has("signatures") && !event.has("signatures")
+	};
+
 	return eval.room_version == "1" || eval.room_version == "2"?
 		inject1(eval, event, contents):
 		inject3(eval, event, contents);
@@ -845,6 +879,19 @@ enum ircd::m::vm::fault
 ircd::m::vm::execute_pdu(eval &eval,
                          const event &event)
 {
+	const ircd::timer timer;
+	vm::timing timing;
+	const unwind record_latency{[&timer, &timing, &event]
+	{
+		const auto elapsed
+		{
+			timer.at<microseconds>()
+		};
+
+		execute_pdu_latency(elapsed.count());
+		timing.commit(event, elapsed);
+	}};
+
 	const scope_count pending
 	{
 		sequence::pending
@@ -899,6 +946,8 @@ ircd::m::vm::execute_pdu(eval &eval,
 		call_hook(conform_hook, eval, event, eval);
 	}
 
+	timing(stage::CONFORM);
+
 	if(unlikely(internal && !my(event)))
 		throw error
 		{
@@ -920,20 +969,30 @@ ircd::m::vm::execute_pdu(eval &eval,
 	if(likely(opts.access))
 		call_hook(access_hook, eval, event, eval);
 
-	if(likely(opts.verify) && !verify(event))
+	timing(stage::ACCESS);
+
+	// The signature of a trusted issue was made moments ago by inject().
+	if(likely(opts.verify) && !eval.trusted && !verify(event))
 		throw m::BAD_SIGNATURE
 		{
 			"Signature verification failed"
 		};
 
-	// Fetch dependencies
-	if(likely(opts.fetch))
+	timing(stage::VERIFY);
+
+	// Fetch dependencies. The references of a trusted issue were all
+	// generated from local state.
+	if(likely(opts.fetch) && !eval.trusted)
 		call_hook(fetch_hook, eval, event, eval);
 
+	timing(stage::FETCH);
+
 	// Evaluation by auth system; throws
 	if(likely(authenticate))
 		room::auth::check_static(event);
 
+	timing(stage::AUTH_STATIC);
+
 	// Obtain sequence number here.
 	const auto *const &top(eval::seqmax());
 	eval.sequence_shared[0] = 0;
@@ -957,9 +1016,16 @@ ircd::m::vm::execute_pdu(eval &eval,
 		return eval::seqnext(sequence::uncommitted) == &eval;
 	});
 
-	if(likely(authenticate))
+	timing(stage::SEQUENCE);
+
+	// The auth_events of a trusted issue were generated by the same state
+	// queries which would be repeated here; check_static() has already
+	// evaluated against them and check_present() covers any change since.
+	if(likely(authenticate) && !eval.trusted)
 		room::auth::check_relative(event);
 
+	timing(stage::AUTH_RELATIVE);
+
 	log::debug
 	{
 		log, "%s | event committing", loghead(eval)
@@ -978,14 +1044,20 @@ ircd::m::vm::execute_pdu(eval &eval,
 		return eval::seqnext(sequence::committed) == &eval;
 	});
 
+	timing(stage::COMMITTING);
+
 	// Reevaluation of auth against the present state of the room.
 	if(likely(authenticate))
 		room::auth::check_present(event);
 
+	timing(stage::AUTH_PRESENT);
+
 	// Evaluation by module hooks
 	if(likely(opts.eval))
 		call_hook(eval_hook, eval, event, eval);
 
+	timing(stage::EVAL);
+
 	log::debug
 	{
 		log, "%s | event committed", loghead(eval)
@@ -998,18 +1070,26 @@ ircd::m::vm::execute_pdu(eval &eval,
 	if(likely(opts.write))
 		write_prepare(eval, event);
 
+	timing(stage::WRITE_PREPARE);
+
 	if(likely(opts.write))
 		write_append(eval, event);
 
+	timing(stage::WRITE_APPEND);
+
 	// Generate post-eval/pre-notify effects. This function may conduct
 	// an entire eval of several more events recursively before returning.
 	if(likely(opts.post))
 		call_hook(post_hook, eval, event, eval);
 
+	timing(stage::POST);
+
 	// Commit the transaction to database iff this eval is at the stack base.
 	if(likely(opts.write) && !eval.sequence_shared[0])
 		write_commit(eval);
 
+	timing(stage::WRITE_COMMIT);
+
 	// Wait for sequencing only if this is the stack base, otherwise we'll
 	// never return back to that stack base.
 	if(likely(!eval.sequence_shared[0]))
@@ -1031,6 +1111,8 @@ ircd::m::vm::execute_pdu(eval &eval,
 		sequence::retired = std::max(eval.sequence_shared[1], sequence::get(eval));
 	}
 
+	timing(stage::RETIRE);
+
 	return fault::ACCEPT;
 }
 
@@ -1141,6 +1223,7 @@ ircd::m::vm::write_append(eval &eval,
 
 			wopts.appendix.set(dbs::appendix::ROOM_STATE, pass);
 			wopts.appendix.set(dbs::appendix::ROOM_JOINED, pass);
+			wopts.appendix.set(dbs::appendix::USER_DIR, pass);
 		}
 	}
 
@@ -35,41 +35,239 @@ stats_get
 	stats_resource, "GET", get__stats
 };
 
+/// Appends lines to the chunked response buffer, flushing a chunk to the
+/// client whenever the next line might not fit.
+struct metrics_writer
+{
+	static constexpr const size_t LINE_MAX {512};
+
+	resource::response::chunked &response;
+	mutable_buffer buf;
+	char line[LINE_MAX];
+	std::set<std::string, std::less<>> names;   // metric names written
+
+	template<class... args>
+	void operator()(const string_view &fmt, args&&... a);
+	void flush();
+
+	metrics_writer(resource::response::chunked &response)
+	:response{response}
+	,buf{response.buf}
+	{}
+};
+
+template<class... args>
+void
+metrics_writer::operator()(const string_view &fmt,
+                   args&&... a)
+{
+	const string_view str
+	{
+		fmt::sprintf
+		{
+			line, fmt, std::forward<args>(a)...
+		}
+	};
+
+	if(size(buf) < size(str))
+		flush();
+
+	consume(buf, copy(buf, str));
+}
+
+void
+metrics_writer::flush()
+{
+	const const_buffer chunk
+	{
+		data(response.buf), data(buf)
+	};
+
+	if(!empty(chunk))
+		response.flush(chunk);
+
+	buf = response.buf;
+}
+
+/// Prometheus metric names are restricted to [a-zA-Z0-9_:]. Distinct stats
+/// names can map to the same metric name; each after the first written is
+/// given a numeric suffix so the series remain distinct.
+static string_view
+metric_name(metrics_writer &out,
+            const mutable_buffer &buf,
+            const string_view &name)
+{
+	static const size_t suffix_max
+	{
+		8
+	};
+
+	assert(size(buf) > suffix_max);
+	const auto len
+	{
+		std::min(size(buf) - suffix_max, size(name))
+	};
+
+	for(size_t i(0); i < len; ++i)
+	{
+		const auto c(static_cast<unsigned char>(name[i]));
+		buf[i] = std::isalnum(c) || c == ':'? c : '_';
+	}
+
+	string_view ret
+	{
+		data(buf), len
+	};
+
+	for(size_t i(2); out.names.count(ret); ++i)
+	{
+		const string_view suffix
+		{
+			fmt::sprintf
+			{
+				mutable_buffer{data(buf) + len, suffix_max}, "_%zu", i
+			}
+		};
+
+		ret = string_view
+		{
+			data(buf), len + size(suffix)
+		};
+	}
+
+	out.names.emplace(ret);
+	return ret;
+}
+
+// Each writer copies what it needs from the stat before its first line; any
+// line may flush and yield, during which the stat's module can be unloaded.
+
+static void
+write_item(metrics_writer &out,
+           const stats::item &item)
+{
+	char buf[256];
+	const auto name
+	{
+		metric_name(out, buf, item.name)
+	};
+
+	const long long val
+	{
+		item.val
+	};
+
+	out("# TYPE %s untyped\n", name);
+	out("%s %lld\n", name, val);
+}
+
+static void
+write_summary(metrics_writer &out,
+              const stats::histogram &hist)
+{
+	char buf[256];
+	const auto name
+	{
+		metric_name(out, buf, hist.name)
+	};
+
+	static const double quantiles[]
+	{
+		0.5, 0.9, 0.99, 0.999
+	};
+
+	uint64_t value[std::size(quantiles)];
+	for(size_t i(0); i < std::size(quantiles); ++i)
+		value[i] = hist.quantile(quantiles[i]);
+
+	const uint64_t sum(hist.sum), count(hist.count);
+	out("# TYPE %s summary\n", name);
+	for(size_t i(0); i < std::size(quantiles); ++i)
+		out("%s{quantile=\"%g\"} %lu\n", name, quantiles[i], value[i]);
+
+	out("%s_sum %lu\n", name, sum);
+	out("%s_count %lu\n", name, count);
+}
+
+static void
+write_histogram(metrics_writer &out,
+                const stats::histogram &hist)
+{
+	char buf[256];
+	const auto name
+	{
+		metric_name(out, buf, hist.name)
+	};
+
+	const auto bucket(hist.bucket);
+	const uint64_t sum(hist.sum), count(hist.count);
+
+	// Only the occupied buckets are listed; the le bounds of log-linear
+	// buckets are fixed so they remain comparable between scrapes.
+	uint64_t accum(0);
+	out("# TYPE %s histogram\n", name);
+	for(size_t i(0); i < bucket.size() - 1; ++i)
+		if(bucket[i])
+			out("%s_bucket{le=\"%lu\"} %lu\n", name, stats::histogram::upper(i), accum += bucket[i]);
+
+	out("%s_bucket{le=\"+Inf\"} %lu\n", name, count);
+	out("%s_sum %lu\n", name, sum);
+	out("%s_count %lu\n", name, count);
+}
+
 resource::response
 get__stats(client &client,
            const resource::request &request)
 {
-	static const size_t buf_max
+	resource::response::chunked response
 	{
-		4096
+		client, http::OK, "text/plain; version=0.0.4"
 	};
 
-	char buf[buf_max];
-	std::stringstream out;
-	pubsetbuf(out, buf);
+	metrics_writer out
+	{
+		response
+	};
 
 	const time_t ts
 	{
 		ircd::time<milliseconds>()
 	};
 
-	out << "aio_requests_total"
-	    << ' ' << fs::aio::stats.requests
-	    << ' ' << ts
-	    << '\n';
+	out("aio_requests_total %lu %ld\n", fs::aio::stats.requests, ts);
+	out("aio_requests_bytes_total %lu %ld\n", fs::aio::stats.bytes_requests, ts);
 
-	out << "aio_requests_bytes_total"
-	    << ' ' << fs::aio::stats.bytes_requests
-	    << ' ' << ts
-	    << '\n';
+	// Flushing yields and a module unload meanwhile would invalidate any
+	// iterator or pointer; only the names are kept across flushes and each
+	// is found again before it's written.
+	std::vector<std::string> names;
+	names.reserve(stats::items.size());
+	for(const auto &[name, item] : stats::items)
+		names.emplace_back(name);
 
-	const string_view output
+	for(const auto &name : names)
 	{
-		view(out, buf)
-	};
+		const auto it(stats::items.find(name));
+		if(it != end(stats::items))
+			write_item(out, *it->second);
+	}
+
+	names.clear();
+	for(const auto &[name, hist] : stats::histograms)
+		names.emplace_back(name);
 
-	return resource::response
+	for(const auto &name : names)
 	{
-		client, output, "text/plain", http::OK
-	};
+		const auto it(stats::histograms.find(name));
+		if(it == end(stats::histograms))
+			continue;
+
+		if(it->second->summary)
+			write_summary(out, *it->second);
+		else
+			write_histogram(out, *it->second);
+	}
+
+	out.flush();
+	return std::move(response);
 }